@@ -0,0 +1,86 @@
+// Throughput of message escaping with each kernel, on payloads resembling real log messages
+//
+// Usage: escape_bench [megabytes per run]
+#include <toolboxcpp/util/Escape.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace toolboxcpp::util;
+
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Payload
+    {
+        char const*     name;
+        std::string     text;
+    };
+
+    std::vector<Payload> payloads()
+    {
+        std::vector<Payload> result;
+        result.push_back(Payload { "short plain line",
+            "Connection 42 accepted from 10.0.0.17:53122, handing over to worker 3" });
+
+        std::string plain;
+        while(plain.size() < 1024)
+            plain += "request id=8f14e45f path=/api/v2/items/1729 status=200 bytes=5120 elapsed=0.0031 ";
+        result.push_back(Payload { "1K plain text", plain });
+
+        std::string user;
+        while(user.size() < 1024)
+            user += "{\"name\": \"O'Brien\", \"comment\": \"said \\\"fine\\\"\", \"tags\": [\"a\", \"b\"]} ";
+        result.push_back(Payload { "1K user JSON", user });
+
+        std::string trace = "Unhandled exception: std::runtime_error: connection reset\n";
+        for(int i = 0; i < 24; ++i)
+            trace += "\tat worker::Session::handle(worker::Request const&) (session.cpp:" + std::to_string(100 + i) + ")\n";
+        result.push_back(Payload { "stack trace", trace });
+        return result;
+    }
+
+    double measure(escape::Mode mode, std::string const& text, std::size_t total)
+    {
+        std::string out;
+        out.reserve(text.size() * 6);
+        std::size_t rounds = total / text.size() + 1;
+        auto start = Clock::now();
+        for(std::size_t i = 0; i < rounds; ++i)
+        {
+            out.clear();
+            escape::append(mode, text.data(), text.size(), out);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return static_cast<double>(rounds * text.size()) / seconds / (1 << 20);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t megabytes = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 256;
+    std::size_t total = megabytes << 20;
+    escape::Kernel best = escape::best_kernel();
+
+    for(auto& payload : bench::payloads())
+        for(escape::Mode mode : { escape::Mode::Json, escape::Mode::Line })
+        {
+            std::printf("%-18s %-4s", payload.name, mode == escape::Mode::Json ? "json" : "line");
+            for(escape::Kernel kernel : { escape::Kernel::Scalar, escape::Kernel::Sse2, escape::Kernel::Avx2 })
+            {
+                if(escape::set_kernel(kernel) != kernel)
+                {
+                    std::printf("  %6s       n/a", escape::kernel_name(kernel));
+                    continue;
+                }
+                std::printf("  %6s %6.0f MB/s", escape::kernel_name(kernel), bench::measure(mode, payload.text, total));
+            }
+            std::printf("\n");
+        }
+    escape::set_kernel(best);
+    return 0;
+}
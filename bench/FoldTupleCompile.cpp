@@ -0,0 +1,87 @@
+/*
+    Compile-time benchmark of fold_tuple, see fold_tuple_compile.sh
+    TUPLE_SIZE sets number of tuple elements; FOLD_RECURSIVE selects recursive Folder instead of flat fold,
+    FOLD_HAND selects hand-written pack expansion, which is the lower bound for both.
+    Tuple is folded with FOLDS distinct functors, so cost of fold itself outweighs cost of tuple type
+*/
+#include <toolboxcpp/util/FoldTuple.hpp>
+
+#include <cstddef>
+#include <ostream>
+#include <tuple>
+
+#ifndef TUPLE_SIZE
+#   define TUPLE_SIZE 16
+#endif
+
+#ifndef FOLDS
+#   define FOLDS 16
+#endif
+
+using namespace toolboxcpp::util;
+
+namespace bench
+{
+    // Distinct type per element, like arguments of formatter
+    template<std::size_t I>
+    struct Elem
+    {
+        int value;
+    };
+
+    template<std::size_t I>
+    std::ostream& operator << (std::ostream& ost, Elem<I> const& elem)
+    {
+        return ost << elem.value;
+    }
+    // Distinct functor per fold, so each fold is instantiated anew
+    template<std::size_t K>
+    struct Print
+    {
+        template<typename T>
+        std::ostream& operator()(std::ostream& ost, T const& value) const
+        {
+            return ost << value;
+        }
+    };
+
+    template<typename Is> struct TupleOf;
+
+    template<std::size_t... Is>
+    struct TupleOf<impl::Indices<Is...>>
+    {
+        using type = std::tuple<Elem<Is>...>;
+    };
+
+    using Tuple = TupleOf<impl::MakeIndices<TUPLE_SIZE>::type>::type;
+
+    template<std::size_t K, std::size_t... Is>
+    std::ostream& print_hand(std::ostream& ost, Tuple const& tuple, impl::Indices<Is...>)
+    {
+        (void)impl::Swallow { 0, (Print<K>()(ost, std::get<Is>(tuple)), 0)... };
+        return ost;
+    }
+
+    template<std::size_t K>
+    std::ostream& print(std::ostream& ost, Tuple const& tuple)
+    {
+#if defined(FOLD_RECURSIVE)
+        return impl::Folder<0, TUPLE_SIZE>::apply(tuple, ost, Print<K>());
+#elif defined(FOLD_HAND)
+        return print_hand<K>(ost, tuple, impl::MakeIndices<TUPLE_SIZE>::type());
+#else
+        return fold_tuple(tuple, ost, Print<K>());
+#endif
+    }
+
+    template<std::size_t... Ks>
+    void print_all(std::ostream& ost, Tuple const& tuple, impl::Indices<Ks...>)
+    {
+        (void)impl::Swallow { 0, (print<Ks>(ost, tuple), 0)... };
+    }
+}
+
+void print(std::ostream& ost, bench::Tuple const& tuple)
+{
+    bench::print_all(ost, tuple, impl::MakeIndices<FOLDS>::type());
+}
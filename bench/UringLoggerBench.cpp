@@ -0,0 +1,105 @@
+// Per-record write latency of UringLogger against FileLogger, as seen by the calling thread
+//
+// Usage: uring_logger_bench [directory] [records per thread]
+#include <toolboxcpp/log/Sinks.hpp>
+#include <toolboxcpp/log/UringLogger.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace toolboxcpp::log;
+
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct LockedFileLogger
+    {
+        FileLogger  logger;
+        std::mutex  mutex;
+
+        void write(Record const& record, WriterFunc writer)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            logger.write(record, writer);
+        }
+    };
+
+    template<typename L>
+    std::vector<std::uint64_t> measure(L& logger, int threads, int records)
+    {
+        std::vector<std::vector<std::uint64_t>> samples(threads);
+        std::vector<std::thread> workers;
+        for(int t = 0; t < threads; ++t)
+            workers.emplace_back([&, t] {
+                auto& out = samples[t];
+                out.reserve(records);
+                Record record {};
+                for(int i = 0; i < records; ++i)
+                {
+                    auto start = Clock::now();
+                    logger.write(record, [&](std::ostream& ost) { ost << "thread " << t << " record " << i << " some payload text"; });
+                    out.push_back(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+                }
+            });
+        for(auto& worker : workers)
+            worker.join();
+
+        std::vector<std::uint64_t> all;
+        for(auto& part : samples)
+            all.insert(all.end(), part.begin(), part.end());
+        std::sort(all.begin(), all.end());
+        return all;
+    }
+
+    void report(char const* name, int threads, std::vector<std::uint64_t> const& sorted)
+    {
+        auto at = [&](double q) { return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(q * sorted.size()))]; };
+        std::printf("%-24s %2d thr  p50 %7llu ns  p99 %7llu ns  p99.9 %8llu ns  max %9llu ns\n", name, threads,
+            (unsigned long long)at(0.5), (unsigned long long)at(0.99), (unsigned long long)at(0.999), (unsigned long long)sorted.back());
+    }
+
+    template<typename Make>
+    void run(char const* name, std::string const& path, int records, Make make)
+    {
+        for(int threads : { 1, 4 })
+        {
+            std::remove(path.c_str());
+            auto logger = make();
+            report(name, threads, measure(*logger, threads, records));
+        }
+        std::remove(path.c_str());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string dir = argc > 1 ? argv[1] : "/tmp";
+    int records     = argc > 2 ? std::atoi(argv[2]) : 200000;
+    std::string path = dir + "/uring_logger_bench.log";
+
+    bench::run("FileLogger flush each", path, records, [&] {
+        return std::unique_ptr<bench::LockedFileLogger>(new bench::LockedFileLogger { FileLogger(path.c_str(), false, true), {} });
+    });
+    bench::run("FileLogger buffered", path, records, [&] {
+        return std::unique_ptr<bench::LockedFileLogger>(new bench::LockedFileLogger { FileLogger(path.c_str(), false, false), {} });
+    });
+    bench::run("UringLogger", path, records, [&] {
+        uring::Options options;
+        options.truncate = true;
+        return std::unique_ptr<UringLogger>(new UringLogger(path, options));
+    });
+    bench::run("UringLogger pwrite", path, records, [&] {
+        uring::Options options;
+        options.truncate    = true;
+        options.force_posix = true;
+        return std::unique_ptr<UringLogger>(new UringLogger(path, options));
+    });
+    return 0;
+}
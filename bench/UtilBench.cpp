@@ -0,0 +1,157 @@
+// Cost of util primitives against what they wrap: FuncRef against function pointer and std::function,
+// Resource against raw handle, fold_tuple against hand-written expansion
+//
+// Usage: util_bench [millions of iterations]
+#include <toolboxcpp/util/FoldTuple.hpp>
+#include <toolboxcpp/util/FuncRef.hpp>
+#include <toolboxcpp/util/Resource.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace toolboxcpp::util;
+
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+    // Hides value from optimizer, so calls aren't devirtualized and loops aren't folded
+    template<typename T>
+    void opaque(T& value)
+    {
+        asm volatile("" : "+m"(value) : : "memory");
+    }
+
+    int g_released = 0;
+
+    struct Release
+    {
+        static int zero() noexcept { return -1; }
+        void operator()(int handle) const noexcept { g_released += handle & 1; }
+    };
+
+    using Handle = Resource<int, Release>;
+
+    struct Sum
+    {
+        template<typename T>
+        long operator()(long acc, T value) const { return acc + static_cast<long>(value); }
+    };
+
+    using Tuple = std::tuple<int, long, short, unsigned, int, long, short, unsigned>;
+
+    __attribute__((noinline)) int triple(int value) { return value * 3 + 1; }
+
+    template<typename Fn>
+    double measure(std::size_t iterations, Fn&& body)
+    {
+        auto start = Clock::now();
+        for(std::size_t i = 0; i < iterations; ++i)
+            body(i);
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(iterations);
+    }
+
+    void report(const char* name, double wrapped, const char* baseline_name, double baseline)
+    {
+        std::printf("%-26s %7.2f ns   %-22s %7.2f ns   x%.2f\n", name, wrapped, baseline_name, baseline, wrapped / baseline);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace bench;
+
+    std::size_t iterations = (argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 100) * 1000000;
+    int sink = 0;
+    // Indirect calls, target unknown to optimizer
+    {
+        int (*pointer)(int) = &triple;
+        FuncRef<int (int)> ref(&triple);
+        auto lambda = [](int value) { return value * 3 + 1; };
+        FuncRef<int (int)> lambda_ref(lambda);
+        std::function<int (int)> function(lambda);
+        opaque(pointer);
+        opaque(ref);
+        opaque(lambda_ref);
+        opaque(function);
+
+        double raw  = measure(iterations, [&](std::size_t i) { sink += pointer(static_cast<int>(i)); });
+        report("FuncRef(function)", measure(iterations, [&](std::size_t i) { sink += ref(static_cast<int>(i)); }),
+               "function pointer", raw);
+        report("FuncRef(lambda)", measure(iterations, [&](std::size_t i) { sink += lambda_ref(static_cast<int>(i)); }),
+               "function pointer", raw);
+        report("std::function(lambda)", measure(iterations, [&](std::size_t i) { sink += function(static_cast<int>(i)); }),
+               "function pointer", raw);
+    }
+    // Calls which optimizer may inline
+    {
+        auto lambda = [](int value) { return value * 3 + 1; };
+        double direct = measure(iterations, [&](std::size_t i) { int v = static_cast<int>(i); opaque(v); sink += lambda(v); });
+        report("FuncRef(lambda), local", measure(iterations, [&](std::size_t i) {
+            int v = static_cast<int>(i);
+            opaque(v);
+            sink += FuncRef<int (int)>(lambda)(v);
+        }), "direct lambda call", direct);
+    }
+    // Handle lifetime
+    {
+        std::vector<int>    raw(1024);
+        std::vector<Handle> wrapped(1024);
+        for(std::size_t i = 0; i < raw.size(); ++i)
+        {
+            raw[i] = static_cast<int>(i);
+            wrapped[i].reset(static_cast<int>(i));
+        }
+        auto mask = raw.size() - 1;
+
+        double raw_move = measure(iterations, [&](std::size_t i) {
+            int& left  = raw[i & mask];
+            int& right = raw[(i + 1) & mask];
+            if(left != -1)
+                g_released += left & 1;
+            left  = right;
+            right = static_cast<int>(i);
+        });
+        report("Resource move", measure(iterations, [&](std::size_t i) {
+            wrapped[i & mask] = std::move(wrapped[(i + 1) & mask]);
+            wrapped[(i + 1) & mask].reset(static_cast<int>(i));
+        }), "raw handle move", raw_move);
+
+        double raw_swap = measure(iterations, [&](std::size_t i) { std::swap(raw[i & mask], raw[(i + 7) & mask]); });
+        report("Resource swap", measure(iterations, [&](std::size_t i) { wrapped[i & mask].swap(wrapped[(i + 7) & mask]); }),
+               "raw handle swap", raw_swap);
+
+        double raw_destroy = measure(iterations, [&](std::size_t i) {
+            int handle = static_cast<int>(i);
+            opaque(handle);
+            if(handle != -1)
+                g_released += handle & 1;
+        });
+        report("Resource destroy", measure(iterations, [&](std::size_t i) {
+            int handle = static_cast<int>(i);
+            opaque(handle);
+            Handle resource(handle);
+        }), "raw handle release", raw_destroy);
+    }
+    // Tuple folding
+    {
+        Tuple tuple(1, 2, 3, 4, 5, 6, 7, 8);
+        long total = 0;
+        double hand = measure(iterations, [&](std::size_t) {
+            opaque(tuple);
+            total += std::get<0>(tuple) + std::get<1>(tuple) + std::get<2>(tuple) + static_cast<long>(std::get<3>(tuple))
+                   + std::get<4>(tuple) + std::get<5>(tuple) + std::get<6>(tuple) + static_cast<long>(std::get<7>(tuple));
+        });
+        report("fold_tuple, 8 elements", measure(iterations, [&](std::size_t) {
+            opaque(tuple);
+            total += fold_tuple(tuple, 0L, Sum());
+        }), "hand-written sum", hand);
+        sink += static_cast<int>(total);
+    }
+    std::printf("(checksum %d)\n", sink + g_released);
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+    Codegen probes for util primitives, see util_codegen_check.sh
+
+    Each `codegen_*` function is compiled on its own and its instructions are counted;
+    counts are checked against util_codegen_budget.txt. Wrapped and raw variants of the same
+    operation sit side by side, so budget of wrapped one is set to what raw one takes.
+    Layout properties which don't need disassembly are checked right here, at compile time.
+*/
+#include <toolboxcpp/util/FoldTuple.hpp>
+#include <toolboxcpp/util/FuncRef.hpp>
+#include <toolboxcpp/util/Resource.hpp>
+
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <unistd.h>
+
+using namespace toolboxcpp::util;
+
+namespace bench
+{
+    struct CloseFd
+    {
+        static int zero() noexcept { return -1; }
+        void operator()(int fd) const noexcept { ::close(fd); }
+    };
+
+    using Fd     = Resource<int, CloseFd>;
+    using IntRef = FuncRef<int (int)>;
+    using Tuple  = std::tuple<int, long, short, unsigned>;
+
+    struct Sum
+    {
+        template<typename T>
+        long operator()(long acc, T value) const { return acc + static_cast<long>(value); }
+    };
+}
+
+static_assert(sizeof(bench::Fd) == sizeof(int), "Resource with stateless deleter should be as large as its handle");
+static_assert(std::is_nothrow_move_constructible<bench::Fd>::value, "Resource move should be noexcept");
+static_assert(sizeof(bench::IntRef) == 2 * sizeof(void*), "FuncRef should be context and caller pointers only");
+static_assert(std::is_trivially_copyable<bench::IntRef>::value, "FuncRef should be passed in registers");
+
+extern "C"
+{
+    // Indirect calls
+    int codegen_raw_call(int (*func)(int), int value)                       { return func(value); }
+    int codegen_funcref_call(bench::IntRef func, int value)                 { return func(value); }
+    int codegen_std_function_call(std::function<int (int)> const& func, int value) { return func(value); }
+    // Calls which compiler sees through
+    int codegen_raw_inline(int value)
+    {
+        return value * 3 + 1;
+    }
+
+    int codegen_funcref_inline(int value)
+    {
+        auto func = [](int v) { return v * 3 + 1; };
+        return bench::IntRef(func)(value);
+    }
+    // Handle lifetime
+    void codegen_raw_destroy(int fd)
+    {
+        if(fd != -1)
+            ::close(fd);
+    }
+
+    void codegen_resource_destroy(int fd)
+    {
+        bench::Fd resource(fd);
+    }
+
+    void codegen_raw_move(int& left, int& right)
+    {
+        int old = left;
+        left  = right;
+        right = -1;
+        if(old != -1)
+            ::close(old);
+    }
+
+    void codegen_resource_move(bench::Fd& left, bench::Fd& right)
+    {
+        left = std::move(right);
+    }
+
+    void codegen_raw_swap(int& left, int& right)
+    {
+        std::swap(left, right);
+    }
+
+    void codegen_resource_swap(bench::Fd& left, bench::Fd& right)
+    {
+        left.swap(right);
+    }
+    // Tuple folding
+    long codegen_raw_fold(bench::Tuple const& tuple)
+    {
+        return std::get<0>(tuple) + std::get<1>(tuple) + std::get<2>(tuple) + static_cast<long>(std::get<3>(tuple));
+    }
+
+    long codegen_fold_tuple(bench::Tuple const& tuple)
+    {
+        return fold_tuple(tuple, 0L, bench::Sum());
+    }
+}
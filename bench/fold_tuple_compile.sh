@@ -0,0 +1,36 @@
+#!/bin/sh
+# Measures compile time and object size of fold_tuple over tuples of 1..64 elements,
+# flat implementation against recursive Folder and hand-written expansion.
+# Each build is repeated, and the fastest run is reported, to cut scheduling noise
+#
+# Usage: fold_tuple_compile.sh <compiler> <include dir> <output dir> [compiler flags...]
+set -e
+
+CXX="$1"
+INCLUDE="$2"
+OUT="$3"
+shift 3
+SOURCE="$(dirname "$0")/FoldTupleCompile.cpp"
+RUNS=3
+
+mkdir -p "$OUT"
+printf '%6s  %-9s  %10s  %10s\n' size variant time_ms object_b
+for size in 1 2 4 8 16 32 64; do
+    for variant in flat recursive hand; do
+        define=""
+        [ "$variant" = recursive ] && define="-DFOLD_RECURSIVE"
+        [ "$variant" = hand ]      && define="-DFOLD_HAND"
+        object="$OUT/fold_tuple_${variant}_${size}.o"
+        best=""
+        run=0
+        while [ $run -lt $RUNS ]; do
+            start=$(date +%s%N)
+            "$CXX" -std=c++11 "$@" -I"$INCLUDE" -DTUPLE_SIZE=$size $define -c "$SOURCE" -o "$object"
+            end=$(date +%s%N)
+            elapsed=$(( (end - start) / 1000000 ))
+            if [ -z "$best" ] || [ $elapsed -lt $best ]; then best=$elapsed; fi
+            run=$(( run + 1 ))
+        done
+        printf '%6d  %-9s  %10d  %10d\n' $size $variant $best $(wc -c < "$object")
+    done
+done
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Compiles codegen probes of util primitives and checks their instruction counts
+# and object's code size against budget; fails if anything is over budget
+#
+# Usage: util_codegen_check.sh <compiler> <include dir> <output dir> <budget file> [compiler flags...]
+set -e
+
+CXX="$1"
+INCLUDE="$2"
+OUT="$3"
+BUDGET="$4"
+shift 4
+SOURCE="$(dirname "$0")/UtilCodegen.cpp"
+OBJECT="$OUT/util_codegen.o"
+
+mkdir -p "$OUT"
+"$CXX" -std=c++11 "$@" -I"$INCLUDE" -c "$SOURCE" -o "$OBJECT"
+
+if ! command -v objdump > /dev/null 2>&1 || ! command -v size > /dev/null 2>&1; then
+    echo "objdump or size not found, codegen check skipped"
+    exit 0
+fi
+# Instructions per probe, padding excluded
+objdump -d --no-show-raw-insn "$OBJECT" | awk '
+    /^[0-9a-f]+ <.*>:$/     { name = substr($2, 2, length($2) - 3); next }
+    /^ +[0-9a-f]+:\t/       { if(name ~ /^codegen_/ && $0 !~ /\t(nop|xchg +%ax,%ax|data16|cs nop)/) count[name]++ }
+    END                     { for(n in count) print n, count[n] }
+' > "$OUT/util_codegen.counts"
+size -A "$OBJECT" | awk '$1 == ".text" { print ".text", $2 }' >> "$OUT/util_codegen.counts"
+
+awk '
+    NR == FNR               { actual[$1] = $2; next }
+    /^#/ || NF < 2          { next }
+    {
+        value = ($1 in actual) ? actual[$1] : "missing"
+        status = value == "missing" || value + 0 > $2 + 0 ? "OVER" : "ok"
+        printf "%-28s %8s  budget %6d  %s\n", $1, value, $2, status
+        if(status != "ok")
+            failed = 1
+    }
+    END                     { exit failed }
+' "$OUT/util_codegen.counts" "$BUDGET" || { echo "Codegen of util primitives is over budget"; exit 1; }
@@ -0,0 +1,238 @@
+#pragma once
+/** Sink which turns numeric log records into periodic histogram summaries
+ *
+ *  Lines like "op X took N us", which are only ever turned into percentiles, are consumed
+ *  by @ref HistogramLogger: value of each record is added to histogram of its callsite
+ *  or channel, and only one summary record per histogram and interval reaches wrapped logger.
+ */
+#include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/util/Executor.hpp>
+#include <toolboxcpp/util/Histogram.hpp>
+#include <toolboxcpp/util/Slab.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace histogram
+{
+    /** How records are grouped into histograms
+     */
+    enum class GroupBy
+    {
+        Site,       ///< By callsite; records without site are grouped by channel
+        Channel,    ///< By channel
+    };
+    /** Extracts value from formatted message
+     *  @param  meta    Record metadata
+     *  @param  text    Message text, not null-terminated
+     *  @param  size    Message size
+     *  @param  value   Receives extracted value
+     *  @return         false if message carries no value
+     */
+    using Extractor = std::function<bool (Metadata const& meta, char const* text, std::size_t size, std::uint64_t& value)>;
+    /** Extractor which takes the last unsigned decimal number from message
+     */
+    Extractor last_number();
+    /** Aggregation options
+     */
+    struct Options
+    {
+        GroupBy                     group_by            = GroupBy::Site;
+        /// Used for records where value isn't marked with @ref metric
+        Extractor                   extractor           = last_number();
+        /// Period of summaries
+        std::chrono::milliseconds   interval            = std::chrono::milliseconds(10000);
+        /// Severity of summary records
+        Severity                    summary_severity    = Severity::Info;
+        /// Percentiles listed in summary
+        std::vector<double>         percentiles         = { 0.5, 0.9, 0.99, 0.999 };
+        /// Whether records without value are passed to wrapped logger as is
+        bool                        pass_through        = true;
+    };
+    /** Values of one histogram accumulated over single interval
+     */
+    struct Summary
+    {
+        SiteId              site;       ///< 0 when grouped by channel
+        Channel             channel;
+        util::Histogram     values;
+    };
+    /** Writes summary text, like `net.cpp:42 count=10 mean=15 min=3 p50=12 ... max=40`
+     */
+    void write_summary(std::ostream& ost, Summary const& summary, std::vector<double> const& percentiles);
+    /** Record under which summary is written: site, channel and location of histogram, current time
+     */
+    Record summary_record(Summary const& summary, Severity severity);
+
+namespace impl
+{
+    struct Captured
+    {
+        bool            set;
+        std::uint64_t   value;
+    };
+    /// Value marked by @ref metric in message being formatted on this thread
+    Captured& captured() noexcept;
+}
+    /** Message argument which is written as usual and marks its value as record's metric
+     *  @code
+     *  $log_debug("lookup took", histogram::metric(micros), "us");
+     *  @endcode
+     */
+    struct Metric
+    {
+        std::uint64_t   value;
+    };
+
+    template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    Metric metric(T value)
+    {
+        return Metric { value > T() ? static_cast<std::uint64_t>(value) : 0 };
+    }
+
+    template<typename Rep, typename Period>
+    Metric metric(std::chrono::duration<Rep, Period> value)
+    {
+        return metric(value.count());
+    }
+
+    inline std::ostream& operator<<(std::ostream& ost, Metric const& metric)
+    {
+        impl::captured() = impl::Captured { true, metric.value };
+        return ost << metric.value;
+    }
+    /** Per-thread histograms of values, grouped by site or channel
+     *
+     *  Each thread records into its own set of histograms with plain relaxed stores,
+     *  without locks or read-modify-write operations. Histograms are cumulative,
+     *  and @ref collect returns difference against the previous call.
+     */
+    class Aggregator
+    {
+    public:
+        explicit Aggregator(Options const& options);
+        ~Aggregator();
+
+        Aggregator(Aggregator const&)            = delete;
+        Aggregator& operator=(Aggregator const&) = delete;
+        /** Formats message into buffer and records its value, if there's any
+         *  @return true if message was consumed, false if it carries no value
+         */
+        bool consume(Metadata const& meta, WriterFunc writer, util::SlabStreamBuf& text);
+        /** Records value directly
+         */
+        void add(Metadata const& meta, std::uint64_t value);
+        /** Collects values recorded since previous call, one summary per non-empty histogram
+         */
+        std::vector<Summary> collect();
+
+        Options const& options() const noexcept;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+} // namespace histogram
+    /** Aggregates records with numeric values into histograms and periodically writes their summaries
+     *
+     *  Summaries are written as records with callsite and channel of histogram, severity from options
+     *  and current time, see @ref histogram::summary_record. Records without value are passed through,
+     *  unless disabled in options. Writes to wrapped logger are serialized, since summaries are written from executor thread.
+     *  Final summaries are written on destruction.
+     *
+     *  Every record is enabled: put filter in front of this logger to choose which ones are aggregated.
+     */
+    template<typename L>
+    class HistogramLogger
+    {
+    public:
+        /** @param  logger      Wrapped logger which receives summaries
+         *  @param  options     Aggregation options
+         *  @param  executor    Executor which writes summaries; should outlive logger
+         */
+        HistogramLogger(L logger, histogram::Options const& options = histogram::Options(), util::Executor& executor = util::Executor::shared())
+            : _state(new State(std::move(logger), options))
+            , _executor(&executor)
+        {
+            State* state = _state.get();
+            _timer = executor.schedule_every(options.interval, [state] { state->emit(); });
+        }
+
+        HistogramLogger(HistogramLogger&&) = default;
+
+        ~HistogramLogger()
+        {
+            if(!_state)
+                return;
+            _executor->cancel(_timer);
+            _state->emit();
+        }
+
+        bool is_enabled(Metadata const&) { return true; }
+
+        void write(Record const& record, WriterFunc writer)
+        {
+            util::SlabStreamBuf text;
+            if(_state->aggregator.consume(record, writer, text) || !_state->aggregator.options().pass_through)
+                return;
+            std::lock_guard<std::mutex> lock(_state->mutex);
+            _state->logger.write(record, [&](std::ostream& ost) { text.write_to(ost); });
+        }
+        /** Writes summaries of values collected so far
+         */
+        void flush()
+        {
+            _state->emit();
+        }
+
+    private:
+        // Kept on heap, so timer task can refer to it while logger object itself is moved around
+        struct State
+        {
+            State(L&& logger, histogram::Options const& options)
+                : aggregator(options)
+                , logger(std::move(logger))
+            { }
+
+            void emit()
+            {
+                auto& options = aggregator.options();
+                auto summaries = aggregator.collect();
+                std::lock_guard<std::mutex> lock(mutex);
+                for(auto& summary : summaries)
+                {
+                    Record record = histogram::summary_record(summary, options.summary_severity);
+                    logger.write(record, [&](std::ostream& ost) { histogram::write_summary(ost, summary, options.percentiles); });
+                }
+            }
+
+            histogram::Aggregator   aggregator;
+            std::mutex              mutex;
+            L                       logger;
+        };
+
+        std::unique_ptr<State>  _state;
+        util::Executor*         _executor;
+        util::executor::TimerId _timer;
+    };
+    /** Construct histogram logger from wrapped logger, options and executor
+     */
+    template<typename L>
+    HistogramLogger<typename std::decay<L>::type>
+    make_histogram_logger(L&& logger, histogram::Options const& options = histogram::Options(), util::Executor& executor = util::Executor::shared())
+    {
+        return HistogramLogger<typename std::decay<L>::type>(std::forward<L>(logger), options, executor);
+    }
+} // namespace log
+} // namespace toolboxcpp
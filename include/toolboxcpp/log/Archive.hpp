@@ -0,0 +1,166 @@
+#pragma once
+/** Seekable archive format for long-term log storage
+ *
+ *  Archive is a sequence of independently compressed blocks. Each block starts with index
+ *  which holds timestamp range, severities and channels of its records, so reader can skip
+ *  blocks not matching the query without decompressing them, and decompress matching ones
+ *  in parallel. Blocks are compressed with built-in @ref util::lz codec.
+ *
+ *  Layout, all integers are little-endian:
+ *
+ *      file    := "TBXARC1\n" block*
+ *      block   := magic:u32 index_size:u32 index payload
+ *      index   := compressed_size:u32 raw_size:u32 records:u32 min_ts:i64 max_ts:i64
+ *                 severities:u32 channel_count:u16 (name_size:u16 name)*
+ *      payload := compressed records
+ *      record  := ts_delta:zigzag-varint severity:u8 channel:varint size:varint message
+ *
+ *  Timestamps are nanoseconds since epoch, each one stored as delta from the previous record
+ *  of the same block. Channel is 1-based index into block's channel list, 0 stands for no channel.
+ *  Block which was cut short by crash is ignored by reader and cut off by writer on reopening.
+ */
+#include <toolboxcpp/log/Logger.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace archive
+{
+    /** Options of @ref ArchiveLogger
+     */
+    struct Options
+    {
+        /// Block is compressed and written out once this many bytes of records is collected
+        std::size_t     block_size  = 256 * 1024;
+    };
+    /** Writer statistics, all counters are cumulative
+     */
+    struct Stats
+    {
+        std::uint64_t   records;            ///< Records written out
+        std::uint64_t   blocks;             ///< Blocks written out
+        std::uint64_t   raw_bytes;          ///< Encoded records before compression
+        std::uint64_t   compressed_bytes;   ///< Bytes of blocks written to file, indexes included
+        std::uint64_t   errors;             ///< Blocks which failed to be written; their records are lost
+    };
+    /** Bit of severity in @ref BlockInfo::severities and @ref Query::severities
+     */
+    constexpr std::uint32_t severity_bit(Severity severity)
+    {
+        return 1u << static_cast<unsigned>(severity);
+    }
+    /** Index of single block, as read from the file
+     */
+    struct BlockInfo
+    {
+        std::uint64_t               offset;             ///< Offset of block start in file
+        std::uint32_t               compressed_size;
+        std::uint32_t               raw_size;
+        std::uint32_t               records;
+        Timestamp                   min_timestamp;
+        Timestamp                   max_timestamp;
+        std::uint32_t               severities;         ///< Severities present in block, see @ref severity_bit
+        std::vector<std::string>    channels;           ///< Channels present in block; empty name stands for no channel
+    };
+    /** Record selection criteria; record should satisfy all of them
+     */
+    struct Query
+    {
+        /// Inclusive timestamp range
+        Timestamp                   from        = Timestamp::min();
+        Timestamp                   to          = Timestamp::max();
+        /// Accepted severities, see @ref severity_bit
+        std::uint32_t               severities  = ~0u;
+        /// Accepted channels; empty list accepts any channel
+        std::vector<std::string>    channels;
+    };
+    /** Record read back from archive
+     */
+    struct Entry
+    {
+        Timestamp       timestamp;
+        Severity        severity;
+        std::string     channel;
+        std::string     message;
+    };
+} // namespace archive
+    /** Writes records into archive file, one compressed block at a time
+     *
+     *  Records are encoded into memory buffer on caller thread. Once buffer reaches `block_size`,
+     *  thread which filled it compresses and writes the block, while other writers go on
+     *  filling the next one. Unfinished block is written on @ref flush and on destruction;
+     *  wrap logger with @ref make_flushing_logger to bound how long records stay in memory.
+     */
+    class ArchiveLogger
+    {
+    public:
+        /** Opens archive for appending or creates new one
+         *  @param      path                File path
+         *  @param      options             Archive options
+         *  @exception  std::system_error   If file can't be opened
+         *  @exception  std::runtime_error  If file exists and isn't an archive
+         */
+        explicit ArchiveLogger(std::string const& path, archive::Options const& options = archive::Options());
+
+        ArchiveLogger(ArchiveLogger&&);
+        ArchiveLogger& operator=(ArchiveLogger&&);
+        ~ArchiveLogger();
+
+        bool is_enabled(Metadata const&) { return true; }
+
+        void write(Record const& record, WriterFunc writer);
+        /** Writes out unfinished block
+         */
+        void flush();
+
+        archive::Stats stats() const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+    /** Reads and queries archive written by @ref ArchiveLogger
+     *
+     *  Block indexes are read on construction; blocks appended after that aren't visible.
+     *  Reader is immutable and may be queried from several threads at once.
+     */
+    class ArchiveReader
+    {
+    public:
+        /** Opens archive and reads its block indexes
+         *  @param      path                File path
+         *  @exception  std::system_error   If file can't be opened
+         *  @exception  std::runtime_error  If file isn't an archive
+         */
+        explicit ArchiveReader(std::string const& path);
+
+        ArchiveReader(ArchiveReader&&);
+        ArchiveReader& operator=(ArchiveReader&&);
+        ~ArchiveReader();
+        /** Indexes of all complete blocks, in file order
+         */
+        std::vector<archive::BlockInfo> const& blocks() const noexcept;
+        /** Selects records matching query, in file order
+         *
+         *  Only blocks whose index may match the query are read and decompressed,
+         *  spread over several threads.
+         *  @param      query               Selection criteria
+         *  @param      threads             Maximal number of threads to use; 0 means number of CPUs
+         *  @return                         Matching records
+         *  @exception  std::runtime_error  If block is damaged
+         */
+        std::vector<archive::Entry> query(archive::Query const& query, std::size_t threads = 0) const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+} // namespace log
+} // namespace toolboxcpp
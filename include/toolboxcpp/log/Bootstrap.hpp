@@ -0,0 +1,56 @@
+#pragma once
+/** Opt-in bootstrap buffer, which keeps records written before the real logger is set
+ *
+ *  Once enabled, buffer acts as current logger: records are formatted and kept in memory,
+ *  up to configured limits. When real logger is set through @ref set_logger_pointer or @ref set_logger,
+ *  buffered records are replayed into it in their original order, and then logging goes straight
+ *  to real logger. So sink stack, with its files and sockets, may be built off startup critical path,
+ *  even from background thread, without losing early records.
+ *
+ *  Records which didn't fit into buffer are counted, and replay ends with warning about them.
+ */
+#include <toolboxcpp/log/Logger.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace bootstrap
+{
+    /** Limits of bootstrap buffer
+     */
+    struct Options
+    {
+        std::size_t     max_records = 4096;             ///< Maximal number of buffered records
+        std::size_t     max_bytes   = 1 << 20;          ///< Maximal total size of buffered messages
+        Severity        severity    = Severity::Info;   ///< Most verbose severity which is buffered
+    };
+    /** Installs bootstrap buffer as current logger
+     *  Should be called once, before anything is logged
+     *
+     *  @exception  std::logic_error    If logger or bootstrap buffer was already initialized
+     */
+    void enable(Options const& options = Options());
+    /** Number of records dropped so far because buffer was full
+     */
+    std::uint64_t dropped() noexcept;
+
+namespace impl
+{
+    /** Replays buffer into logger, if `current` is bootstrap buffer which wasn't replayed yet
+     *
+     *  After replay, records which still reach the buffer are passed to `logger`.
+     *  Called by @ref set_logger_pointer before it switches current logger.
+     *
+     *  @param  current     Current logger
+     *  @param  logger      Real logger
+     *  @return             true if buffer was replayed, false otherwise
+     */
+    bool replay(Logger* current, Logger& logger);
+} // namespace impl
+} // namespace bootstrap
+} // namespace log
+} // namespace toolboxcpp
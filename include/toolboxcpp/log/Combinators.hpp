@@ -2,14 +2,23 @@
 /** Set of useful combinators and wrappers for constructing your own logger implementation
  *  Completely independent of any kind of concrete implementation
  */
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <tuple>
 #include <utility>
-#include <sstream>
+#include <ostream>
+#include <vector>
 
 #include <toolboxcpp/log/Log.hpp>
 #include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/util/Executor.hpp>
 #include <toolboxcpp/util/FoldTuple.hpp>
+#include <toolboxcpp/util/Slab.hpp>
 
 namespace toolboxcpp
 {
@@ -26,9 +35,9 @@ namespace log
             Metadata const& meta;
 
             template<typename T>
-            bool operator()(bool enabled, T&& logger)
+            bool operator()(T&& logger)
             {
-                return enabled || logger.is_enabled(meta);
+                return logger.is_enabled(meta);
             }
         };
 
@@ -38,11 +47,22 @@ namespace log
             WriterFunc writer;
 
             template<typename T>
-            int operator()(int, T&& logger)
+            void operator()(T&& logger)
             {
                 if(logger.is_enabled(record))
                     logger.write(record, writer);
-                return 0;
+            }
+        };
+
+        struct WriteBatch
+        {
+            BatchEntry const*   entries;
+            std::size_t         count;
+
+            template<typename T>
+            void operator()(T&& logger)
+            {
+                log::write_batch(logger, entries, count);
             }
         };
     public:
@@ -54,12 +74,18 @@ namespace log
 
         bool is_enabled(Metadata const& meta)
         {
-            return util::fold_tuple(_loggers, false, IsEnabled { meta });
+            return util::any_of_tuple(_loggers, IsEnabled { meta });
         }
 
         void write(Record const& rec, WriterFunc writer)
         {
-            util::fold_tuple(_loggers, 0, Write{ rec, writer });
+            util::for_each_tuple(_loggers, Write{ rec, writer });
+        }
+        /** Passes whole batch to each nested logger, which picks its own enabled records
+         */
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            util::for_each_tuple(_loggers, WriteBatch{ entries, count });
         }
 
     private:
@@ -72,6 +98,39 @@ namespace log
     {
         return MultiLogger<typename std::decay<Args>::type...>(std::forward<Args>(args)...);
     }
+namespace impl
+{
+    /** Evaluates predicate over chunk of batch first, then passes runs of accepted records to logger
+     *
+     *  Predicate loop doesn't touch logger, so it stays tight, and logger gets as long
+     *  contiguous sub-batches as predicate allows, without copying.
+     */
+    template<typename L, typename Pred>
+    void write_batch_if(L& logger, BatchEntry const* entries, std::size_t count, Pred&& pred)
+    {
+        static constexpr std::size_t Chunk = 256;
+        bool accepted[Chunk];
+        for(std::size_t base = 0; base < count; base += Chunk)
+        {
+            std::size_t size = count - base < Chunk ? count - base : Chunk;
+            for(std::size_t i = 0; i < size; ++i)
+                accepted[i] = pred(static_cast<Metadata const&>(entries[base + i].record));
+            for(std::size_t i = 0; i < size; )
+            {
+                if(!accepted[i])
+                {
+                    ++i;
+                    continue;
+                }
+                std::size_t end = i + 1;
+                while(end < size && accepted[end])
+                    ++end;
+                log::write_batch(logger, entries + base + i, end - i);
+                i = end;
+            }
+        }
+    }
+}
     /** Logger which makes enabled/disabled decision based on call to unary functor
      *
      *  Filter functor should have signature compatible with
@@ -97,6 +156,12 @@ namespace log
         {
             _logger.write(record, writer);
         }
+        /** Passes runs of records accepted by filter to nested logger, see @ref impl::write_batch_if
+         */
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            impl::write_batch_if(_logger, entries, count, _filter);
+        }
 
     private:
         Fn  _filter;
@@ -111,6 +176,208 @@ namespace log
         return FilteredLogger<typename std::decay<Fn>::type, typename std::decay<L>::type>
             (std::forward<Fn>(filter), std::forward<L>(logger));
     }
+    /** Single escalation step of @ref AdaptiveLogger
+     */
+    struct PressureStep
+    {
+        std::size_t raise_at;       ///< Step is entered when pressure reaches this value
+        std::size_t lower_at;       ///< Step is left when pressure drops below this value; should be less than `raise_at`
+        Severity    max_severity;   ///< The least important severity written while step is active
+    };
+    /** Logger which drops less important records when wrapped logger falls behind
+     *
+     *  Pressure is obtained from probe functor, which should have signature compatible with
+     *  @code
+     *  std::size_t (L&)
+     *  @endcode
+     *  and is called on every `is_enabled` check, so it should be cheap; pending bytes
+     *  of @ref SocketLogger or queue depth of any buffered sink are good candidates.
+     *
+     *  Steps should be ordered by increasing `raise_at`. Each of them is entered once pressure
+     *  reaches its `raise_at`, and left only when pressure drops below its `lower_at`,
+     *  which prevents flapping around single threshold. Every level change is written
+     *  to wrapped logger as warning on `toolboxcpp.log` channel, regardless of current threshold,
+     *  if wrapped logger accepts such record.
+     */
+    template<typename Probe, typename L>
+    class AdaptiveLogger
+    {
+    public:
+        AdaptiveLogger(Probe probe, std::vector<PressureStep> steps, L logger)
+            : _probe(std::move(probe))
+            , _steps(std::move(steps))
+            , _logger(std::move(logger))
+            , _level(0)
+        { }
+
+        AdaptiveLogger(AdaptiveLogger&& other)
+            : _probe(std::move(other._probe))
+            , _steps(std::move(other._steps))
+            , _logger(std::move(other._logger))
+            , _level(other._level.load(std::memory_order_relaxed))
+        { }
+
+        bool is_enabled(Metadata const& meta)
+        {
+            return meta.severity <= adjust(_probe(_logger)) && _logger.is_enabled(meta);
+        }
+
+        void write(Record const& record, WriterFunc writer)
+        {
+            _logger.write(record, writer);
+        }
+        /** Passes runs of records within current threshold to wrapped logger; pressure isn't probed,
+         *  so batch is filtered against the same threshold as a whole
+         */
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            Severity max = max_severity();
+            impl::write_batch_if(_logger, entries, count, [max](Metadata const& meta) { return meta.severity <= max; });
+        }
+        /** Currently effective least important severity
+         */
+        Severity max_severity() const
+        {
+            return max_severity(_level.load(std::memory_order_relaxed));
+        }
+
+    private:
+        Severity max_severity(std::size_t level) const
+        {
+            return level == 0 ? Severity::Trace : _steps[level - 1].max_severity;
+        }
+        // Moves current level according to pressure, returns effective severity
+        Severity adjust(std::size_t pressure)
+        {
+            std::size_t level = _level.load(std::memory_order_relaxed);
+            std::size_t next  = level;
+            while(next < _steps.size() && pressure >= _steps[next].raise_at)
+                ++next;
+            while(next > 0 && pressure < _steps[next - 1].lower_at)
+                --next;
+            // Only the thread which actually switched level reports it
+            if(next != level && _level.compare_exchange_strong(level, next, std::memory_order_relaxed))
+                report(pressure, level, next);
+            return max_severity(next);
+        }
+
+        void report(std::size_t pressure, std::size_t from, std::size_t to)
+        {
+            Record record;
+            record.severity  = Severity::Warning;
+            record.channel   = "toolboxcpp.log";
+            record.location  = $SourceLocation;
+            record.site      = 0;
+            record.timestamp = std::chrono::system_clock::now();
+
+            const char* action = to > from ? "raised" : "lowered";
+            auto writer = [&](std::ostream& ost)
+            {
+                ost << "Log pressure " << pressure << ": severity threshold " << action
+                    << " to " << severity_name(max_severity(to));
+            };
+            if(_logger.is_enabled(record))
+                _logger.write(record, writer);
+        }
+
+        Probe                       _probe;
+        std::vector<PressureStep>   _steps;
+        L                           _logger;
+        std::atomic<std::size_t>    _level;     ///< Number of active steps
+    };
+    /** Construct adaptive logger from pressure probe, escalation steps and nested logger
+     */
+    template<typename Probe, typename L>
+    AdaptiveLogger<typename std::decay<Probe>::type, typename std::decay<L>::type>
+    make_adaptive_logger(Probe&& probe, std::vector<PressureStep> steps, L&& logger)
+    {
+        return AdaptiveLogger<typename std::decay<Probe>::type, typename std::decay<L>::type>
+            (std::forward<Probe>(probe), std::move(steps), std::forward<L>(logger));
+    }
+    /** Flushes wrapped logger periodically on executor, instead of flushing it after every record
+     *
+     *  Wrapped logger should have `void flush()` method. Writes and flushes are serialized,
+     *  so wrapped logger doesn't need to be thread-safe. Last flush is done on destruction.
+     */
+    template<typename L>
+    class FlushingLogger
+    {
+    public:
+        /** @param  logger      Wrapped logger
+         *  @param  period      Interval between flushes
+         *  @param  executor    Executor which runs flushes; should outlive logger
+         */
+        FlushingLogger(L logger, std::chrono::milliseconds period, util::Executor& executor = util::Executor::shared())
+            : _state(new State(std::move(logger)))
+            , _executor(&executor)
+        {
+            State* state = _state.get();
+            _timer = executor.schedule_every(period, [state] { state->flush(); });
+        }
+
+        FlushingLogger(FlushingLogger&&) = default;
+
+        ~FlushingLogger()
+        {
+            if(!_state)
+                return;
+            _executor->cancel(_timer);
+            _state->flush();
+        }
+
+        bool is_enabled(Metadata const& meta)
+        {
+            return _state->logger.is_enabled(meta);
+        }
+
+        void write(Record const& record, WriterFunc writer)
+        {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+            _state->logger.write(record, writer);
+        }
+        /** Writes whole batch under single lock
+         */
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+            log::write_batch(_state->logger, entries, count);
+        }
+
+        void flush()
+        {
+            _state->flush();
+        }
+
+    private:
+        // Kept on heap, so timer task can refer to it while logger object itself is moved around
+        struct State
+        {
+            explicit State(L&& logger)
+                : logger(std::move(logger))
+            { }
+
+            void flush()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                logger.flush();
+            }
+
+            std::mutex  mutex;
+            L           logger;
+        };
+
+        std::unique_ptr<State>  _state;
+        util::Executor*         _executor;
+        util::executor::TimerId _timer;
+    };
+    /** Construct flushing logger from nested logger, flush period and executor
+     */
+    template<typename L>
+    FlushingLogger<typename std::decay<L>::type>
+    make_flushing_logger(L&& logger, std::chrono::milliseconds period, util::Executor& executor = util::Executor::shared())
+    {
+        return FlushingLogger<typename std::decay<L>::type>(std::forward<L>(logger), period, executor);
+    }
     /** Applies additional formatting to message using provided formatting functor
      *
      *  Format functor should have signature compatible with:
@@ -134,6 +401,34 @@ namespace log
             auto format_proxy = [&] (std::ostream& ost) { _formatter(ost, rec, writer); };
             _logger.write(rec, format_proxy);
         }
+        /** Formats enabled records of batch into single buffer, and passes them to nested logger as new batch
+         */
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            std::ostringstream ost;
+            std::vector<BatchEntry> formatted;
+            std::vector<std::size_t> offsets;
+            formatted.reserve(count);
+            offsets.reserve(count + 1);
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                auto& entry = entries[i];
+                if(!_logger.is_enabled(entry.record))
+                    continue;
+                offsets.push_back(static_cast<std::size_t>(ost.tellp()));
+                _formatter(ost, entry.record, [&](std::ostream& out) { write_message(out, entry); });
+                formatted.push_back(BatchEntry { entry.record, nullptr, 0 });
+            }
+            offsets.push_back(static_cast<std::size_t>(ost.tellp()));
+            std::string text = ost.str();
+            // Text is complete only now, so messages are pointed to after formatting
+            for(std::size_t i = 0; i < formatted.size(); ++i)
+            {
+                formatted[i].message = text.data() + offsets[i];
+                formatted[i].size    = offsets[i + 1] - offsets[i];
+            }
+            log::write_batch(_logger, formatted.data(), formatted.size());
+        }
 
     private:
         Fn  _formatter;
@@ -152,6 +447,7 @@ namespace log
      *
      *  This can be useful when you know that certain message will be written to multiple underlying streams.
      *  In this case, performing formatting once may save you some time.
+     *  Buffer is made of per-thread slab blocks, see `toolboxcpp/util/Slab.hpp`, so caching doesn't touch global heap
      */
     template<typename L>
     struct CachedLogger
@@ -168,11 +464,18 @@ namespace log
 
         void write(Record const& rec, WriterFunc writer)
         {
-            std::ostringstream msg;
+            util::SlabStreamBuf buffer;
+            std::ostream msg(&buffer);
             writer(msg);
-            auto writer_proxy = [&](std::ostream& ost) { ost << msg.rdbuf(); };
+            auto writer_proxy = [&](std::ostream& ost) { buffer.write_to(ost); };
             _logger.write(rec, writer_proxy);
         }
+        /** Messages of batch are already formatted, so batch is passed as is
+         */
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            log::write_batch(_logger, entries, count);
+        }
     private:
         L _logger;
     };
@@ -0,0 +1,174 @@
+#pragma once
+/** Per-thread logging context, also known as "mapped diagnostic context"
+ *
+ *  Key/value pairs pushed onto the context stack of current thread are attached
+ *  to every record written from that thread, until they're popped back
+ */
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/** Pushes key/value pair onto current thread's log context till the end of enclosing scope
+ *
+ *  @param  $key    String literal, context key
+ *  @param  $value  Context value, C string or `std::string`
+ */
+#define $LogContext($key, $value) ::toolboxcpp::log::ScopedContext $log_context_name(__LINE__) ($key, $value)
+
+#define $log_context_name($line)        $log_context_name_impl($line)
+#define $log_context_name_impl($line)   __toolbox_log_context_ ## $line
+
+namespace toolboxcpp
+{
+namespace log
+{
+    /** Single key/value pair of logging context
+     */
+    struct ContextEntry
+    {
+        const char*     key;
+        const char*     value;
+        std::size_t     size;
+    };
+    /** Non-owning view over thread's context stack, from the outermost entry to the innermost one
+     *
+     *  !!!WARN!!! Points directly into thread-local storage of the thread which produced record,
+     *  so it stays valid only during `Logger::write` call. Loggers which keep records around
+     *  should copy context contents out
+     */
+    class Context
+    {
+    public:
+        Context()
+            : _begin(nullptr)
+            , _end(nullptr)
+        { }
+
+        Context(ContextEntry const* begin, ContextEntry const* end)
+            : _begin(begin)
+            , _end(end)
+        { }
+
+        ContextEntry const* begin() const noexcept { return _begin; }
+        ContextEntry const* end()   const noexcept { return _end; }
+
+        bool        empty() const noexcept { return _begin == _end; }
+        std::size_t size()  const noexcept { return static_cast<std::size_t>(_end - _begin); }
+        /** Looks up the innermost value with specified key
+         *  @param  key     Context key
+         *  @return         Pointer to entry, or nullptr if there's no such key
+         */
+        ContextEntry const* find(const char* key) const noexcept
+        {
+            for(auto it = _end; it != _begin; --it)
+                if(std::strcmp((it - 1)->key, key) == 0)
+                    return it - 1;
+            return nullptr;
+        }
+
+    private:
+        ContextEntry const* _begin;
+        ContextEntry const* _end;
+    };
+    /** Writes context as space-separated sequence of `key=value` pairs
+     */
+    inline std::ostream& operator << (std::ostream& ost, Context const& context)
+    {
+        bool first = true;
+        for(auto& entry: context)
+        {
+            if(!first)
+                ost << ' ';
+            ost << entry.key << '=';
+            ost.write(entry.value, static_cast<std::streamsize>(entry.size));
+            first = false;
+        }
+        return ost;
+    }
+    /** Owning copy of context, for loggers which keep records after `write` returns
+     *
+     *  Copied entries point into storage owned by this object, which stays in place
+     *  when object is moved, so copies may be freely moved between containers
+     */
+    class OwnedContext
+    {
+    public:
+        OwnedContext() {}
+        explicit OwnedContext(Context const& context);
+
+        OwnedContext(OwnedContext&&)                 = default;
+        OwnedContext& operator=(OwnedContext&&)      = default;
+        OwnedContext(OwnedContext const&)            = delete;
+        OwnedContext& operator=(OwnedContext const&) = delete;
+        /** View over copied entries, valid while this object exists
+         */
+        Context view() const noexcept
+        {
+            return Context(_entries.data(), _entries.data() + _entries.size());
+        }
+
+    private:
+        std::vector<char>           _data;
+        std::vector<ContextEntry>   _entries;
+    };
+
+namespace context
+{
+    /// Maximal number of entries on single thread's context stack
+    static constexpr std::size_t MaxEntries   = 32;
+    /// Size of per-thread arena where context values are copied, including terminating zeros
+    static constexpr std::size_t ArenaSize    = 1024;
+    /** Pushes key/value pair onto current thread's context stack
+     *
+     *  Value is copied into thread-local arena, key is stored as is
+     *
+     *  @param  key     Context key, should outlive pushed entry; string literal in most cases
+     *  @param  value   Pointer to value characters
+     *  @param  size    Number of value characters
+     *  @return         true if entry was pushed, false if there's not enough space in the arena
+     */
+    bool push(const char* key, const char* value, std::size_t size) noexcept;
+    /** Removes innermost entry from current thread's context stack
+     *  Should be called only after successful @ref push
+     */
+    void pop() noexcept;
+    /** Returns view over current thread's context stack
+     */
+    Context current() noexcept;
+} // namespace context
+    /** Pushes key/value pair onto current thread's context stack on construction, and pops it on destruction
+     */
+    class ScopedContext
+    {
+    public:
+        ScopedContext(const char* key, const char* value, std::size_t size)
+            : _pushed(context::push(key, value, size))
+        { }
+
+        ScopedContext(const char* key, const char* value)
+            : ScopedContext(key, value, std::strlen(value))
+        { }
+
+        ScopedContext(const char* key, std::string const& value)
+            : ScopedContext(key, value.data(), value.size())
+        { }
+
+        ScopedContext(ScopedContext const&)            = delete;
+        ScopedContext& operator=(ScopedContext const&) = delete;
+
+        ~ScopedContext()
+        {
+            if(_pushed)
+                context::pop();
+        }
+        /** Checks if entry actually got onto context stack
+         */
+        bool pushed() const noexcept { return _pushed; }
+
+    private:
+        bool _pushed;
+    };
+} // namespace log
+} // namespace toolboxcpp
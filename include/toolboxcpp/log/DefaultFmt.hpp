@@ -2,6 +2,7 @@
 
 #include <toolboxcpp/util/FoldTuple.hpp>
 
+#include <ostream>
 #include <tuple>
 #include <utility>
 
@@ -21,11 +22,12 @@ struct DefaultFormatter
 private:
     struct Write
     {
+        std::ostream& ost;
+
         template<typename T>
-        std::ostream& operator()(std::ostream& ost, T&& arg)
+        void operator()(T&& arg)
         {
             ost << arg;
-            return ost;
         }
     };
 
@@ -36,7 +38,7 @@ public:
     
     void operator () (std::ostream& ost) const
     {
-        util::fold_tuple(_args, ost, Write{});
+        util::for_each_tuple(_args, Write{ ost });
     }
 
 private:
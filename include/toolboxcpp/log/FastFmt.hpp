@@ -0,0 +1,141 @@
+#pragma once
+
+#include <toolboxcpp/util/CharConv.hpp>
+#include <toolboxcpp/util/FoldTuple.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+    Formatter which captures all passed in variables, like default one, but encodes
+    integers, floating-point values and timestamps by itself, bypassing stream's locale facets.
+    Everything else is written through stream output operator.
+
+    Can be selected as `$log_format` either by defining `TOOLBOX_LOG_FAST_FORMAT`
+    or explicitly, before including `Log.hpp`:
+    @code
+    #include <toolboxcpp/log/FastFmt.hpp>
+    #define $log_format(...) (::toolboxcpp::log::fast_format(__VA_ARGS__))
+    @endcode
+
+    Please note that stream formatting flags, like precision or base, are ignored for fast-path types.
+*/
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace impl
+{
+    /// Compile-time classification of formatter argument
+    enum class ArgKind { Generic, Integer, Float, Timestamp, CString, String };
+
+    template<typename T>
+    struct ArgKindOf: std::integral_constant<ArgKind,
+        std::is_same<T, bool>::value || std::is_same<T, char>::value ||
+        std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value ||
+        std::is_same<T, wchar_t>::value || std::is_same<T, char16_t>::value || std::is_same<T, char32_t>::value
+                                                                    ? ArgKind::Generic   :
+        std::is_integral<T>::value                                  ? ArgKind::Integer   :
+        std::is_same<T, float>::value || std::is_same<T, double>::value
+                                                                    ? ArgKind::Float     :
+        std::is_same<T, std::chrono::system_clock::time_point>::value
+                                                                    ? ArgKind::Timestamp :
+        std::is_same<T, const char*>::value || std::is_same<T, char*>::value
+                                                                    ? ArgKind::CString   :
+        std::is_same<T, std::string>::value                         ? ArgKind::String    :
+                                                                      ArgKind::Generic
+    > {};
+
+    template<ArgKind K> using ArgTag = std::integral_constant<ArgKind, K>;
+
+    template<typename T>
+    void fast_write(std::ostream& ost, T const& arg, ArgTag<ArgKind::Generic>)
+    {
+        ost << arg;
+    }
+
+    template<typename T>
+    void fast_write(std::ostream& ost, T arg, ArgTag<ArgKind::Integer>)
+    {
+        char buffer[util::MaxIntegerChars];
+        ost.write(buffer, util::write_integer(buffer, arg) - buffer);
+    }
+
+    template<typename T>
+    void fast_write(std::ostream& ost, T arg, ArgTag<ArgKind::Float>)
+    {
+        char buffer[util::MaxFloatChars];
+        ost.write(buffer, util::write_float(buffer, arg) - buffer);
+    }
+
+    inline void fast_write(std::ostream& ost, std::chrono::system_clock::time_point arg, ArgTag<ArgKind::Timestamp>)
+    {
+        char buffer[util::TimestampChars];
+        ost.write(buffer, util::write_timestamp(buffer, arg) - buffer);
+    }
+
+    inline void fast_write(std::ostream& ost, const char* arg, ArgTag<ArgKind::CString>)
+    {
+        if(arg)
+            ost.write(arg, static_cast<std::streamsize>(std::strlen(arg)));
+        else
+            ost << arg;     // Let stream decide what to do with null pointer
+    }
+
+    inline void fast_write(std::ostream& ost, std::string const& arg, ArgTag<ArgKind::String>)
+    {
+        ost.write(arg.data(), static_cast<std::streamsize>(arg.size()));
+    }
+    /** Writes single value into stream, using fast-path encoder if there's one for its type
+     */
+    template<typename T>
+    void fast_write(std::ostream& ost, T const& arg)
+    {
+        using Decayed = typename std::decay<T>::type;
+        fast_write(ost, arg, ArgTag<ArgKindOf<Decayed>::value>{});
+    }
+} // namespace impl
+
+template<typename... Args>
+struct FastFormatter
+{
+private:
+    struct Write
+    {
+        std::ostream& ost;
+
+        template<typename T>
+        void operator()(T&& arg)
+        {
+            impl::fast_write(ost, arg);
+        }
+    };
+
+public:
+    FastFormatter(Args... args)
+        : _args(std::forward<Args>(args)...)
+    { }
+
+    void operator () (std::ostream& ost) const
+    {
+        util::for_each_tuple(_args, Write{ ost });
+    }
+
+private:
+    std::tuple<Args...> _args;
+};
+
+template<typename... Args>
+FastFormatter<Args...> fast_format(Args&&... args)
+{
+    return FastFormatter<Args...>(std::forward<Args>(args)...);
+}
+
+}
+}
@@ -0,0 +1,271 @@
+#pragma once
+/** Logging macros with format strings which are parsed at compile time
+ *
+ *  @code
+ *  $log_info_f("user {} took {} us", id, elapsed);
+ *  @endcode
+ *
+ *  Format string should be string literal. Each `{}` is replaced with next argument,
+ *  `{{` and `}}` stand for literal braces. Format string is split into static table of literal spans,
+ *  each optionally followed by argument slot, and number of slots is checked against number
+ *  of arguments, both at compile time. Rendering interleaves literal spans with fast-path encoders
+ *  of `FastFmt.hpp`, without looking at format string characters.
+ *
+ *  Table is available as @ref FormatSpec, so it may serve as descriptor of record for binary or deferred sinks.
+ */
+#include <toolboxcpp/log/Log.hpp>
+#include <toolboxcpp/log/FastFmt.hpp>
+#include <toolboxcpp/util/FoldTuple.hpp>
+
+#include <cstddef>
+#include <ostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Hard, unrecoverable error
+#define $log_error_f($format, ...) $log_error_f_at($LogCurrentChannel, $LogCurrentLocation, $format, ## __VA_ARGS__)
+// An error which can be possibly handled somewhere up the code hierarchy
+#define $log_warn_f($format, ...)  $log_warn_f_at( $LogCurrentChannel, $LogCurrentLocation, $format, ## __VA_ARGS__)
+// Informational message
+#define $log_info_f($format, ...)  $log_info_f_at( $LogCurrentChannel, $LogCurrentLocation, $format, ## __VA_ARGS__)
+// Debug data, like state of some structure after operation
+#define $log_debug_f($format, ...) $log_debug_f_at($LogCurrentChannel, $LogCurrentLocation, $format, ## __VA_ARGS__)
+// Highly-detailed tracing message
+#define $log_trace_f($format, ...) $log_trace_f_at($LogCurrentChannel, $LogCurrentLocation, $format, ## __VA_ARGS__)
+/**
+    Same as `$log_*_at` macros, but with format string
+
+    @param[in] $channel     Log channel
+    @param[in] $location    File and line where logging happens
+    @param[in] $format      Format string literal
+*/
+#define $log_error_f_at($channel, $location, $format, ...) $log_perform_write_site_f(::toolboxcpp::log::Severity::Error,   $channel, $location, $format, ## __VA_ARGS__)
+#define $log_warn_f_at($channel, $location, $format, ...)  $log_perform_write_site_f(::toolboxcpp::log::Severity::Warning, $channel, $location, $format, ## __VA_ARGS__)
+#define $log_info_f_at($channel, $location, $format, ...)  $log_perform_write_site_f(::toolboxcpp::log::Severity::Info,    $channel, $location, $format, ## __VA_ARGS__)
+
+#ifdef TOOLBOX_LOG_DETAILED
+#   define $log_debug_f_at($channel, $location, $format, ...) $log_perform_write_site_f(::toolboxcpp::log::Severity::Debug, $channel, $location, $format, ## __VA_ARGS__)
+#   define $log_trace_f_at($channel, $location, $format, ...) $log_perform_write_site_f(::toolboxcpp::log::Severity::Trace, $channel, $location, $format, ## __VA_ARGS__)
+#else
+#   define $log_debug_f_at($channel, $location, $format, ...) (void())
+#   define $log_trace_f_at($channel, $location, $format, ...) (void())
+#endif
+/**
+    Same as $log_perform_write_site_fmt, but message is produced from format string
+
+    @param[in] $severity    log severity level; must be a constant expression
+    @param[in] $channel     log channel, defined by application
+    @param[in] $location    file and line which should be used in log message as location
+    @param[in] $format      Format string literal
+    @param[in] ...          Arguments substituted into format string
+*/
+#define $log_perform_write_site_f($severity, $channel, $location, $format, ...)                                               \
+    $log_perform_write_site($LogCurrentSite($severity), $severity, $channel, $location, $log_format_f($format, ## __VA_ARGS__)) \
+/**/
+/** Produces formatter from format string literal and arguments
+
+    Format string is captured as static member function of local type, so it's available
+    to templates as constant expression
+*/
+#define $log_format_f($format, ...) (::toolboxcpp::log::format_string([] {  \
+        struct Format                                                       \
+        {                                                                   \
+            static constexpr const char* text() { return "" $format; }      \
+            static constexpr std::size_t size() { return sizeof($format) - 1; } \
+        };                                                                  \
+        return Format();                                                    \
+    }(), ## __VA_ARGS__))                                                   \
+/**/
+
+namespace toolboxcpp
+{
+namespace log
+{
+    /** Literal span of format string, optionally followed by argument slot
+     */
+    struct FormatSpan
+    {
+        std::size_t     offset;     ///< Offset of literal in format string
+        std::size_t     size;       ///< Size of literal, may be 0
+        int             slot;       ///< Index of argument written after literal, or -1 if there's none
+    };
+
+namespace impl
+{
+/*
+    Parser consists of C++11 constexpr functions, so each of them is single expression.
+    Braces are searched by halves, so recursion depth is logarithmic in format string size;
+    each span is then classified by the brace sequence which ends it
+*/
+    enum class SpanEnd { End, Escape, Slot, Invalid };
+
+    constexpr bool is_brace(char ch)
+    {
+        return ch == '{' || ch == '}';
+    }
+
+    constexpr std::size_t find_brace(const char* text, std::size_t begin, std::size_t end);
+
+    constexpr std::size_t find_brace_right(std::size_t found, std::size_t middle, const char* text, std::size_t end)
+    {
+        return found != middle ? found : find_brace(text, middle, end);
+    }
+    // First brace in [begin, end), or end if there's none
+    constexpr std::size_t find_brace(const char* text, std::size_t begin, std::size_t end)
+    {
+        return end - begin == 0 ? end
+             : end - begin == 1 ? (is_brace(text[begin]) ? begin : end)
+             : find_brace_right(find_brace(text, begin, begin + (end - begin) / 2), begin + (end - begin) / 2, text, end);
+    }
+
+    constexpr SpanEnd span_end_at(const char* text, std::size_t pos, std::size_t size)
+    {
+        return pos == size                              ? SpanEnd::End
+             : text[pos] == '{' && text[pos + 1] == '{' ? SpanEnd::Escape
+             : text[pos] == '}' && text[pos + 1] == '}' ? SpanEnd::Escape
+             : text[pos] == '{' && text[pos + 1] == '}' ? SpanEnd::Slot
+             :                                            SpanEnd::Invalid;
+    }
+    // Kind of brace sequence which ends span starting at `pos`
+    constexpr SpanEnd span_end(const char* text, std::size_t pos, std::size_t size)
+    {
+        return span_end_at(text, find_brace(text, pos, size), size);
+    }
+
+    constexpr bool is_last_span(const char* text, std::size_t pos, std::size_t size)
+    {
+        return span_end(text, pos, size) == SpanEnd::End || span_end(text, pos, size) == SpanEnd::Invalid;
+    }
+    // Start of span which follows one starting at `pos`; both escape and slot are two characters long
+    constexpr std::size_t next_span(const char* text, std::size_t pos, std::size_t size)
+    {
+        return find_brace(text, pos, size) + 2;
+    }
+
+    constexpr bool is_valid_format(const char* text, std::size_t size, std::size_t pos = 0)
+    {
+        return is_last_span(text, pos, size)
+            ? span_end(text, pos, size) == SpanEnd::End
+            : is_valid_format(text, size, next_span(text, pos, size));
+    }
+
+    constexpr std::size_t count_spans(const char* text, std::size_t size, std::size_t pos = 0)
+    {
+        return is_last_span(text, pos, size) ? 1 : 1 + count_spans(text, size, next_span(text, pos, size));
+    }
+    // Number of slots in first `count` spans
+    constexpr std::size_t count_slots(const char* text, std::size_t size, std::size_t count, std::size_t pos = 0)
+    {
+        return count == 0 ? 0
+             : (span_end(text, pos, size) == SpanEnd::Slot ? 1 : 0)
+                + (is_last_span(text, pos, size) ? 0 : count_slots(text, size, count - 1, next_span(text, pos, size)));
+    }
+
+    constexpr std::size_t span_start(const char* text, std::size_t size, std::size_t index, std::size_t pos = 0)
+    {
+        return index == 0 ? pos : span_start(text, size, index - 1, next_span(text, pos, size));
+    }
+
+    constexpr FormatSpan make_span(const char* text, std::size_t size, std::size_t pos, std::size_t slots_before)
+    {
+        return FormatSpan {
+            pos,
+            find_brace(text, pos, size) - pos + (span_end(text, pos, size) == SpanEnd::Escape ? 1 : 0),
+            span_end(text, pos, size) == SpanEnd::Slot ? static_cast<int>(slots_before) : -1
+        };
+    }
+
+    constexpr FormatSpan span_at(const char* text, std::size_t size, std::size_t index)
+    {
+        return make_span(text, size, span_start(text, size, index), count_slots(text, size, index));
+    }
+
+    template<typename Format, typename Indices>
+    struct FormatTable;
+
+    template<typename Format, std::size_t... Is>
+    struct FormatTable<Format, util::impl::Indices<Is...>>
+    {
+        static constexpr FormatSpan spans[] = { span_at(Format::text(), Format::size(), Is)... };
+    };
+
+    template<typename Format, std::size_t... Is>
+    constexpr FormatSpan FormatTable<Format, util::impl::Indices<Is...>>::spans[];
+} // namespace impl
+    /** Compile-time description of format string
+     *
+     *  @tparam Format  Type with static constexpr `text()` and `size()` functions, which return format string and its size
+     */
+    template<typename Format>
+    struct FormatSpec
+    {
+        /// Format string
+        static constexpr const char* text() { return Format::text(); }
+        /// true if all braces in format string are either slots or escapes
+        static constexpr bool           valid       = impl::is_valid_format(Format::text(), Format::size());
+        /// Number of literal spans
+        static constexpr std::size_t    span_count  = impl::count_spans(Format::text(), Format::size());
+        /// Number of argument slots
+        static constexpr std::size_t    slot_count  = impl::count_slots(Format::text(), Format::size(), span_count);
+
+        using Table = impl::FormatTable<Format, typename util::impl::MakeIndices<span_count>::type>;
+        /// Literal spans, in order
+        static constexpr FormatSpan const* spans() { return Table::spans; }
+    };
+    /** Formatter which renders format string with arguments
+     *  Arguments are captured like in @ref FastFormatter
+     */
+    template<typename Format, typename... Args>
+    class FormatStringFormatter
+    {
+    public:
+        using Spec = FormatSpec<Format>;
+
+        static_assert(Spec::valid, "Format string contains unmatched brace; use {{ and }} for literal braces");
+        static_assert(Spec::slot_count == sizeof...(Args), "Number of arguments doesn't match number of {} in format string");
+
+        FormatStringFormatter(Args... args)
+            : _args(std::forward<Args>(args)...)
+        { }
+
+        void operator () (std::ostream& ost) const
+        {
+            write(ost, typename util::impl::MakeIndices<Spec::span_count>::type());
+        }
+
+    private:
+        template<std::size_t... Ks>
+        void write(std::ostream& ost, util::impl::Indices<Ks...>) const
+        {
+            (void) util::impl::Swallow { (write_span<Ks>(ost), 0)... };
+        }
+
+        template<std::size_t K>
+        void write_span(std::ostream& ost) const
+        {
+            using Span = std::integral_constant<std::size_t, Spec::Table::spans[K].size>;
+            if(Span::value)
+                ost.write(Spec::text() + Spec::Table::spans[K].offset, static_cast<std::streamsize>(Span::value));
+            write_slot(ost, std::integral_constant<int, Spec::Table::spans[K].slot>());
+        }
+
+        void write_slot(std::ostream&, std::integral_constant<int, -1>) const {}
+
+        template<int I>
+        void write_slot(std::ostream& ost, std::integral_constant<int, I>) const
+        {
+            impl::fast_write(ost, std::get<I>(_args));
+        }
+
+        std::tuple<Args...> _args;
+    };
+    /** Makes formatter from format descriptor and arguments, see `$log_format_f`
+     */
+    template<typename Format, typename... Args>
+    FormatStringFormatter<Format, Args...> format_string(Format, Args&&... args)
+    {
+        return FormatStringFormatter<Format, Args...>(std::forward<Args>(args)...);
+    }
+} // namespace log
+} // namespace toolboxcpp
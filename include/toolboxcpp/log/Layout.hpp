@@ -0,0 +1,96 @@
+#pragma once
+/** Record layout built from printf-like pattern, and message sanitizer, to be used as formatters in `FormattedLogger`
+ */
+#include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/util/Escape.hpp>
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace log
+{
+    /** Formats record header and message according to pattern, which is compiled once on construction
+     *
+     *  Pattern is an arbitrary text with following directives:
+     *  - `%T` - record timestamp, as ISO-8601 UTC with microseconds
+     *  - `%L` - severity name, like `ERROR` or `INFO`
+     *  - `%C` - channel
+     *  - `%f` - source file path
+     *  - `%b` - source file name without directories
+     *  - `%l` - source line
+     *  - `%F` - function name
+     *  - `%S` - callsite identifier, compact replacement for file and line, see `toolboxcpp/log/Sites.hpp`
+     *  - `%X` - logging context, see @ref Context
+     *  - `%m` - message itself
+     *  - `%J` - message escaped as contents of JSON string, see `toolboxcpp/util/Escape.hpp`
+     *  - `%M` - message as single line, with backslashes, newlines and other control characters escaped
+     *  - `%%` - percent sign
+     *
+     *  Pattern is compiled into flat list of segments, each one holding pointer to its emitter function
+     *  and span of literal text, so rendering a record doesn't look at pattern at all.
+     *  Compatible with `FormattedLogger`:
+     *  @code
+     *  auto logger = make_formatted_logger(Layout("%T [%L] %C %b:%l %m"), FileLogger("app.log", true));
+     *  @endcode
+     */
+    class Layout
+    {
+    public:
+        /** Compiles pattern
+         *  @param      pattern                 Layout pattern, see class description
+         *  @exception  std::invalid_argument   If pattern contains unknown directive or ends with `%`
+         */
+        explicit Layout(std::string const& pattern);
+
+        void operator()(std::ostream& ost, Record const& record, WriterFunc writer) const
+        {
+            const char* literals = _literals.data();
+            for(auto& segment: _segments)
+                segment.emit(ost, record, writer, literals + segment.offset, segment.size);
+        }
+
+    private:
+        using Emitter = void (*)(std::ostream&, Record const&, WriterFunc, const char*, std::size_t);
+
+        struct Segment
+        {
+            Emitter     emit;
+            std::size_t offset;     ///< Offset of segment's literal text in `_literals`
+            std::size_t size;       ///< Length of segment's literal text
+        };
+
+        std::string             _literals;
+        std::vector<Segment>    _segments;
+    };
+    /** Formats message into intermediate buffer, then writes it escaped
+     */
+    void write_escaped(std::ostream& ost, util::escape::Mode mode, WriterFunc writer);
+    /** Formatter which escapes message, for sinks which write it as is
+     *
+     *  Compatible with `FormattedLogger`. To escape message inside layout, put sanitizer
+     *  in front of it, or use `%J` and `%M` directives:
+     *  @code
+     *  auto logger = make_formatted_logger(Sanitizer(), make_formatted_logger(Layout("%T %m"), FileLogger("app.log", true)));
+     *  @endcode
+     */
+    class Sanitizer
+    {
+    public:
+        explicit Sanitizer(util::escape::Mode mode = util::escape::Mode::Line)
+            : _mode(mode)
+        { }
+
+        void operator()(std::ostream& ost, Record const&, WriterFunc writer) const
+        {
+            write_escaped(ost, _mode, writer);
+        }
+
+    private:
+        util::escape::Mode  _mode;
+    };
+} // namespace log
+} // namespace toolboxcpp
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <ostream>
 
 #include <toolboxcpp/util/FuncRef.hpp>
@@ -34,9 +35,9 @@
     @param[in] $target      Target name
     @param[in] $location    File and line where logging happens
 */
-#define $log_error_at($channel, $location, ...) $log_perform_write_fmt(::toolboxcpp::log::Severity::Error,   $channel, $location, ## __VA_ARGS__)
-#define $log_warn_at($channel, $location, ...)  $log_perform_write_fmt(::toolboxcpp::log::Severity::Warning, $channel, $location, ## __VA_ARGS__)
-#define $log_info_at($channel, $location, ...)  $log_perform_write_fmt(::toolboxcpp::log::Severity::Info,    $channel, $location, ## __VA_ARGS__)
+#define $log_error_at($channel, $location, ...) $log_perform_write_site_fmt(::toolboxcpp::log::Severity::Error,   $channel, $location, ## __VA_ARGS__)
+#define $log_warn_at($channel, $location, ...)  $log_perform_write_site_fmt(::toolboxcpp::log::Severity::Warning, $channel, $location, ## __VA_ARGS__)
+#define $log_info_at($channel, $location, ...)  $log_perform_write_site_fmt(::toolboxcpp::log::Severity::Info,    $channel, $location, ## __VA_ARGS__)
 /*
     Evaluate if LOG_FACADE_DETAILED should be defined
 */
@@ -47,8 +48,8 @@
     Two lowest levels of logging are compiled-in only in debug mode or if explicitly enabled via macro
 */
 #ifdef TOOLBOX_LOG_DETAILED
-#   define $log_debug_at($channel, $location, ...) $log_perform_write_fmt(::toolboxcpp::log::Severity::Debug, $channel, $location, ## __VA_ARGS__)
-#   define $log_trace_at($channel, $location, ...) $log_perform_write_fmt(::toolboxcpp::log::Severity::Trace, $channel, $location, ## __VA_ARGS__)
+#   define $log_debug_at($channel, $location, ...) $log_perform_write_site_fmt(::toolboxcpp::log::Severity::Debug, $channel, $location, ## __VA_ARGS__)
+#   define $log_trace_at($channel, $location, ...) $log_perform_write_site_fmt(::toolboxcpp::log::Severity::Trace, $channel, $location, ## __VA_ARGS__)
 #else
 #   define $log_debug_at($channel, $location, ...) (void())
 #   define $log_trace_at($channel, $location, ...) (void())
@@ -79,7 +80,64 @@
         : (void())                                                                  \
     )                                                                               \
 /**/
+/**
+    Same as $log_perform_write_fmt, but also registers current callsite, see $LogCurrentSite
+    
+    @param[in] $severity    log severity level; must be a constant expression
+    @param[in] $channel     log channel, defined by application
+    @param[in] $location    file and line which should be used in log message as location
+    @param[in] ...          Epsilon argument, set of values which should be written to log
+*/
+#define $log_perform_write_site_fmt($severity, $channel, $location, ...)                                        \
+    $log_perform_write_site($LogCurrentSite($severity), $severity, $channel, $location, $log_format(__VA_ARGS__)) \
+/**/
+/**
+    Same as $log_perform_write, but attributes record to specified callsite,
+    which can be switched off at runtime, see `toolboxcpp/log/Sites.hpp`
 
+    Site is evaluated once, by the check, so $LogCurrentSite defines single descriptor per callsite;
+    write takes it back from the check. Like the rest of logging macros, it's usable in any scope,
+    and message arguments are evaluated only if record is going to be written.
+    
+    @param[in] $site        callsite identifier, usually produced by $LogCurrentSite
+    @param[in] $severity    log severity level
+    @param[in] $channel     log channel, defined by application
+    @param[in] $location    file and line which should be used in log message as location
+    @param[in] $fmtfunc     Formatter function, writes message into provided stream
+*/
+#define $log_perform_write_site($site, $severity, $channel, $location, $fmtfunc) (                  \
+    ::toolboxcpp::log::impl::enter_site($site, $severity, $channel, $location)                       \
+        ? ::toolboxcpp::log::impl::write(                                                             \
+            ::toolboxcpp::log::impl::SiteWrite { ::toolboxcpp::log::impl::entered_site(), $fmtfunc }, \
+            $severity, $channel, $location)                                                           \
+        : (void())                                                                                    \
+    )                                                                                                 \
+/**/
+/** Substitutes with identifier of current callsite
+    
+    Each expansion defines constant descriptor of the site - severity, channel of current scope,
+    file and line - which is registered during static initialization, so every site linked
+    into program can be listed and toggled before it's ever reached.
+    Expansions with the same file, line and severity share single identifier.
+    Defining `TOOLBOX_LOG_NO_SITES` turns registration off, all sites then get identifier 0.
+    
+    @param[in] $severity    log severity level; must be a constant expression
+*/
+#ifndef TOOLBOX_LOG_NO_SITES
+#   define $LogCurrentSite($severity) ([]() -> ::toolboxcpp::log::SiteId {                         \
+        struct Tag                                                                                  \
+        {                                                                                           \
+            static ::toolboxcpp::log::Site site()                                                   \
+            {                                                                                       \
+                return ::toolboxcpp::log::Site { 0, $severity, $LogCurrentChannel, __FILE__, nullptr, __LINE__ }; \
+            }                                                                                       \
+        };                                                                                          \
+        return ::toolboxcpp::log::impl::SiteOf<Tag>::id;                                            \
+    }())                                                                                            \
+/**/
+#else
+#   define $LogCurrentSite($severity) (::toolboxcpp::log::SiteId())
+#endif
 /** Substitutes with current 'channel' defined in current scope
 */
 #define $LogCurrentChannel (__toolbox_log_get_channel__(::toolboxcpp::log::impl::AdlTag {}, 0))
@@ -89,7 +147,14 @@
 /** Defines default log formatting method, which simply dumps all specified expressions to provided stream
     Any override must be a macro which accepts variadic number of arguments and generates callable
     which accepts `std::ostream&` and returns nothing
+    Defining `TOOLBOX_LOG_FAST_FORMAT` selects formatter with fast paths for numbers and timestamps
 */
+#if !(defined $log_format) && (defined TOOLBOX_LOG_FAST_FORMAT)
+#   include "FastFmt.hpp"
+/** @brief Log formatting method which encodes numbers and timestamps without stream facets
+*/
+#   define $log_format(...) (::toolboxcpp::log::fast_format(__VA_ARGS__))
+#endif
 #ifndef $log_format
 //  Contains implementation of defaultFormat which is a bit complicated to be shown here
 #   include "DefaultFmt.hpp"
@@ -122,6 +187,19 @@ namespace log
 
     using Channel       = const char*;
     using WriterFunc    = toolboxcpp::util::FuncRef<void(std::ostream&)>;
+    /// Dense identifier of logging callsite, starting from 1; 0 means record isn't attributed to any site
+    using SiteId        = std::uint32_t;
+    /** @brief Descriptor of single logging macro invocation
+     */
+    struct Site
+    {
+        SiteId      id;         ///< Assigned on registration
+        Severity    severity;
+        Channel     channel;    ///< Channel of the scope where macro is invoked
+        const char* file;
+        const char* basename;   ///< File name without directories, assigned on registration
+        int         line;
+    };
 
 namespace impl
 {
@@ -146,6 +224,42 @@ namespace impl
         @param  writer      Function which receives stream and writes logging message into it
     */
     void write(Severity severity, Channel channel, Location location, WriterFunc writer);
+    /// Same as above, but also checks if callsite is switched on
+    bool is_enabled(SiteId site, Severity severity, Channel channel, Location location);
+    /// Same as above, but attributes record to callsite
+    void write(SiteId site, Severity severity, Channel channel, Location location, WriterFunc writer);
+    /// Same as `is_enabled` above, and remembers site for `entered_site` on current thread
+    bool enter_site(SiteId site, Severity severity, Channel channel, Location location);
+    /// Site passed to the last `enter_site` on current thread
+    SiteId entered_site() noexcept;
+    /** Callsite and message of single write
+
+        Braced initializer takes `entered_site` before message arguments are evaluated,
+        so log statements nested in those arguments don't affect record's site
+    */
+    struct SiteWrite
+    {
+        SiteId      site;
+        WriterFunc  writer;
+    };
+    /// Same as write with site, but takes site and message together
+    void write(SiteWrite const& site_write, Severity severity, Channel channel, Location location);
+    /**
+        Registers callsite descriptor
+        
+        @param  site    Site descriptor; registry copies its strings
+        @return         Identifier of the site, which is shared by all descriptors with same file, line and severity
+    */
+    SiteId attach_site(Site const& site);
+    /// Holds identifier of callsite described by `Tag::site()`, obtained during static initialization
+    template<typename Tag>
+    struct SiteOf
+    {
+        static SiteId const id;
+    };
+
+    template<typename Tag>
+    SiteId const SiteOf<Tag>::id = attach_site(Tag::site());
     /// Enables ADL-based deduction on which "log channel" function to use
     struct AdlTag {};
     /// Returns default log channel, empty string in our case
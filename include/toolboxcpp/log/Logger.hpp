@@ -1,9 +1,13 @@
 #pragma once
 
 #include <toolboxcpp/log/Log.hpp>
+#include <toolboxcpp/log/Context.hpp>
 
 #include <chrono>
+#include <cstddef>
 #include <memory>
+#include <ostream>
+#include <utility>
 
 namespace toolboxcpp
 {
@@ -17,7 +21,22 @@ namespace log
         Severity    severity;
         Channel     channel;
         Location    location;
+        SiteId      site;       ///< Callsite which produced record, 0 if unknown; see `toolboxcpp/log/Sites.hpp`
     };
+    /** Returns upper-case name of severity level, like `ERROR`
+     */
+    const char* severity_name(Severity severity) noexcept;
+namespace impl
+{
+    /// Severity name with its length, for writers which shouldn't measure it every time
+    struct SeverityName
+    {
+        const char*     text;
+        std::size_t     size;
+    };
+    /// Same as `severity_name`, with length
+    SeverityName const& severity_name_of(Severity severity) noexcept;
+} // namespace impl
     /// Timestamp type for logger record
     using Timestamp = std::chrono::system_clock::time_point;
     /** Contains initial metadata and additional info which is
@@ -26,7 +45,54 @@ namespace log
     struct Record: public Metadata
     {
         Timestamp   timestamp;
+        Context     context;    ///< Context of the writing thread, see @ref Context on its lifetime
     };
+    /** Record with its message formatted in advance, element of batch passed to `write_batch`
+     */
+    struct BatchEntry
+    {
+        Record          record;
+        const char*     message;    ///< Message text, not null-terminated
+        std::size_t     size;       ///< Message size
+    };
+    /** Writes message of batch entry into stream
+     */
+    inline void write_message(std::ostream& ost, BatchEntry const& entry)
+    {
+        ost.write(entry.message, static_cast<std::streamsize>(entry.size));
+    }
+
+namespace impl
+{
+    template<typename L>
+    auto write_batch(L& logger, BatchEntry const* entries, std::size_t count, int)
+        -> decltype(logger.write_batch(entries, count), void())
+    {
+        logger.write_batch(entries, count);
+    }
+
+    template<typename L>
+    void write_batch(L& logger, BatchEntry const* entries, std::size_t count, long)
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            auto& entry = entries[i];
+            if(logger.is_enabled(entry.record))
+                logger.write(entry.record, [&](std::ostream& ost) { write_message(ost, entry); });
+        }
+    }
+}
+    /** Passes batch of records to logger, through its `write_batch` method if it has one,
+     *  or record by record through `is_enabled` and `write` otherwise
+     *
+     *  Unlike `write`, batch isn't checked with `is_enabled` by caller: logger skips disabled records itself.
+     *  Entries, and messages they point to, are valid only during the call.
+     */
+    template<typename L>
+    void write_batch(L& logger, BatchEntry const* entries, std::size_t count)
+    {
+        impl::write_batch(logger, entries, count, 0);
+    }
     /** Polymorphic interface for all logger implementations
      */
     class Logger
@@ -42,6 +108,15 @@ namespace log
          *  @param  writer  Message writer func which accepts reference to STL stream and writes message into it
          */
         virtual void write(Record const& record, WriterFunc writer) = 0;
+        /** Write batch of records with already formatted messages, skipping disabled ones
+         *  Default implementation writes enabled records one by one
+         *  @param  entries Records and their messages
+         *  @param  count   Number of entries
+         */
+        virtual void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            impl::write_batch(*this, entries, count, 0L);
+        }
         /** Destructor
          */
         virtual ~Logger() {}
@@ -55,6 +130,9 @@ namespace log
      *  In latter case, pointed-to object is never deleted.
      *  Such approach should allow to cover more scenarios.
      *  
+     *  If bootstrap buffer is enabled, see `toolboxcpp/log/Bootstrap.hpp`, its records are replayed
+     *  into logger before it becomes current one.
+     *
      *  @param      logger                  On-heap logger object
      *  @exception  std::invalid_argument   If logger is nullptr
      *  @exception  std::logic_error        If logger was already initialized
@@ -85,6 +163,10 @@ namespace log
             {
                 logger.write(rec, writer);
             }
+            void write_batch(BatchEntry const* entries, std::size_t count) override
+            {
+                log::write_batch(logger, entries, count);
+            }
         
             typename std::decay<L>::type logger;
         };
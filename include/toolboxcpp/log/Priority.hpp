@@ -0,0 +1,193 @@
+#pragma once
+/** Queued logger with separate lane per severity, so important records overtake backlog of less important ones
+ *
+ *  Every severity gets its own bounded queue. Consumer takes records from lanes in weighted round-robin:
+ *  on every round, lane may give up to its weight records, starting from errors. So error written
+ *  behind thousands of debug records waits for at most one round, while debug lane still gets
+ *  its share of every round and isn't starved.
+ */
+#include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/log/Queue.hpp>
+#include <toolboxcpp/util/FuncRef.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace priority
+{
+    /// Number of lanes, one per severity from `Error` to `Trace`
+    static constexpr std::size_t LaneCount = static_cast<std::size_t>(Severity::_Count) - 1;
+    /** Lane of records with single severity; `None` records go to `Trace` lane
+     */
+    inline std::size_t lane_of(Severity severity) noexcept
+    {
+        return severity == Severity::None || severity >= Severity::_Count
+            ? LaneCount - 1
+            : static_cast<std::size_t>(severity) - 1;
+    }
+    /// Settings of single lane
+    using Lane = queue::Lane;
+    /** Lane settings, indexed by @ref lane_of
+     */
+    struct Options
+    {
+        std::array<Lane, LaneCount> lanes = {{
+            { 4096,     16 },   // Error
+            { 4096,     8  },   // Warning
+            { 16384,    4  },   // Info
+            { 16384,    2  },   // Debug
+            { 16384,    1  },   // Trace
+        }};
+    };
+    /// Statistics of single lane
+    using LaneStats = queue::LaneStats;
+    /// Statistics of all lanes, indexed by @ref lane_of
+    using Stats = std::array<LaneStats, LaneCount>;
+    /** Bounded per-severity queues, @ref RecordQueue with lane per severity
+     *
+     *  Any number of threads may push; there should be single consumer.
+     */
+    class Lanes
+    {
+    public:
+        explicit Lanes(Options const& options = Options());
+        ~Lanes();
+
+        Lanes(Lanes const&)            = delete;
+        Lanes& operator=(Lanes const&) = delete;
+        /** Formats message and queues record into its lane
+         *  @return false if lane was full and record got dropped
+         */
+        bool push(Record const& record, WriterFunc writer);
+        /** Takes records in weighted priority order and passes them to consumer
+         *
+         *  Consumer is called without internal lock held, so writers aren't blocked by it.
+         *  @param  consumer    Receives record and its message
+         *  @param  max_records Maximal number of records taken by this call
+         *  @return             Number of records taken
+         */
+        std::size_t pop(util::FuncRef<void (Record const&, WriterFunc)> consumer, std::size_t max_records);
+        /** Same as @ref pop, but passes all taken records to consumer at once, as single batch
+         */
+        std::size_t pop_batch(util::FuncRef<void (BatchEntry const*, std::size_t)> consumer, std::size_t max_records);
+        /** Waits until there's something to take, or timeout expires, or @ref wake is called
+         *  @return true if there are queued records
+         */
+        bool wait(std::chrono::milliseconds timeout);
+        /** Wakes up waiting consumer
+         */
+        void wake();
+        /** Total number of queued records
+         */
+        std::size_t depth() const;
+
+        Stats stats() const;
+
+    private:
+        RecordQueue _queue;
+    };
+} // namespace priority
+    /** Writes records into severity lanes, and passes them to wrapped logger from background thread
+     *
+     *  Writer only formats message and queues it, so it's never blocked by wrapped logger.
+     *  Wrapped logger's `write` and `write_batch` are called from background thread only, and don't need
+     *  to be thread-safe; its `is_enabled` is called from writer threads, and has to be.
+     *  Records still queued on destruction are written before it returns.
+     *
+     *  Background thread is dedicated rather than taken from @ref util::Executor: it waits on lanes
+     *  for logger's whole lifetime, and executor tasks shouldn't block, since they'd hold up
+     *  timers and other tasks queued on the same workers.
+     */
+    template<typename L>
+    class PriorityLogger
+    {
+    public:
+        /** @param  logger  Wrapped logger
+         *  @param  options Lane capacities and weights
+         */
+        PriorityLogger(L logger, priority::Options const& options = priority::Options())
+            : _state(new State(std::move(logger), options))
+        {
+            State* state = _state.get();
+            _state->worker = std::thread([state] { state->run(); });
+        }
+
+        PriorityLogger(PriorityLogger&&) = default;
+
+        ~PriorityLogger()
+        {
+            if(!_state)
+                return;
+            _state->stop.store(true, std::memory_order_relaxed);
+            _state->lanes.wake();
+            _state->worker.join();
+        }
+
+        bool is_enabled(Metadata const& meta)
+        {
+            return _state->logger.is_enabled(meta);
+        }
+
+        void write(Record const& record, WriterFunc writer)
+        {
+            _state->lanes.push(record, writer);
+        }
+        /** Number of records waiting in all lanes
+         */
+        std::size_t pending() const
+        {
+            return _state->lanes.depth();
+        }
+
+        priority::Stats stats() const
+        {
+            return _state->lanes.stats();
+        }
+
+    private:
+        // Kept on heap, so background thread can refer to it while logger object itself is moved around
+        struct State
+        {
+            State(L&& logger, priority::Options const& options)
+                : lanes(options)
+                , logger(std::move(logger))
+                , stop(false)
+            { }
+
+            void run()
+            {
+                run_consumer(lanes, logger, stop, MaxBatch);
+            }
+
+            static constexpr std::size_t MaxBatch = 256;
+
+            priority::Lanes     lanes;
+            L                   logger;
+            std::atomic<bool>   stop;
+            std::thread         worker;
+        };
+
+        std::unique_ptr<State>  _state;
+    };
+    /** Construct priority logger from wrapped logger and lane options
+     */
+    template<typename L>
+    PriorityLogger<typename std::decay<L>::type>
+    make_priority_logger(L&& logger, priority::Options const& options = priority::Options())
+    {
+        return PriorityLogger<typename std::decay<L>::type>(std::forward<L>(logger), options);
+    }
+} // namespace log
+} // namespace toolboxcpp
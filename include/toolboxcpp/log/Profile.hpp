@@ -0,0 +1,99 @@
+#pragma once
+/** Opt-in profiler of logging callsites, which finds lines producing most of log bytes
+ *
+ *  While profiling is on, every record written through logging macros is attributed to its callsite,
+ *  together with size of its formatted message. Counts are kept in fixed-size count-min sketches,
+ *  one per thread, which are updated without locks and merged on read. Each thread also keeps
+ *  small set of its heaviest callsites, which are candidates for @ref profile::top_callsites.
+ *
+ *  Counts are estimates: count-min sketch never underestimates, and overestimates
+ *  by small fraction of total volume at most. Memory taken by profiler doesn't depend
+ *  on number of callsites.
+ */
+#include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/util/Executor.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace profile
+{
+    /// Number of counters in single row of sketch
+    static constexpr std::size_t    SketchWidth     = 1024;
+    /// Number of rows in sketch, each with its own hash function
+    static constexpr std::size_t    SketchDepth     = 4;
+    /// Number of heaviest callsites tracked by each thread
+    static constexpr std::size_t    Candidates      = 32;
+    /** Estimated volume of single callsite
+     */
+    struct Callsite
+    {
+        SiteId          site;       ///< 0 for records written without site registration
+        Location        location;
+        std::uint64_t   bytes;      ///< Formatted message bytes
+        std::uint64_t   records;
+    };
+    /** Switches profiling on or off; it's off initially
+     *
+     *  Counts gathered so far are kept while profiling is off.
+     */
+    void set_enabled(bool enabled) noexcept;
+
+    bool is_enabled() noexcept;
+    /** Returns callsites with most bytes written since profiling was first switched on, heaviest first
+     *  @param  count   Maximal number of callsites returned
+     */
+    std::vector<Callsite> top_callsites(std::size_t count);
+    /** Writes callsites as `file:line bytes=N records=M` entries, separated by `; `
+     */
+    void write_report(std::ostream& ost, std::vector<Callsite> const& callsites);
+    /** Settings of periodic report
+     */
+    struct ReportOptions
+    {
+        std::chrono::milliseconds   interval    = std::chrono::milliseconds(60000);
+        std::size_t                 count       = 10;
+        Severity                    severity    = Severity::Info;
+    };
+    /** Switches profiling on and periodically writes report record to global logger, under `toolboxcpp.log` channel
+     *
+     *  Profiling is switched off on destruction.
+     */
+    class Reporter
+    {
+    public:
+        /** @param  options     Report period, size and severity
+         *  @param  executor    Executor which writes reports; should outlive reporter
+         */
+        explicit Reporter(ReportOptions const& options = ReportOptions(), util::Executor& executor = util::Executor::shared());
+        ~Reporter();
+
+        Reporter(Reporter const&)            = delete;
+        Reporter& operator=(Reporter const&) = delete;
+        /** Writes report right away
+         */
+        void report();
+
+    private:
+        ReportOptions           _options;
+        util::Executor*         _executor;
+        util::executor::TimerId _timer;
+    };
+
+namespace impl
+{
+    /** Writes record through global logger, counting bytes written by formatter
+     *  Called by `log::impl::write` while profiling is on
+     */
+    void write(Logger& logger, Record const& record, WriterFunc writer);
+}
+} // namespace profile
+} // namespace log
+} // namespace toolboxcpp
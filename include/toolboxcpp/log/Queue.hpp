@@ -0,0 +1,147 @@
+#pragma once
+/** Bounded queue of formatted records, shared by loggers which write records from background thread
+ *
+ *  Writer only formats message and copies record into queue; consumer takes records in batches,
+ *  without queue's lock held. Queue may have several lanes, each with its own capacity; consumer
+ *  takes records from them in weighted round-robin.
+ */
+#include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/util/FuncRef.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace log
+{
+    /** Record which owns its message and copy of context, for loggers which keep records after `write` returns
+     *
+     *  Like @ref OwnedContext, it may be freely moved between containers
+     */
+    class OwnedRecord
+    {
+    public:
+        OwnedRecord(Record const& record, std::string&& message);
+
+        OwnedRecord(OwnedRecord&&)                 = default;
+        OwnedRecord& operator=(OwnedRecord&&)      = default;
+        /** Batch entry which refers to this record, valid while record isn't moved or destroyed
+         */
+        BatchEntry entry() const noexcept
+        {
+            BatchEntry entry { _record, _text.data(), _text.size() };
+            entry.record.context = _context.view();
+            return entry;
+        }
+        /** Message size
+         */
+        std::size_t size() const noexcept
+        {
+            return _text.size();
+        }
+
+    private:
+        Record          _record;    ///< Context is kept empty, it's taken from `_context`
+        std::string     _text;
+        OwnedContext    _context;
+    };
+
+namespace queue
+{
+    /** Settings of single lane
+     */
+    struct Lane
+    {
+        std::size_t     capacity;   ///< Maximal number of queued records; records which don't fit are dropped
+        unsigned        weight;     ///< Records taken from lane per round, at least 1
+    };
+    /** Statistics of single lane; all counters except `depth` are cumulative
+     */
+    struct LaneStats
+    {
+        std::uint64_t   queued;     ///< Records accepted into lane
+        std::uint64_t   taken;      ///< Records passed to consumer
+        std::uint64_t   bytes;      ///< Message bytes passed to consumer
+        std::uint64_t   dropped;    ///< Records dropped because lane was full
+        std::size_t     depth;      ///< Records waiting right now
+    };
+    /** Statistics of whole queue
+     */
+    struct Stats
+    {
+        std::vector<LaneStats>  lanes;      ///< In lane order
+        std::uint64_t           batches;    ///< Number of batches passed to consumer
+    };
+} // namespace queue
+    /** Bounded queue of owned records, with one or more lanes
+     *
+     *  On every round, consumer takes up to lane's weight records from each lane, starting from the first one.
+     *  Any number of threads may push; there should be single consumer.
+     */
+    class RecordQueue
+    {
+    public:
+        /** @param  lanes   Settings of each lane, there should be at least one
+         */
+        explicit RecordQueue(std::vector<queue::Lane> const& lanes);
+        ~RecordQueue();
+
+        RecordQueue(RecordQueue const&)            = delete;
+        RecordQueue& operator=(RecordQueue const&) = delete;
+        /** Formats message and queues record into lane
+         *  @return false if lane was full and record got dropped
+         */
+        bool push(std::size_t lane, Record const& record, WriterFunc writer);
+        /** Takes records in weighted round-robin order and passes them to consumer as single batch
+         *
+         *  Consumer is called without internal lock held, so writers aren't blocked by it.
+         *  @param  consumer    Receives taken records; isn't called if there's nothing to take
+         *  @param  max_records Maximal number of records taken by this call
+         *  @return             Number of records taken
+         */
+        std::size_t pop_batch(util::FuncRef<void (BatchEntry const*, std::size_t)> consumer, std::size_t max_records);
+        /** Waits until there's something to take, or timeout expires, or @ref wake is called
+         *  @return true if there are queued records
+         */
+        bool wait(std::chrono::milliseconds timeout);
+        /** Wakes up waiting consumer
+         */
+        void wake();
+        /** Total number of queued records
+         */
+        std::size_t depth() const;
+
+        queue::Stats stats() const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+    /** Passes records from queue to logger in batches, until `stop` is set and queue is drained;
+     *  body of consumer thread of queued loggers
+     *
+     *  @param  queue   @ref RecordQueue, or wrapper over it with the same `pop_batch` and `wait`
+     */
+    template<typename Q, typename L>
+    void run_consumer(Q& queue, L& logger, std::atomic<bool> const& stop, std::size_t max_batch)
+    {
+        auto consumer = [&logger](BatchEntry const* entries, std::size_t count) { log::write_batch(logger, entries, count); };
+        while(true)
+        {
+            bool stopping = stop.load(std::memory_order_relaxed);
+            if(queue.pop_batch(consumer, max_batch) == 0)
+            {
+                if(stopping)
+                    return;
+                queue.wait(std::chrono::milliseconds(100));
+            }
+        }
+    }
+} // namespace log
+} // namespace toolboxcpp
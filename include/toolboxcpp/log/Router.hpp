@@ -0,0 +1,287 @@
+#pragma once
+/** Logger which routes records by channel to separate sinks, each with its own queue and writer thread
+ *
+ *  Channel of record is looked up by its pointer in fixed open-addressing table, so routing costs
+ *  one hash and usually one probe, regardless of number of partitions. Channel which isn't in table yet
+ *  is matched by its text once, and result is cached under its pointer; channels without partition
+ *  go to fallback sink. Channels are expected to be static strings, like ones set by `$LogChannel`:
+ *  pointer which is reused for another text keeps routing to partition of the first one.
+ *
+ *  Slow sink stalls only its own partition: writers format message and queue it, and each partition's
+ *  queue is drained into its sink by dedicated thread.
+ */
+#include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/log/Queue.hpp>
+#include <toolboxcpp/util/FuncRef.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace router
+{
+    /** Router settings
+     */
+    struct Options
+    {
+        std::size_t     capacity        = 16384;    ///< Maximal number of queued records per partition; records which don't fit are dropped
+        std::size_t     max_batch       = 256;      ///< Maximal number of records passed to sink at once
+        std::size_t     channel_slots   = 1024;     ///< Size of channel lookup table, rounded up to power of 2; half of it may be filled
+    };
+    /** Statistics of single partition; all counters except `depth` are cumulative
+     */
+    struct Stats
+    {
+        std::uint64_t   queued;     ///< Records accepted into queue
+        std::uint64_t   written;    ///< Records passed to sink
+        std::uint64_t   bytes;      ///< Message bytes passed to sink
+        std::uint64_t   batches;    ///< Number of batches passed to sink
+        std::uint64_t   dropped;    ///< Records dropped because queue was full
+        std::size_t     depth;      ///< Records waiting right now
+    };
+    /** Maps channels to partition indices
+     *
+     *  Lookup of cached channel takes no lock. When table is half full, channels which aren't cached yet
+     *  are matched by text on every lookup.
+     */
+    class Table
+    {
+    public:
+        /** @param  channels    Channel of each partition, in partition order
+         *  @param  slots       Size of lookup table, rounded up to power of 2
+         */
+        explicit Table(std::vector<std::string> channels, std::size_t slots = Options().channel_slots);
+        ~Table();
+
+        Table(Table const&)            = delete;
+        Table& operator=(Table const&) = delete;
+        /** Finds partition of channel
+         *  @return Partition index, or @ref size if channel has no partition
+         */
+        std::size_t find(Channel channel) const;
+        /** Number of partitions, also index of fallback
+         */
+        std::size_t size() const noexcept;
+        /** Channel of partition, empty for fallback
+         */
+        std::string const& channel(std::size_t index) const noexcept;
+
+    private:
+        std::size_t insert(Channel channel) const;
+
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+    /** Bounded queue of single partition, @ref RecordQueue with single lane
+     *
+     *  Any number of threads may push; there should be single consumer.
+     */
+    class Queue
+    {
+    public:
+        explicit Queue(std::size_t capacity = Options().capacity);
+        ~Queue();
+
+        Queue(Queue const&)            = delete;
+        Queue& operator=(Queue const&) = delete;
+        /** Formats message and queues record
+         *  @return false if queue was full and record got dropped
+         */
+        bool push(Record const& record, WriterFunc writer);
+        /** Takes records in order and passes them to consumer as single batch
+         *
+         *  Consumer is called without internal lock held, so writers aren't blocked by it.
+         *  @return Number of records taken
+         */
+        std::size_t pop_batch(util::FuncRef<void (BatchEntry const*, std::size_t)> consumer, std::size_t max_records);
+        /** Waits until there's something to take, or timeout expires, or @ref wake is called
+         *  @return true if there are queued records
+         */
+        bool wait(std::chrono::milliseconds timeout);
+        /** Wakes up waiting consumer
+         */
+        void wake();
+        /** Number of queued records
+         */
+        std::size_t depth() const;
+
+        Stats stats() const;
+
+    private:
+        RecordQueue _queue;
+    };
+} // namespace router
+    /** Routes records by channel to partition sinks, see `Router.hpp`
+     *
+     *  Sink's `write` and `write_batch` are called from its partition's thread only, and don't need
+     *  to be thread-safe; its `is_enabled` is called from writer threads, and has to be.
+     *  Records still queued on destruction are written before it returns.
+     *
+     *  Partition threads are dedicated, like the one of @ref PriorityLogger, rather than taken from
+     *  @ref util::Executor: each waits on its queue for router's whole lifetime, which would pin
+     *  one executor worker per partition.
+     */
+    template<typename L>
+    class ChannelRouter
+    {
+    public:
+        using Partitions = std::vector<std::pair<std::string, L>>;
+        /** @param  partitions  Channels and their sinks
+         *  @param  fallback    Sink for channels which have no partition, and for records without channel
+         *  @param  options     Queue and lookup table settings
+         */
+        ChannelRouter(Partitions partitions, L fallback, router::Options const& options = router::Options())
+            : _state(new State(std::move(partitions), std::move(fallback), options))
+        {
+            for(auto& partition : _state->partitions)
+            {
+                Partition* target = partition.get();
+                std::size_t max_batch = options.max_batch;
+                partition->worker = std::thread([target, max_batch] { target->run(max_batch); });
+            }
+        }
+
+        ChannelRouter(ChannelRouter&&) = default;
+
+        bool is_enabled(Metadata const& meta)
+        {
+            return partition_of(meta).sink.is_enabled(meta);
+        }
+
+        void write(Record const& record, WriterFunc writer)
+        {
+            partition_of(record).queue.push(record, writer);
+        }
+        /** Number of partitions, excluding fallback
+         */
+        std::size_t size() const noexcept
+        {
+            return _state->table.size();
+        }
+        /** Channel of partition, empty for fallback
+         */
+        std::string const& channel(std::size_t index) const noexcept
+        {
+            return _state->table.channel(index);
+        }
+        /** Number of records waiting in all partitions
+         */
+        std::size_t pending() const
+        {
+            std::size_t depth = 0;
+            for(auto& partition : _state->partitions)
+                depth += partition->queue.depth();
+            return depth;
+        }
+        /** Statistics of each partition, in constructor order; fallback is the last one
+         */
+        std::vector<router::Stats> stats() const
+        {
+            std::vector<router::Stats> stats;
+            stats.reserve(_state->partitions.size());
+            for(auto& partition : _state->partitions)
+                stats.push_back(partition->queue.stats());
+            return stats;
+        }
+
+    private:
+        struct Partition
+        {
+            Partition(L&& sink, std::size_t capacity)
+                : queue(capacity)
+                , sink(std::move(sink))
+                , stop(false)
+            { }
+
+            void run(std::size_t max_batch)
+            {
+                run_consumer(queue, sink, stop, max_batch);
+            }
+
+            router::Queue       queue;
+            L                   sink;
+            std::atomic<bool>   stop;
+            std::thread         worker;
+        };
+        // Kept on heap, so background threads can refer to it while logger object itself is moved around
+        struct State
+        {
+            State(Partitions&& partitions, L&& fallback, router::Options const& options)
+                : table(channels_of(partitions), options.channel_slots)
+            {
+                this->partitions.reserve(partitions.size() + 1);
+                for(auto& partition : partitions)
+                    this->partitions.emplace_back(new Partition(std::move(partition.second), options.capacity));
+                this->partitions.emplace_back(new Partition(std::move(fallback), options.capacity));
+            }
+            // Workers are stopped together, so partitions are drained in parallel
+            ~State()
+            {
+                for(auto& partition : partitions)
+                {
+                    partition->stop.store(true, std::memory_order_relaxed);
+                    partition->queue.wake();
+                }
+                for(auto& partition : partitions)
+                    if(partition->worker.joinable())
+                        partition->worker.join();
+            }
+
+            static std::vector<std::string> channels_of(Partitions const& partitions)
+            {
+                std::vector<std::string> channels;
+                channels.reserve(partitions.size());
+                for(auto& partition : partitions)
+                    channels.push_back(partition.first);
+                return channels;
+            }
+
+            router::Table                           table;
+            std::vector<std::unique_ptr<Partition>> partitions; ///< Indexed by table; fallback is the last one
+        };
+
+        Partition& partition_of(Metadata const& meta) const
+        {
+            return *_state->partitions[_state->table.find(meta.channel)];
+        }
+
+        std::unique_ptr<State>  _state;
+    };
+    /** Construct channel router which makes sink of each partition with provided function
+     *
+     *  @code
+     *  auto router = make_channel_router({ "net", "db" }, [](std::string const& channel) {
+     *      std::string path = (channel.empty() ? "other" : channel) + ".log";
+     *      return FileLogger(path.c_str(), true);
+     *  });
+     *  @endcode
+     *
+     *  @param  channels    Channel of each partition
+     *  @param  make_sink   Called with each channel, and then with empty string for fallback sink
+     *  @param  options     Queue and lookup table settings
+     */
+    template<typename F>
+    ChannelRouter<typename std::decay<decltype(std::declval<F&>()(std::string()))>::type>
+    make_channel_router(std::vector<std::string> const& channels, F&& make_sink, router::Options const& options = router::Options())
+    {
+        using Sink = typename std::decay<decltype(make_sink(std::string()))>::type;
+        typename ChannelRouter<Sink>::Partitions partitions;
+        partitions.reserve(channels.size());
+        for(auto& channel : channels)
+            partitions.emplace_back(channel, make_sink(channel));
+        auto fallback = make_sink(std::string());
+        return ChannelRouter<Sink>(std::move(partitions), std::move(fallback), options);
+    }
+} // namespace log
+} // namespace toolboxcpp
@@ -0,0 +1,88 @@
+#pragma once
+/** File sink which writes into preallocated fixed-size segment files
+ *
+ *  POSIX; on Linux segments are reserved with `fallocate` and written back with `sync_file_range`,
+ *  elsewhere `posix_fallocate` is used and writeback is left to the system
+ */
+#include <toolboxcpp/log/Logger.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace segment
+{
+    /** Tuning knobs for @ref SegmentLogger
+     */
+    struct Options
+    {
+        /// Bytes reserved for every segment file
+        std::size_t     segment_size        = 64 << 20;
+        /// Writeback of written data is started each time write cursor advances by this much
+        std::size_t     sync_chunk          = 1 << 20;
+        /// Reserve next segment on shared executor in advance, so that switching to it is cheap
+        bool            preallocate_next    = true;
+    };
+    /** Sink statistics, all counters are cumulative
+     */
+    struct Stats
+    {
+        std::uint64_t   written_bytes;  ///< Bytes written to segments
+        std::uint64_t   segments;       ///< Segments opened, including the first one
+        std::uint64_t   range_syncs;    ///< Writeback requests issued behind write cursor
+        std::uint64_t   errors;         ///< Failed writes; their data is dropped
+    };
+    /** Name of segment file with specified index: base path followed by dot and 6-digit index
+     */
+    std::string segment_path(std::string const& base_path, std::size_t index);
+} // namespace segment
+    /** Appends newline-terminated messages to sequence of preallocated segment files
+     *
+     *  Each segment has its blocks reserved up front, so writes into it don't make filesystem
+     *  allocate space or extend file on the write path. Writer switches to next segment
+     *  when record doesn't fit into the rest of the current one. Data behind write cursor is pushed
+     *  to disk with asynchronous `sync_file_range`, one `sync_chunk` at a time, which keeps amount
+     *  of dirty pages small without ever issuing full `fsync`. Unused tail of the segment is cut off
+     *  when the segment is closed.
+     *
+     *  Segment which wasn't closed properly keeps zero-filled tail after the last record.
+     */
+    class SegmentLogger
+    {
+    public:
+        /** Starts with the first segment index which isn't taken by existing file
+         *  @param      base_path           Path prefix of segment files, see @ref segment::segment_path
+         *  @param      options             Segment options
+         *  @exception  std::system_error   If first segment can't be created
+         */
+        explicit SegmentLogger(std::string const& base_path, segment::Options const& options = segment::Options());
+
+        SegmentLogger(SegmentLogger&&);
+        SegmentLogger& operator=(SegmentLogger&&);
+        /** Closes current segment, truncating its unused tail, and removes preallocated spare one
+         */
+        ~SegmentLogger();
+
+        bool is_enabled(Metadata const&) { return true; }
+
+        void write(Record const& record, WriterFunc writer);
+        /** Starts writeback of everything written so far and waits for it to finish
+         */
+        void flush();
+        /** Path of segment being written
+         */
+        std::string current_path() const;
+
+        segment::Stats stats() const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+} // namespace log
+} // namespace toolboxcpp
@@ -0,0 +1,204 @@
+#pragma once
+/** Shared-memory log ring, written by many processes and drained by single collector
+ *
+ *  POSIX-only. Ring is a named shared memory object with fixed number of fixed-size slots.
+ *  Producers, whether threads or processes, reserve slots without locks and mark each one
+ *  committed once it's filled. Collector reads committed slots in reservation order.
+ *  Slot reserved by producer which died before committing it is skipped, so crashed
+ *  producer doesn't stall the others. Collector process is built as `toolboxcpp_collector` target.
+ */
+#include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/util/FuncRef.hpp>
+#include <toolboxcpp/util/Resource.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace shm
+{
+    /** Ring geometry and collector tuning
+     *  Geometry is used only by whoever creates the ring; others take it from ring itself
+     */
+    struct Options
+    {
+        /// Size of single slot, including its header; message which doesn't fit is truncated
+        std::size_t                 slot_size       = 512;
+        /// Number of slots; records are dropped while ring is full
+        std::size_t                 slots           = 4096;
+        /// Collector skips reserved slot whose live or unknown owner doesn't commit it for that long
+        std::chrono::milliseconds   abandon_after   = std::chrono::milliseconds(1000);
+    };
+    /** Producer statistics, all counters are cumulative
+     */
+    struct Stats
+    {
+        std::uint64_t   written;    ///< Records committed
+        std::uint64_t   dropped;    ///< Records dropped because ring was full
+        std::uint64_t   truncated;  ///< Records which didn't fit into slot
+    };
+    /** Collector statistics, all counters are cumulative
+     */
+    struct CollectorStats
+    {
+        std::uint64_t   collected;  ///< Records delivered
+        std::uint64_t   abandoned;  ///< Slots skipped because their producer died or stalled
+        std::uint64_t   dropped;    ///< Records dropped by all producers of all rings, as counted in rings
+    };
+    /** Record read from ring
+     */
+    struct Entry
+    {
+        Timestamp       timestamp;
+        Severity        severity;
+        int             pid;        ///< Producer process
+        std::string     channel;
+        std::string     message;
+        bool            truncated;
+    };
+    /** Unmaps shared memory region of known size
+     */
+    struct Unmap
+    {
+        std::size_t size;
+        void operator()(void* address) const noexcept;
+    };
+    /// Owned shared memory mapping
+    using Mapping = util::Resource<void*, Unmap>;
+
+namespace impl
+{
+    static constexpr std::uint32_t  Magic   = 0x52474C54;   // "TLGR"
+    static constexpr std::uint32_t  Version = 2;
+    /** Ring header, followed by slots
+     *
+     *  Slot for ticket T is free while its sequence is T, committed when it's T + 1,
+     *  and becomes free for ticket T + slots once collector consumes or abandons it.
+     *  Producer reserves ticket by advancing head, and then claims slot's data by CAS on its claim word;
+     *  only claim owner writes the data, so slot abandoned by collector is never written by two producers
+     */
+    struct Header
+    {
+        std::atomic<std::uint32_t>  magic;      ///< Set last by creator, once ring is initialized
+        std::uint32_t               version;
+        std::uint32_t               slot_size;
+        std::uint32_t               slots;
+        alignas(64)
+        std::atomic<std::uint64_t>  head;       ///< Next ticket to reserve
+        alignas(64)
+        std::atomic<std::uint64_t>  tail;       ///< Next ticket to collect
+        std::atomic<std::uint64_t>  dropped;
+    };
+
+    /// States of slot claim, kept in low bits of claim word; the rest is ticket
+    enum Claim : std::uint64_t
+    {
+        Unclaimed   = 0,    ///< Free for its ticket
+        Owned       = 1,    ///< Data is being written by producer of its ticket
+        Abandoned   = 2,    ///< Collector gave up on owner, which may still write data
+        Released    = 3,    ///< Owner of abandoned slot is done with it; free for any later ticket
+    };
+
+    inline std::uint64_t claim_of(std::uint64_t ticket, Claim state) noexcept
+    {
+        return ticket << 2 | state;
+    }
+
+    struct Slot
+    {
+        std::atomic<std::uint64_t>  seq;
+        std::atomic<std::uint64_t>  claim;      ///< See @ref Claim
+        std::atomic<std::int32_t>   pid;        ///< Owner of claim, 0 while unknown
+        std::uint32_t               size;
+        std::int64_t                timestamp;  ///< Nanoseconds since epoch
+        std::uint8_t                severity;
+        std::uint8_t                truncated;
+        std::uint8_t                channel_size;
+        char                        channel[29];
+
+        char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    inline Slot* slot_at(Header* header, std::uint64_t ticket) noexcept
+    {
+        char* base = reinterpret_cast<char*>(header) + sizeof(Header);
+        return reinterpret_cast<Slot*>(base + (ticket % header->slots) * header->slot_size);
+    }
+    /** Opens ring with specified name, creating and initializing it if it doesn't exist
+     *  @exception  std::system_error   If shared memory object can't be created or mapped
+     *  @exception  std::runtime_error  If object isn't a compatible ring, or its creator didn't finish initializing it
+     */
+    Mapping open_ring(std::string const& name, Options const& options);
+}
+} // namespace shm
+    /** Writes records into shared-memory ring
+     *
+     *  Message is formatted on caller thread, then copied into reserved slot, so slot stays
+     *  uncommitted only for the duration of copy. When ring is full, record is dropped and counted
+     *  both locally and in ring itself. Logger created before `fork` may be used by child process.
+     */
+    class ShmLogger
+    {
+    public:
+        /** Attaches to ring, creating it if needed
+         *  @param  name    Shared memory object name, like `/myapp-log`
+         *  @param  options Ring geometry, used if ring is created
+         */
+        explicit ShmLogger(std::string const& name, shm::Options const& options = shm::Options());
+
+        ShmLogger(ShmLogger&&);
+        ShmLogger& operator=(ShmLogger&&);
+        ~ShmLogger();
+
+        bool is_enabled(Metadata const&) { return true; }
+
+        void write(Record const& record, WriterFunc writer);
+
+        shm::Stats stats() const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+    /** Drains one or more rings
+     *
+     *  There should be single collector per ring. Collector position is kept in ring,
+     *  so restarted collector continues where previous one stopped.
+     */
+    class ShmCollector
+    {
+    public:
+        /** Attaches to rings, creating missing ones
+         *  @param  names   Shared memory object names
+         *  @param  options Ring geometry and abandon timeout
+         */
+        explicit ShmCollector(std::vector<std::string> const& names, shm::Options const& options = shm::Options());
+
+        ShmCollector(ShmCollector&&);
+        ShmCollector& operator=(ShmCollector&&);
+        ~ShmCollector();
+        /** Takes all committed records from all rings and passes them to consumer, ordered by timestamp
+         *
+         *  Records with equal timestamps keep their ring's reservation order. Records are ordered
+         *  only within single call; record committed late may precede ones delivered earlier.
+         *  @param  consumer    Functor which receives records
+         *  @return             Number of records delivered
+         */
+        std::size_t drain(util::FuncRef<void (shm::Entry const&)> consumer);
+
+        shm::CollectorStats stats() const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+} // namespace log
+} // namespace toolboxcpp
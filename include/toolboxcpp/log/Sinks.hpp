@@ -23,6 +23,18 @@ namespace log
             writer(std::cout);
             std::cout << std::endl;
         }
+
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                write_message(std::cout, entries[i]);
+                std::cout << '\n';
+            }
+            std::cout.flush();
+        }
+
+        void flush() { std::cout.flush(); }
     };
     /** Writes all messages to standard error stream
      */
@@ -37,14 +49,30 @@ namespace log
             writer(std::cerr);
             std::cerr << std::endl;
         }
+
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                write_message(std::cerr, entries[i]);
+                std::cerr << '\n';
+            }
+            std::cerr.flush();
+        }
+
+        void flush() { std::cerr.flush(); }
     };
     /** Writes all messages to file stream
+     *
+     *  By default stream is flushed after every message, or once per batch passed to `write_batch`.
+     *  Without per-message flush, wrap logger into @ref FlushingLogger to flush it periodically in background
      */
     struct FileLogger
     {
     public:
-        FileLogger(const char* path, bool append)
+        FileLogger(const char* path, bool append, bool flush_each = true)
             : _file(path, append ? std::ios_base::app : std::ios_base::out)
+            , _flush_each(flush_each)
         { }
 
         bool is_enabled(Metadata const&) { return true; }
@@ -52,10 +80,27 @@ namespace log
         void write(Record const&, WriterFunc writer)
         {
             writer(_file);
-            _file << std::endl;
+            if(_flush_each)
+                _file << std::endl;
+            else
+                _file << '\n';
+        }
+
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                write_message(_file, entries[i]);
+                _file << '\n';
+            }
+            if(_flush_each)
+                _file.flush();
         }
+
+        void flush() { _file.flush(); }
     private:
-        std::ofstream _file;
+        std::ofstream   _file;
+        bool            _flush_each;
     };
 }
 }
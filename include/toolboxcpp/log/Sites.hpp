@@ -0,0 +1,48 @@
+#pragma once
+/** Registry of logging callsites
+ *
+ *  Every `$log_*` macro invocation with constant severity registers descriptor of its site
+ *  during static initialization. Registered sites can be listed and switched on and off
+ *  at runtime, one by one; records carry identifier of their site, see `Metadata::site`,
+ *  which allows compact output with site details written out separately.
+ *
+ *  Sites from code which is loaded after start, like `dlopen`-ed libraries, are registered
+ *  on load and keep their identifiers after unload; registry keeps its own copies of site
+ *  strings, so their descriptors stay valid too.
+ */
+#include <cstddef>
+#include <vector>
+
+#include <toolboxcpp/log/Log.hpp>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace sites
+{
+    /// Number of sites which can be switched off; sites beyond that are always enabled
+    static constexpr std::size_t MaxToggled = 65536;
+    /** Number of sites registered so far; site identifiers are `1 .. count()`
+     */
+    std::size_t count() noexcept;
+    /** Returns descriptor of registered site
+     *  @param      id                  Site identifier
+     *  @exception  std::out_of_range   If there's no site with such identifier
+     */
+    Site get(SiteId id);
+    /** Returns descriptors of all registered sites, ordered by identifier
+     */
+    std::vector<Site> list();
+    /** Checks if writing from site is switched on; unknown sites are always on
+     */
+    bool is_enabled(SiteId id) noexcept;
+    /** Switches writing from site on or off; all sites are on initially
+     *  @param      id                  Site identifier
+     *  @param      enabled             New state of the site
+     *  @exception  std::out_of_range   If there's no site with such identifier, or it's beyond @ref MaxToggled
+     */
+    void set_enabled(SiteId id, bool enabled);
+} // namespace sites
+} // namespace log
+} // namespace toolboxcpp
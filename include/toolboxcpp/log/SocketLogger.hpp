@@ -0,0 +1,117 @@
+#pragma once
+/** Sink which ships log records to local collector over Unix domain socket or FIFO
+ *
+ *  POSIX-only. Callers never touch the socket: records are queued into bounded buffer
+ *  and sent in batches by background thread, which also reconnects to collector
+ *  when connection gets lost
+ */
+#include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/util/Resource.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace socket
+{
+    /** Closes POSIX file descriptor; -1 is used as empty descriptor value
+     */
+    struct FdCloser
+    {
+        static int zero() noexcept { return -1; }
+        void operator()(int fd) const noexcept;
+    };
+    /// Owned POSIX file descriptor
+    using FileDescriptor = util::Resource<int, FdCloser>;
+    /** Produces connected descriptor, or empty one if peer isn't available right now
+     *  Called from background thread only
+     */
+    using Connector = std::function<FileDescriptor()>;
+    /** Connects to Unix domain stream socket bound at specified path
+     */
+    Connector unix_stream(std::string path);
+    /** Connects to Unix domain datagram socket bound at specified path
+     *  Each batch is sent as single datagram, records are separated by newlines
+     */
+    Connector unix_datagram(std::string path);
+    /** Opens FIFO at specified path for writing, without blocking if there's no reader yet
+     */
+    Connector fifo(std::string path);
+    /** Tuning knobs for @ref SocketLogger
+     */
+    struct Options
+    {
+        /// Maximal number of records sent with single `sendmsg` call
+        std::size_t                 max_batch           = 64;
+        /// Maximal number of message bytes kept in memory; records which don't fit are dropped
+        std::size_t                 buffer_limit        = 1 << 20;
+        /// Delay between reconnection attempts while peer is down
+        std::chrono::milliseconds   reconnect_interval  = std::chrono::milliseconds(500);
+    };
+    /** Sink statistics, all counters are cumulative
+     */
+    struct Stats
+    {
+        std::uint64_t   sent_records;       ///< Records handed over to the kernel
+        std::uint64_t   dropped_records;    ///< Records dropped because buffer was full
+        std::uint64_t   dropped_bytes;      ///< Message bytes dropped because buffer was full
+        std::uint64_t   reconnects;         ///< Successful (re)connections to peer
+        std::size_t     pending_bytes;      ///< Bytes currently waiting in buffer
+        bool            connected;          ///< Whether there's live connection right now
+    };
+} // namespace socket
+    /** Writes newline-terminated messages to Unix domain socket, pipe or FIFO
+     *
+     *  Messages are formatted on caller thread and appended to bounded buffer.
+     *  Background thread sends them in batches, scatter-gathering up to `max_batch` records
+     *  per `sendmsg`. While peer is down, records are kept in buffer until `buffer_limit`
+     *  is reached, and dropped with accounting after that.
+     */
+    class SocketLogger
+    {
+    public:
+        /** Connects lazily through provided connector and reconnects through it on failure
+         *  @param  connector   Connection factory, see @ref socket::unix_stream and friends
+         *  @param  options     Batching and buffering options
+         */
+        explicit SocketLogger(socket::Connector connector, socket::Options const& options = socket::Options());
+        /** Uses already connected descriptor, for example one end of `socketpair`
+         *  No reconnection is performed when this descriptor fails
+         *  @param  fd          Connected descriptor
+         *  @param  options     Batching and buffering options
+         */
+        explicit SocketLogger(socket::FileDescriptor fd, socket::Options const& options = socket::Options());
+
+        SocketLogger(SocketLogger&&);
+        SocketLogger& operator=(SocketLogger&&);
+        /** Makes last attempt to send buffered records, then stops background thread
+         */
+        ~SocketLogger();
+
+        bool is_enabled(Metadata const&) { return true; }
+
+        void write(Record const& record, WriterFunc writer);
+        /** Waits until everything written so far is sent, or peer goes down, or timeout expires
+         *  @param  timeout Maximal wait time
+         *  @return         true if buffer was fully drained
+         */
+        bool flush(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+        /** Number of bytes currently waiting to be sent
+         */
+        std::size_t pending() const;
+
+        socket::Stats stats() const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+} // namespace log
+} // namespace toolboxcpp
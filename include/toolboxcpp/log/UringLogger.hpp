@@ -0,0 +1,91 @@
+#pragma once
+/** File sink which writes through Linux io_uring, with registered buffers and linked fsync
+ *
+ *  Linux-only, built as separate `toolboxcpp_uring` library. When kernel doesn't provide
+ *  io_uring, or it's forbidden by sandbox, sink falls back to `pwrite`/`fdatasync`
+ *  issued from the same background thread, so callers see no difference
+ */
+#include <toolboxcpp/log/Logger.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace uring
+{
+    /** Tuning knobs for @ref UringLogger
+     */
+    struct Options
+    {
+        /// Size of single registered buffer; message larger than that spans several buffers
+        std::size_t                 buffer_size     = 64 * 1024;
+        /// Number of registered buffers; writers wait when all of them are in flight
+        std::size_t                 buffers         = 8;
+        /// Partially filled buffer is submitted after this delay
+        std::chrono::milliseconds   flush_interval  = std::chrono::milliseconds(50);
+        /// Minimal interval between `fdatasync`s linked to writes; zero disables them
+        std::chrono::milliseconds   fsync_interval  = std::chrono::milliseconds(1000);
+        /// Truncate file instead of appending to it
+        bool                        truncate        = false;
+        /// Don't even try io_uring, use `pwrite` fallback
+        bool                        force_posix     = false;
+    };
+    /** Sink statistics, all counters are cumulative
+     */
+    struct Stats
+    {
+        std::uint64_t   written_bytes;  ///< Bytes which reached the file
+        std::uint64_t   writes;         ///< Write operations completed, including resubmitted partial ones
+        std::uint64_t   fsyncs;         ///< Completed `fdatasync`s
+        std::uint64_t   errors;         ///< Failed operations; data of failed write is dropped
+        std::uint64_t   buffer_waits;   ///< Times writer had to wait for free buffer
+    };
+} // namespace uring
+    /** Appends newline-terminated messages to file through io_uring
+     *
+     *  Messages are formatted on caller thread into slab blocks and copied into one of
+     *  pre-registered buffers. Caller doesn't enter the kernel, except for waking background
+     *  thread once per filled buffer. Background thread submits filled buffers as fixed-buffer
+     *  writes at explicit offsets, links `fdatasync` to them once per `fsync_interval`,
+     *  and reaps completions, resubmitting short writes.
+     */
+    class UringLogger
+    {
+    public:
+        /** Opens file for appending, or truncates it if `options.truncate` is set
+         *  @param      path                File path
+         *  @param      options             Buffering and syncing options
+         *  @exception  std::system_error   If file can't be opened
+         */
+        explicit UringLogger(std::string const& path, uring::Options const& options = uring::Options());
+
+        UringLogger(UringLogger&&);
+        UringLogger& operator=(UringLogger&&);
+        /** Writes out everything buffered, syncs file and stops background thread
+         */
+        ~UringLogger();
+
+        bool is_enabled(Metadata const&) { return true; }
+
+        void write(Record const& record, WriterFunc writer);
+        /** Submits partially filled buffer and waits until everything written so far reaches the file
+         */
+        void flush();
+        /** Checks if io_uring is actually used, rather than `pwrite` fallback
+         */
+        bool uses_uring() const;
+
+        uring::Stats stats() const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+} // namespace log
+} // namespace toolboxcpp
@@ -0,0 +1,238 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+/** Locale-independent encoders of numbers and timestamps into character buffers
+ *
+ *  Each encoder writes into caller-provided buffer, which should be large enough
+ *  (see `Max*Chars` constants), and returns pointer past the last written character.
+ *  No terminating zero is written
+ */
+
+namespace toolboxcpp
+{
+namespace util
+{
+    /// Enough to hold any 64-bit integer, including sign
+    static constexpr std::size_t MaxIntegerChars    = 20;
+    /// Enough to hold any `float` or `double` in shortest round-trip form
+    static constexpr std::size_t MaxFloatChars      = 32;
+    /// Length of `YYYY-MM-DDTHH:MM:SS.uuuuuuZ` timestamp, for years 0000-9999
+    static constexpr std::size_t TimestampChars     = 27;
+
+namespace impl
+{
+    /// Table of all two-digit pairs, so that integer conversion needs one division per two digits
+    template<typename = void>
+    struct DigitPairs
+    {
+        static const char table[201];
+    };
+
+    template<typename T>
+    const char DigitPairs<T>::table[201] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    inline char* write_two_digits(char* out, unsigned value) noexcept
+    {
+        std::memcpy(out, DigitPairs<>::table + value * 2, 2);
+        return out + 2;
+    }
+
+    template<typename F> struct FloatTraits;
+
+    template<> struct FloatTraits<float>
+    {
+        /// Integers below this limit are written by `%g` with full precision without exponent
+        static constexpr float integral_limit = 1e6f;
+        static float parse(const char* str) noexcept { return std::strtof(str, nullptr); }
+    };
+
+    template<> struct FloatTraits<double>
+    {
+        static constexpr double integral_limit = 1e15;
+        static double parse(const char* str) noexcept { return std::strtod(str, nullptr); }
+    };
+    /// Cached text of the current second, per thread
+    struct TimestampCache
+    {
+        std::int64_t    second;
+        char            text[19];   ///< `YYYY-MM-DDTHH:MM:SS`, no terminating zero
+        bool            valid;
+    };
+
+    inline void render_second(std::int64_t second, char* out) noexcept
+    {
+        // Civil-from-days conversion, see http://howardhinnant.github.io/date_algorithms.html
+        std::int64_t days = second / 86400;
+        std::int64_t secs = second % 86400;
+        if(secs < 0)
+        {
+            secs += 86400;
+            days -= 1;
+        }
+        days += 719468;
+        std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        unsigned doe  = static_cast<unsigned>(days - era * 146097);
+        unsigned yoe  = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        unsigned doy  = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned mp   = (5 * doy + 2) / 153;
+        unsigned day  = doy - (153 * mp + 2) / 5 + 1;
+        unsigned mon  = mp < 10 ? mp + 3 : mp - 9;
+        std::int64_t year = static_cast<std::int64_t>(yoe) + era * 400 + (mon <= 2);
+        unsigned yr   = static_cast<unsigned>(std::min<std::int64_t>(std::max<std::int64_t>(year, 0), 9999));
+
+        out = write_two_digits(out, yr / 100);
+        out = write_two_digits(out, yr % 100);
+        *out++ = '-';
+        out = write_two_digits(out, mon);
+        *out++ = '-';
+        out = write_two_digits(out, day);
+        *out++ = 'T';
+        out = write_two_digits(out, static_cast<unsigned>(secs / 3600));
+        *out++ = ':';
+        out = write_two_digits(out, static_cast<unsigned>(secs / 60 % 60));
+        *out++ = ':';
+        write_two_digits(out, static_cast<unsigned>(secs % 60));
+    }
+} // namespace impl
+    /** Writes unsigned integer in decimal form
+     *  @param  out     Output buffer, at least @ref MaxIntegerChars long
+     *  @param  value   Value to write
+     *  @return         Pointer past the last written character
+     */
+    inline char* write_decimal(char* out, unsigned long long value) noexcept
+    {
+        char  buffer[MaxIntegerChars];
+        char* end   = buffer + sizeof(buffer);
+        char* begin = end;
+        while(value >= 100)
+        {
+            begin -= 2;
+            impl::write_two_digits(begin, static_cast<unsigned>(value % 100));
+            value /= 100;
+        }
+        if(value >= 10)
+        {
+            begin -= 2;
+            impl::write_two_digits(begin, static_cast<unsigned>(value));
+        }
+        else
+            *--begin = static_cast<char>('0' + value);
+
+        std::memcpy(out, begin, static_cast<std::size_t>(end - begin));
+        return out + (end - begin);
+    }
+    /** Writes any integer type in decimal form
+     *  @param  out     Output buffer, at least @ref MaxIntegerChars long
+     *  @param  value   Value to write
+     *  @return         Pointer past the last written character
+     */
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value, char*>::type
+    write_integer(char* out, T value) noexcept
+    {
+        using Unsigned = typename std::make_unsigned<T>::type;
+        auto magnitude = static_cast<unsigned long long>(static_cast<Unsigned>(value));
+        if(value < T())
+        {
+            *out++ = '-';
+            // Two's complement negation, well-defined for the minimal value too
+            magnitude = static_cast<unsigned long long>(Unsigned(0) - static_cast<Unsigned>(value));
+        }
+        return write_decimal(out, magnitude);
+    }
+    /** Writes floating-point value in the shortest `%g`-style form which parses back to the same value
+     *
+     *  Values which are exact integers are written as integers, without invoking `printf` machinery.
+     *  Otherwise, precision is increased from `digits10` up to `max_digits10` until value round-trips.
+     *  Decimal point is the one of "C" locale, unless program changes `LC_NUMERIC`
+     *
+     *  @param  out     Output buffer, at least @ref MaxFloatChars long
+     *  @param  value   Value to write
+     *  @return         Pointer past the last written character
+     */
+    template<typename F>
+    typename std::enable_if<std::is_same<F, float>::value || std::is_same<F, double>::value, char*>::type
+    write_float(char* out, F value) noexcept
+    {
+        if(std::isnan(value))
+        {
+            std::memcpy(out, "nan", 3);
+            return out + 3;
+        }
+        if(std::isinf(value))
+        {
+            if(value < 0)
+                *out++ = '-';
+            std::memcpy(out, "inf", 3);
+            return out + 3;
+        }
+        // Small integers are exact, and `%g` would write them without exponent anyway
+        if(value == std::trunc(value) && std::fabs(value) < impl::FloatTraits<F>::integral_limit)
+        {
+            if(std::signbit(value))
+                *out++ = '-';
+            return write_decimal(out, static_cast<unsigned long long>(std::fabs(value)));
+        }
+
+        char buffer[MaxFloatChars];
+        int  size = 0;
+        for(int precision = std::numeric_limits<F>::digits10; precision <= std::numeric_limits<F>::max_digits10; ++precision)
+        {
+            size = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, static_cast<double>(value));
+            if(impl::FloatTraits<F>::parse(buffer) == value)
+                break;
+        }
+        std::memcpy(out, buffer, static_cast<std::size_t>(size));
+        return out + size;
+    }
+    /** Writes time point as ISO-8601 UTC timestamp with microseconds, `YYYY-MM-DDTHH:MM:SS.uuuuuuZ`
+     *
+     *  Date and time part is cached per thread and re-rendered only when second changes
+     *
+     *  @param  out     Output buffer, at least @ref TimestampChars long
+     *  @param  time    Time point to write
+     *  @return         Pointer past the last written character
+     */
+    inline char* write_timestamp(char* out, std::chrono::system_clock::time_point time) noexcept
+    {
+        using namespace std::chrono;
+
+        auto micros = duration_cast<microseconds>(time.time_since_epoch()).count();
+        auto second = static_cast<std::int64_t>(micros / 1000000);
+        auto frac   = static_cast<std::int64_t>(micros % 1000000);
+        if(frac < 0)
+        {
+            frac   += 1000000;
+            second -= 1;
+        }
+
+        static thread_local impl::TimestampCache cache;
+        if(!cache.valid || cache.second != second)
+        {
+            impl::render_second(second, cache.text);
+            cache.second = second;
+            cache.valid  = true;
+        }
+        std::memcpy(out, cache.text, sizeof(cache.text));
+        out += sizeof(cache.text);
+
+        *out++ = '.';
+        unsigned fraction = static_cast<unsigned>(frac);
+        out = impl::write_two_digits(out, fraction / 10000);
+        out = impl::write_two_digits(out, fraction / 100 % 100);
+        out = impl::write_two_digits(out, fraction % 100);
+        *out++ = 'Z';
+        return out;
+    }
+} // namespace util
+} // namespace toolboxcpp
@@ -0,0 +1,60 @@
+#pragma once
+/** Escaping of text for JSON strings and line-oriented output
+ *
+ *  Text is scanned for bytes which need escaping with vector kernels, and runs of clean bytes
+ *  between them are copied in bulk. Kernel is chosen at runtime, by CPU features:
+ *  AVX2 or SSE2 on x86, plain byte loop elsewhere. All kernels produce identical output.
+ */
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace escape
+{
+    /** What is escaped, and how
+     */
+    enum class Mode
+    {
+        /// Contents of JSON string: `"` and `\` get backslash, control characters become `\n`, `\t`, `\u001f` etc
+        Json,
+        /// Single text line: `\` gets backslash, control characters except tab become `\n`, `\r` or `\x1f`, everything else is kept
+        Line,
+    };
+    /** Scanning kernel
+     */
+    enum class Kernel
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+    /** Kernel used right now
+     */
+    Kernel kernel() noexcept;
+    /** Best kernel supported by this CPU
+     */
+    Kernel best_kernel() noexcept;
+    /** Switches kernel, for testing and benchmarking; unsupported kernel is replaced by the best supported one
+     *  @return Kernel actually selected
+     */
+    Kernel set_kernel(Kernel kernel) noexcept;
+    /** Name of kernel, like `avx2`
+     */
+    char const* kernel_name(Kernel kernel) noexcept;
+    /** Finds first byte which needs escaping
+     *  @return Offset of that byte, or `size` if there's none
+     */
+    std::size_t find_special(Mode mode, char const* data, std::size_t size) noexcept;
+    /** Appends escaped text to string
+     */
+    void append(Mode mode, char const* data, std::size_t size, std::string& out);
+    /** Writes escaped text to stream
+     */
+    void write(Mode mode, char const* data, std::size_t size, std::ostream& ost);
+} // namespace escape
+} // namespace util
+} // namespace toolboxcpp
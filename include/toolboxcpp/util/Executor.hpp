@@ -0,0 +1,190 @@
+#pragma once
+/** Small work-stealing thread pool for background jobs, like draining, flushing or reconnecting
+ *
+ *  Meant to be shared: instead of spawning thread per sink, components submit tasks
+ *  and periodic timers to single executor, see @ref Executor::shared
+ */
+#include <toolboxcpp/util/FuncRef.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace util
+{
+    /** Move-only callable `void ()`, stored inline without heap allocation
+     *
+     *  Accepts any nothrow-movable functor which fits into @ref InlineSize bytes,
+     *  which covers `FuncRef` and lambdas capturing few pointers. Bigger functors
+     *  are rejected at compile time; capture pointer to their state instead.
+     */
+    class Task
+    {
+    public:
+        /// Maximal size of stored functor
+        static constexpr std::size_t InlineSize = 4 * sizeof(void*);
+
+        Task() noexcept
+            : _ops(nullptr)
+        { }
+
+        template<typename Fn, typename = typename std::enable_if<!std::is_same<typename std::decay<Fn>::type, Task>::value>::type>
+        Task(Fn&& func)
+            : _ops(&OpsOf<typename std::decay<Fn>::type>::ops)
+        {
+            using F = typename std::decay<Fn>::type;
+            static_assert(sizeof(F) <= InlineSize && alignof(F) <= alignof(Storage), "Task functor doesn't fit into inline storage");
+            static_assert(std::is_nothrow_move_constructible<F>::value, "Task functor should be nothrow move-constructible");
+            new (&_storage) F(std::forward<Fn>(func));
+        }
+
+        Task(Task&& other) noexcept
+            : _ops(other._ops)
+        {
+            if(_ops)
+                _ops->move(&_storage, &other._storage);
+            other.reset();
+        }
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if(this != &other)
+            {
+                reset();
+                _ops = other._ops;
+                if(_ops)
+                    _ops->move(&_storage, &other._storage);
+                other.reset();
+            }
+            return *this;
+        }
+
+        Task(Task const&)            = delete;
+        Task& operator=(Task const&) = delete;
+
+        ~Task()
+        {
+            reset();
+        }
+
+        explicit operator bool() const noexcept { return _ops != nullptr; }
+        /** Invokes stored functor; task should not be empty
+         */
+        void operator()()
+        {
+            _ops->call(&_storage);
+        }
+
+    private:
+        using Storage = typename std::aligned_storage<InlineSize, alignof(void*)>::type;
+
+        struct Ops
+        {
+            void (*call)(void*);
+            void (*move)(void*, void*) noexcept;
+            void (*destroy)(void*) noexcept;
+        };
+
+        template<typename F>
+        struct OpsOf
+        {
+            static void call(void* self)                    { (*static_cast<F*>(self))(); }
+            static void move(void* dest, void* src) noexcept { new (dest) F(std::move(*static_cast<F*>(src))); }
+            static void destroy(void* self) noexcept        { static_cast<F*>(self)->~F(); }
+
+            static constexpr Ops ops = { &call, &move, &destroy };
+        };
+
+        void reset() noexcept
+        {
+            if(_ops)
+                _ops->destroy(&_storage);
+            _ops = nullptr;
+        }
+
+        Storage     _storage;
+        Ops const*  _ops;
+    };
+
+    template<typename F>
+    constexpr Task::Ops Task::OpsOf<F>::ops;
+
+namespace executor
+{
+    /** Executor configuration
+     */
+    struct Options
+    {
+        /// Number of worker threads
+        std::size_t         threads     = 2;
+        /// CPUs to pin workers to, worker `i` gets `affinity[i % affinity.size()]`; empty means no pinning
+        std::vector<int>    affinity;
+    };
+    /// Identifier of scheduled timer, never 0
+    using TimerId   = std::uint64_t;
+    using Clock     = std::chrono::steady_clock;
+} // namespace executor
+    /** Pool of worker threads with work-stealing task queues and timers
+     *
+     *  Each worker owns task deque: tasks submitted from worker go to its own deque, and are
+     *  taken from its back, while idle workers steal from the front of others' deques.
+     *  Tasks submitted from other threads go to shared injection queue.
+     *  Timers are kept in single heap and are run by whichever worker gets idle first,
+     *  or notices that deadline has passed between tasks.
+     *
+     *  Exceptions thrown by tasks are swallowed. Tasks should not block for long,
+     *  since they delay everything else queued on the same executor.
+     */
+    class Executor
+    {
+    public:
+        /** Starts worker threads
+         *  @param  options Number of threads and their CPU affinity
+         */
+        explicit Executor(executor::Options const& options = executor::Options());
+
+        Executor(Executor const&)            = delete;
+        Executor& operator=(Executor const&) = delete;
+        /** Cancels all timers, runs tasks which are already queued, then stops workers
+         *  Should not be called from executor's own task
+         */
+        ~Executor();
+        /** Queues task for execution on any worker
+         */
+        void submit(Task task);
+        /** Runs task once after specified delay
+         *  @return Timer identifier, which can be used to cancel it
+         */
+        executor::TimerId schedule_after(executor::Clock::duration delay, Task task);
+        /** Runs task periodically, first time after one period
+         *  Runs of the same timer never overlap; missed runs are skipped, not accumulated
+         *  @return Timer identifier, which can be used to cancel it
+         */
+        executor::TimerId schedule_every(executor::Clock::duration period, Task task);
+        /** Cancels timer; if it's running right now, waits till its run ends,
+         *  unless called from that very run. Unknown and finished timers are ignored
+         */
+        void cancel(executor::TimerId timer);
+
+        std::size_t threads() const noexcept;
+        /** Process-wide executor, which is started on first call and never destroyed
+         */
+        static Executor& shared();
+        /** Sets options of shared executor
+         *  @exception  std::logic_error    If shared executor is already started
+         */
+        static void configure_shared(executor::Options const& options);
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+} // namespace util
+} // namespace toolboxcpp
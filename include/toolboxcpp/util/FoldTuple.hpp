@@ -1,7 +1,9 @@
 #pragma once
+#include <cstddef>
+#include <tuple>
 #include <type_traits>
 #include <utility>
-/** Templated fold function over tuples of arbitrary arity
+/** Templated fold and iteration functions over tuples of arbitrary arity
 */
 
 namespace toolboxcpp
@@ -11,6 +13,128 @@ namespace util
 
 namespace impl
 {
+    /// Compile-time sequence of indices
+    template<size_t... Is>
+    struct Indices
+    {
+        using type = Indices;
+    };
+    // Concatenates two index sequences, shifting second one by the size of first one
+    template<typename L, typename R> struct JoinIndices;
+
+    template<size_t... L, size_t... R>
+    struct JoinIndices<Indices<L...>, Indices<R...>>
+    {
+        using type = Indices<L..., (sizeof...(L) + R)...>;
+    };
+    /// Produces `Indices<0, ..., N-1>`; sequence is built by halves, so instantiation depth is logarithmic
+    template<size_t N>
+    struct MakeIndices: JoinIndices<typename MakeIndices<N / 2>::type, typename MakeIndices<N - N / 2>::type> {};
+
+    template<> struct MakeIndices<0> { using type = Indices<>; };
+    template<> struct MakeIndices<1> { using type = Indices<0>; };
+
+    template<typename Tuple>
+    using IndicesOf = typename MakeIndices<std::tuple_size<typename std::decay<Tuple>::type>::value>::type;
+
+    template<size_t I, typename Tuple>
+    using ElementOf = decltype(std::get<I>(std::declval<Tuple>()));
+    // Evaluates pack expansion inside braced list, which guarantees left-to-right order
+    using Swallow = int[];
+    /*
+        Flat fold is possible only when accumulator keeps its type after the first step.
+        That's checked with single pack expansion over element types, which are taken
+        right from `std::tuple` parameters where possible, without going through `std::get`
+    */
+    template<typename... Ts> struct Pack {};
+
+    template<typename T, typename... Ts>
+    struct AllSame: std::is_same<Pack<T, Ts...>, Pack<Ts..., T>> {};
+    // Types which `std::get` returns for each element of tuple-like object
+    template<typename Tuple, typename Is>
+    struct ElementsAt;
+
+    template<typename Tuple, size_t... Is>
+    struct ElementsAt<Tuple, Indices<Is...>>
+    {
+        using type = Pack<ElementOf<Is, Tuple>...>;
+    };
+
+    template<typename Tuple>
+    struct ElementsOf: ElementsAt<Tuple, IndicesOf<Tuple>> {};
+
+    template<typename... Ts>
+    struct ElementsOf<std::tuple<Ts...>&>       { using type = Pack<Ts&...>; };
+
+    template<typename... Ts>
+    struct ElementsOf<std::tuple<Ts...> const&> { using type = Pack<Ts const&...>; };
+
+    template<typename... Ts>
+    struct ElementsOf<std::tuple<Ts...>>        { using type = Pack<Ts&&...>; };
+
+    template<typename Func, typename Acc, typename Elem>
+    using StepOf = decltype(std::declval<Func&>()(std::declval<Acc>(), std::declval<Elem>()));
+
+    template<typename Func, typename Acc, typename Elems, typename = void>
+    struct FlatFold
+    {
+        using Result = void;
+        static constexpr bool flat = false;
+    };
+    // Result of the first step is computed once, then all other steps are checked against it in single expansion
+    template<typename Func, typename Acc, typename E0, typename... Es>
+    struct FlatFold<Func, Acc, Pack<E0, Es...>,
+        typename std::enable_if<AllSame<StepOf<Func, Acc, E0>, StepOf<Func, StepOf<Func, Acc, E0>, Es>...>::value>::type>
+    {
+        using Result = StepOf<Func, Acc, E0>;
+
+        static constexpr bool flat =
+            !std::is_rvalue_reference<Result>::value &&
+            (std::is_lvalue_reference<Result>::value || std::is_move_assignable<Result>::value);
+    };
+
+    template<typename Tuple, typename Acc, typename Func>
+    struct FoldTraits: FlatFold<Func, Acc, typename ElementsOf<Tuple>::type> {};
+    // Accumulator storage of flat fold; references are rebound, values are move-assigned.
+    // Neither `take` nor `put` depends on element type, so steps add no instantiations
+    template<typename R>
+    struct FoldState
+    {
+        R value;
+
+        explicit FoldState(R&& init) : value(std::move(init)) {}
+
+        R&&  take()          { return std::move(value); }
+        void put(R&& next)   { value = std::move(next); }
+        R    get()           { return std::move(value); }
+    };
+
+    template<typename R>
+    struct FoldState<R&>
+    {
+        R* value;
+
+        explicit FoldState(R& init) : value(&init) {}
+
+        R&   take()          { return *value; }
+        void put(R& next)    { value = &next; }
+        R&   get()           { return *value; }
+    };
+
+    template<typename Tuple, typename Acc, typename Func, size_t... Is>
+    typename FoldTraits<Tuple, Acc, Func>::Result
+    fold(Tuple&& tuple, Acc&& acc, Func&& func, std::true_type, Indices<Is...>)
+    {
+        // First step converts accumulator to its final type, the rest are expanded in place
+        FoldState<typename FoldTraits<Tuple, Acc, Func>::Result> state(
+            func(std::forward<Acc>(acc), std::get<0>(std::forward<Tuple>(tuple)))
+        );
+        (void)Swallow { 0, (state.put(func(state.take(), std::get<Is + 1>(std::forward<Tuple>(tuple)))), 0)... };
+        return state.get();
+    }
+    /** Recursive fold, one instantiation per element
+     *  Handles accumulators which change their type at every step
+     */
     template<size_t I, size_t N> struct Folder;
 
     template<size_t I, size_t N>
@@ -76,6 +200,42 @@ namespace impl
             return acc;
         }
     };
+
+    template<typename Tuple, typename Acc, typename Func, typename Is>
+    auto fold(Tuple&& tuple, Acc&& acc, Func&& func, std::false_type, Is)
+        -> decltype(Folder<0, std::tuple_size<typename std::decay<Tuple>::type>::value>
+            ::apply(std::forward<Tuple>(tuple), std::forward<Acc>(acc), std::forward<Func>(func)))
+    {
+        return Folder<0, std::tuple_size<typename std::decay<Tuple>::type>::value>
+            ::apply(std::forward<Tuple>(tuple), std::forward<Acc>(acc), std::forward<Func>(func));
+    }
+
+    template<typename Tuple, typename Func, size_t... Is>
+    void for_each(Tuple&& tuple, Func& func, Indices<Is...>)
+    {
+        (void)Swallow { 0, (func(std::get<Is>(std::forward<Tuple>(tuple))), 0)... };
+    }
+
+    template<typename Tuple, typename Pred, size_t... Is>
+    bool all_of(Tuple&& tuple, Pred& pred, Indices<Is...>)
+    {
+        bool result = true;
+        (void)Swallow { 0, (result = result && static_cast<bool>(pred(std::get<Is>(std::forward<Tuple>(tuple)))), 0)... };
+        return result;
+    }
+
+    template<typename Tuple, typename Pred, size_t... Is>
+    bool any_of(Tuple&& tuple, Pred& pred, Indices<Is...>)
+    {
+        bool result = false;
+        (void)Swallow { 0, (result = result || static_cast<bool>(pred(std::get<Is>(std::forward<Tuple>(tuple)))), 0)... };
+        return result;
+    }
+    // Indices of all elements except the first one, used by flat fold
+    template<typename Tuple>
+    using TailIndicesOf = typename MakeIndices<
+        std::tuple_size<typename std::decay<Tuple>::type>::value == 0 ? 0 : std::tuple_size<typename std::decay<Tuple>::type>::value - 1
+    >::type;
 }
 
 /** @brief Perform fold over all elements of any tuple-like object
@@ -85,7 +245,8 @@ namespace impl
     over the rest of tuple; return final accumulator value in the end
     
     Please note that accumulator may change its type during folding, based on which overload
-    of binary functor 'folder' is called
+    of binary functor 'folder' is called. If it keeps the same type after the first step,
+    fold is expanded in place, without recursive instantiations per element
     
     @tparam Tuple       Type of tuple-like object
     @tparam Acc         Initial accumulator's type
@@ -100,20 +261,58 @@ namespace impl
 template<typename Tuple, typename Acc, typename Func>
 auto fold_tuple(Tuple&& tuple, Acc&& accumulator, Func&& folder)
     // Note: consider return value type as implementation-defined
-    -> decltype(impl::Folder<0, std::tuple_size<typename std::decay<Tuple>::type>::value>
-        ::apply(
+    -> decltype(impl::fold(
             std::forward<Tuple> (tuple),
             std::forward<Acc>   (accumulator),
-            std::forward<Func>  (folder)
+            std::forward<Func>  (folder),
+            std::integral_constant<bool, impl::FoldTraits<Tuple, Acc, Func>::flat>(),
+            impl::TailIndicesOf<Tuple>()
         )
     )
 {
-    return impl::Folder<0, std::tuple_size<typename std::decay<Tuple>::type>::value>
-        ::apply(
-            std::forward<Tuple> (tuple),
-            std::forward<Acc>   (accumulator),
-            std::forward<Func>  (folder)
-        );
+    return impl::fold(
+        std::forward<Tuple> (tuple),
+        std::forward<Acc>   (accumulator),
+        std::forward<Func>  (folder),
+        std::integral_constant<bool, impl::FoldTraits<Tuple, Acc, Func>::flat>(),
+        impl::TailIndicesOf<Tuple>()
+    );
+}
+/** @brief Invoke functor on each element of tuple-like object, from first to last
+
+    @param  tuple   Tuple-like object
+    @param  func    Unary functor, should accept every element of tuple
+*/
+template<typename Tuple, typename Func>
+void for_each_tuple(Tuple&& tuple, Func&& func)
+{
+    impl::for_each(std::forward<Tuple>(tuple), func, impl::IndicesOf<Tuple>());
+}
+/** @brief Check if predicate holds for all elements of tuple-like object
+
+    Elements are checked from first to last; checking stops at first element which fails predicate
+
+    @param  tuple   Tuple-like object
+    @param  pred    Unary predicate, should accept every element of tuple
+    @return         true if predicate holds for all elements, or tuple is empty
+*/
+template<typename Tuple, typename Pred>
+bool all_of_tuple(Tuple&& tuple, Pred&& pred)
+{
+    return impl::all_of(std::forward<Tuple>(tuple), pred, impl::IndicesOf<Tuple>());
+}
+/** @brief Check if predicate holds for any element of tuple-like object
+
+    Elements are checked from first to last; checking stops at first element which satisfies predicate
+
+    @param  tuple   Tuple-like object
+    @param  pred    Unary predicate, should accept every element of tuple
+    @return         true if predicate holds for some element, false if it holds for none or tuple is empty
+*/
+template<typename Tuple, typename Pred>
+bool any_of_tuple(Tuple&& tuple, Pred&& pred)
+{
+    return impl::any_of(std::forward<Tuple>(tuple), pred, impl::IndicesOf<Tuple>());
 }
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include <utility>
 #include <cassert>
 
 namespace toolboxcpp
@@ -42,8 +43,9 @@ public:
     using Pointer  = R(*)(Ts...);
     using Callback = R(*)(void*, Ts...);
     /** @brief Wraps any compatible callable object
+     *  Other FuncRef is copied instead of being wrapped
     */
-    template<class Fn>
+    template<class Fn, class = typename std::enable_if<!std::is_same<typename std::decay<Fn>::type, FuncRef>::value>::type>
     FuncRef(Fn&& func)
         : _context(reinterpret_cast<void*>(&func))
         , _caller(&ObjectCaller<typename std::decay<Fn>::type>)
@@ -83,18 +85,21 @@ public:
     }
 
 private:
-    using Caller = R(*)(void*, Ts&&... args);
+    // Scalars are passed to caller by value, so they stay in registers instead of being spilled for reference
+    template<class T>
+    using Arg    = typename std::conditional<std::is_scalar<T>::value, T, T&&>::type;
+    using Caller = R(*)(void*, Arg<Ts>... args);
 
     void*    _context;
     Caller   _caller;
 
     template<class Fn>
-    static R ObjectCaller(void* object, Ts&&... args)
+    static R ObjectCaller(void* object, Arg<Ts>... args)
     {
         return (*reinterpret_cast<Fn*>(object))(std::forward<Ts>(args)...);
     }
 
-    static R FuncCaller(void* func, Ts&&... args)
+    static R FuncCaller(void* func, Arg<Ts>... args)
     {
         return (reinterpret_cast<Pointer>(func))(std::forward<Ts>(args)...);
     }
@@ -0,0 +1,78 @@
+#pragma once
+/** Log-linear histogram of unsigned integer values, in the spirit of HdrHistogram
+ *
+ *  Values below 32 are counted exactly. Every power-of-two range above that is split
+ *  into 16 equal buckets, so any recorded value is known with relative error below 1/16,
+ *  while the whole 64-bit range fits into fixed @ref Histogram::Buckets counters.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace util
+{
+    class Histogram
+    {
+    public:
+        /// Bits of value kept exactly in bucket index
+        static constexpr unsigned       SubBits     = 5;
+        /// Total number of buckets
+        static constexpr std::size_t    Buckets     = (1u << SubBits) + (64 - SubBits) * (1u << (SubBits - 1));
+
+        Histogram()
+            : _counts(Buckets, 0)
+            , _total(0)
+            , _sum(0)
+        { }
+        /** Index of bucket which holds value
+         */
+        static std::size_t bucket_of(std::uint64_t value) noexcept;
+        /** Smallest value which falls into bucket
+         */
+        static std::uint64_t bucket_low(std::size_t bucket) noexcept;
+        /** Largest value which falls into bucket
+         */
+        static std::uint64_t bucket_high(std::size_t bucket) noexcept;
+
+        void add(std::uint64_t value, std::uint64_t count = 1) noexcept
+        {
+            _counts[bucket_of(value)] += count;
+            _total  += count;
+            _sum    += value * count;
+        }
+        /** Adds counts to bucket directly, along with their sum
+         */
+        void add_bucket(std::size_t bucket, std::uint64_t count) noexcept
+        {
+            _counts[bucket] += count;
+            _total          += count;
+        }
+
+        void add_sum(std::uint64_t sum) noexcept { _sum += sum; }
+
+        void merge(Histogram const& other) noexcept;
+
+        std::uint64_t count() const noexcept { return _total; }
+        std::uint64_t sum()   const noexcept { return _sum; }
+        std::uint64_t count(std::size_t bucket) const noexcept { return _counts[bucket]; }
+        /** Lower bound of the smallest recorded value, 0 if histogram is empty
+         */
+        std::uint64_t min() const noexcept;
+        /** Upper bound of the largest recorded value, 0 if histogram is empty
+         */
+        std::uint64_t max() const noexcept;
+        /** Value below or at which specified fraction of recorded values lies
+         *  @param  quantile    Fraction in range [0, 1]
+         *  @return             Middle of the bucket where quantile falls, 0 if histogram is empty
+         */
+        std::uint64_t percentile(double quantile) const noexcept;
+
+    private:
+        std::vector<std::uint64_t>  _counts;
+        std::uint64_t               _total;
+        std::uint64_t               _sum;
+    };
+} // namespace util
+} // namespace toolboxcpp
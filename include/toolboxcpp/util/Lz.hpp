@@ -0,0 +1,37 @@
+#pragma once
+/** Small LZ77 block codec with byte-aligned sequences, in the spirit of LZ4
+ *
+ *  Compressed block is a sequence of tokens. Each token holds literal and match lengths
+ *  in its two nibbles, followed by length extensions, literals and 16-bit match offset.
+ *  The last token carries literals only. Decoder validates every length and offset,
+ *  so it's safe to feed it with damaged data.
+ */
+#include <cstddef>
+#include <string>
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace lz
+{
+    /** Upper bound of compressed size for input of specified size
+     */
+    std::size_t max_compressed_size(std::size_t size) noexcept;
+    /** Compresses block and appends result to output string
+     *  @param  data    Input data
+     *  @param  size    Input size
+     *  @param  out     String to append compressed block to
+     */
+    void compress(char const* data, std::size_t size, std::string& out);
+    /** Decompresses block produced by @ref compress
+     *  @param  data        Compressed block
+     *  @param  size        Compressed block size
+     *  @param  out         Output buffer
+     *  @param  out_size    Exact size of original data
+     *  @return             false if block is malformed or doesn't decompress to exactly `out_size` bytes
+     */
+    bool decompress(char const* data, std::size_t size, char* out, std::size_t out_size) noexcept;
+} // namespace lz
+} // namespace util
+} // namespace toolboxcpp
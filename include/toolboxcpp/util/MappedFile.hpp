@@ -0,0 +1,301 @@
+#pragma once
+/** Memory-mapped files, for zero-copy reading of logs and other large files
+ *
+ *  @ref MappedFile owns file descriptor, and maps windows of file as @ref MappedRegion objects,
+ *  which own their mappings through @ref Resource. Destroyed mappings are handed over to reaper thread
+ *  (see `Reaper.hpp`), which unmaps them in batches, merging adjacent ranges, so owner isn't stalled
+ *  by releasing large mapping.
+ *  Very large files may be streamed with @ref MappedChunks, which maps fixed-size windows one by one
+ *  and asks kernel to read ahead the next window while current one is processed.
+ *  Since released windows are unmapped by reaper thread, address space still held at a time
+ *  is the current window plus the ones reaper hasn't got to yet.
+ *
+ *  Hints, like `madvise` advice, readahead or huge pages, are best-effort: they're silently skipped
+ *  where platform doesn't support them.
+ */
+#include <toolboxcpp/util/Reaper.hpp>
+#include <toolboxcpp/util/Resource.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace mapped
+{
+    /// Size to which mappings are aligned when huge pages are requested
+    static constexpr std::size_t HugePageSize = 2u << 20;
+    /** How file is opened and mapped
+     */
+    enum class Access
+    {
+        Read,       ///< Read-only; mappings are read-only too
+        ReadWrite,  ///< File is created if needed; mappings are shared, so writes go to file
+    };
+    /** Expected access pattern, passed to kernel as `madvise` hint
+     */
+    enum class Advice
+    {
+        Normal,
+        Sequential, ///< Aggressive readahead, pages behind are dropped early
+        Random,     ///< No readahead
+        WillNeed,   ///< Start reading pages in right away
+    };
+    /** Mapping options
+     */
+    struct Options
+    {
+        bool    populate    = false;            ///< Prefault whole mapping on creation, `MAP_POPULATE`
+        Advice  advice      = Advice::Normal;   ///< Initial advice for whole mapping
+        bool    huge_pages  = false;            ///< Align mapping to @ref HugePageSize and ask for transparent huge pages
+    };
+    /** Mapped address range
+     */
+    struct Span
+    {
+        void*           address;
+        std::size_t     size;
+    };
+
+    inline bool operator==(Span const& left, Span const& right) noexcept
+    {
+        return left.address == right.address && left.size == right.size;
+    }
+
+    inline bool operator!=(Span const& left, Span const& right) noexcept
+    {
+        return !(left == right);
+    }
+    /** Unmaps address ranges; batch is sorted by address, and each run of adjacent ranges
+     *  is released with single `munmap` call
+     */
+    struct Unmap
+    {
+        void operator()(Span span) const noexcept;
+        void operator()(Span* begin, Span* end) const noexcept;
+    };
+    /// Owned mapping, unmapped by reaper thread
+    using Mapping = util::Resource<Span, util::Deferred<Unmap>>;
+    /** Size of virtual memory page
+     */
+    std::size_t page_size() noexcept;
+} // namespace mapped
+    /** Mapped window of file
+     *
+     *  Window may start at any offset; mapping itself is extended down to page boundary.
+     *  Pointers into region stay valid while region object exists, including moves.
+     */
+    class MappedRegion
+    {
+    public:
+        MappedRegion() noexcept
+            : _data(nullptr)
+            , _size(0)
+            , _offset(0)
+            , _writable(false)
+        { }
+
+        MappedRegion(MappedRegion&& other) noexcept
+            : MappedRegion()
+        {
+            swap(other);
+        }
+
+        MappedRegion& operator=(MappedRegion&& other) noexcept
+        {
+            MappedRegion(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        void swap(MappedRegion& other) noexcept
+        {
+            _mapping.swap(other._mapping);
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+            std::swap(_offset, other._offset);
+            std::swap(_writable, other._writable);
+        }
+
+        char const* data()      const noexcept { return _data; }
+        char*       data()            noexcept { return _data; }
+        /// Size of window, in bytes
+        std::size_t size()      const noexcept { return _size; }
+        /// Offset of window in file
+        std::uint64_t offset()  const noexcept { return _offset; }
+        bool        empty()     const noexcept { return _size == 0; }
+        /// true if region was mapped from file opened for writing
+        bool        writable()  const noexcept { return _writable; }
+        /** Passes access pattern hint for part of region to kernel
+         *  @param  advice  Access pattern
+         *  @param  from    Offset in region
+         *  @param  length  Number of bytes; clipped to region end
+         */
+        void advise(mapped::Advice advice, std::size_t from = 0, std::size_t length = std::size_t(-1)) const noexcept;
+        /** Asks kernel to start reading part of region in, same as `advise(Advice::WillNeed, from, length)`
+         */
+        void prefetch(std::size_t from, std::size_t length) const noexcept
+        {
+            advise(mapped::Advice::WillNeed, from, length);
+        }
+        /** Writes modified pages back to file and waits for that
+         *  @exception  std::system_error   If writing fails
+         */
+        void sync() const;
+
+    private:
+        friend class MappedFile;
+
+        MappedRegion(mapped::Mapping&& mapping, std::size_t skip, std::size_t size, std::uint64_t offset, bool writable) noexcept
+            : _mapping(std::move(mapping))
+            , _data(static_cast<char*>(_mapping.get().address) + skip)
+            , _size(size)
+            , _offset(offset)
+            , _writable(writable)
+        { }
+
+        mapped::Mapping _mapping;
+        char*           _data;
+        std::size_t     _size;
+        std::uint64_t   _offset;
+        bool            _writable;
+    };
+
+    class MappedChunks;
+    /** File which is read, and possibly written, through memory mappings
+     */
+    class MappedFile
+    {
+    public:
+        /** Creates object which owns no file
+         */
+        MappedFile() noexcept
+            : _size(0)
+            , _access(mapped::Access::Read)
+        { }
+        /** Opens file
+         *  @param      path                File path
+         *  @param      access              Access mode; files opened for writing are created if needed
+         *  @exception  std::system_error   If file can't be opened
+         */
+        explicit MappedFile(std::string const& path, mapped::Access access = mapped::Access::Read);
+
+        MappedFile(MappedFile&&)            = default;
+        MappedFile& operator=(MappedFile&&) = default;
+        /** File size, as of opening or last @ref resize
+         */
+        std::uint64_t size() const noexcept { return _size; }
+        /** Underlying file descriptor, -1 if there's no file
+         */
+        int descriptor() const noexcept { return _fd.get(); }
+        /** Changes file size; file should be opened for writing
+         *  @exception  std::system_error   If size can't be changed
+         */
+        void resize(std::uint64_t size);
+        /** Maps window of file
+         *  @param      offset              Window offset
+         *  @param      size                Window size; clipped to file end
+         *  @param      options             Mapping options
+         *  @return                         Mapped window, empty if there's nothing to map
+         *  @exception  std::out_of_range   If offset is past file end
+         *  @exception  std::system_error   If mapping fails
+         */
+        MappedRegion map(std::uint64_t offset, std::size_t size, mapped::Options const& options = mapped::Options()) const;
+        /** Maps whole file
+         */
+        MappedRegion map(mapped::Options const& options = mapped::Options()) const;
+        /** Asks kernel to read part of file into page cache in background, without mapping it
+         */
+        void readahead(std::uint64_t offset, std::uint64_t size) const noexcept;
+        /** Streams file in fixed-size windows, see @ref MappedChunks
+         *  @param  window  Window size; rounded up to page size
+         *  @param  options Options of each window's mapping
+         */
+        MappedChunks chunks(std::size_t window, mapped::Options const& options = mapped::Options()) const;
+
+    private:
+        struct CloseFd
+        {
+            static int zero() noexcept { return -1; }
+            void operator()(int fd) const noexcept;
+        };
+
+        util::Resource<int, CloseFd>    _fd;
+        std::uint64_t                   _size;
+        mapped::Access                  _access;
+    };
+    /** Single-pass range of consecutive windows of file
+     *
+     *  Range holds only current window; previous ones are released to reaper thread, and stay mapped
+     *  until it unmaps them, so several windows may be mapped at once when reaper lags behind.
+     *  When window is mapped, next one is passed to @ref MappedFile::readahead,
+     *  so its pages are read while current one is processed. File object should outlive the range.
+     *
+     *  @code
+     *  for(auto& chunk : file.chunks(64 << 20))
+     *      process(chunk.data(), chunk.size());
+     *  @endcode
+     */
+    class MappedChunks
+    {
+    public:
+        class Iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type        = MappedRegion;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = MappedRegion const*;
+            using reference         = MappedRegion const&;
+
+            Iterator() noexcept : _chunks(nullptr) {}
+
+            reference operator*()  const noexcept { return _chunks->_current; }
+            pointer   operator->() const noexcept { return &_chunks->_current; }
+
+            Iterator& operator++()
+            {
+                if(!_chunks->advance())
+                    _chunks = nullptr;
+                return *this;
+            }
+
+            bool operator==(Iterator const& other) const noexcept { return _chunks == other._chunks; }
+            bool operator!=(Iterator const& other) const noexcept { return _chunks != other._chunks; }
+
+        private:
+            friend class MappedChunks;
+
+            explicit Iterator(MappedChunks* chunks) noexcept : _chunks(chunks) {}
+
+            MappedChunks*   _chunks;
+        };
+        /** Maps first window; should be called once
+         */
+        Iterator begin();
+        Iterator end() noexcept { return Iterator(); }
+
+    private:
+        friend class MappedFile;
+
+        MappedChunks(MappedFile const& file, std::size_t window, mapped::Options const& options) noexcept
+            : _file(&file)
+            , _window(window)
+            , _options(options)
+            , _next(0)
+        { }
+        // Maps next window, returns false past file end
+        bool advance();
+
+        MappedFile const*   _file;
+        std::size_t         _window;
+        mapped::Options     _options;
+        std::uint64_t       _next;
+        MappedRegion        _current;
+    };
+} // namespace util
+} // namespace toolboxcpp
@@ -0,0 +1,142 @@
+#pragma once
+#include <toolboxcpp/util/Resource.hpp>
+
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+/** Deferred destruction of resource handles on shared background thread
+ *
+ *  Some handles are expensive to release: closing descriptor on network filesystem
+ *  or unmapping large region may stall for milliseconds. Wrapping their deleter into
+ *  @ref Deferred makes owning thread only enqueue handle, while the actual release
+ *  is done in batches by background "reaper" thread:
+ *  @code
+ *  using File = util::Resource<int, util::Deferred<util::reaper::CloseFds>>;
+ *  @endcode
+ */
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace reaper
+{
+    /** Queue of handles of single type, flushed by reaper thread
+     */
+    class Bin
+    {
+    public:
+        /** Releases all handles queued so far
+         */
+        virtual void flush() = 0;
+
+    protected:
+        ~Bin() {}
+    };
+    /** Registers bin to be flushed by reaper thread, starting the thread if needed
+     */
+    void attach(Bin* bin);
+    /** Wakes reaper thread up
+     */
+    void notify();
+    /** Synchronously releases every handle queued before the call
+     *  Intended for shutdown and tests
+     */
+    void drain();
+    /** Closes file descriptors; batches are closed with single `close_range` call
+     *  per contiguous run of descriptors where kernel supports it
+     */
+    struct CloseFds
+    {
+        static int zero() noexcept { return -1; }
+
+        void operator()(int fd) const noexcept;
+        void operator()(int* begin, int* end) const noexcept;
+    };
+
+namespace impl
+{
+    // Forwards custom empty handle value from wrapped deleter, if it has one
+    template<typename D, typename = void>
+    struct ZeroOf {};
+
+    template<typename D>
+    struct ZeroOf<D, decltype(void(D::zero()))>
+    {
+        static auto zero() noexcept -> decltype(D::zero()) { return D::zero(); }
+    };
+
+    template<typename H, typename D>
+    auto release(D& deleter, H* begin, H* end, int) -> decltype(void(deleter(begin, end)))
+    {
+        deleter(begin, end);
+    }
+
+    template<typename H, typename D>
+    void release(D& deleter, H* begin, H* end, ...)
+    {
+        for(; begin != end; ++begin)
+            deleter(*begin);
+    }
+    /** Bin for handles of type `H` released with deleter `D`
+     *  Deleter uses its batch overload, `void (H* begin, H* end)`, if there's one
+     */
+    template<typename H, typename D>
+    class BinOf: public Bin
+    {
+    public:
+        /// Bins are never destroyed, so handles can be dropped even during static destruction
+        static BinOf& instance()
+        {
+            static BinOf* bin = new BinOf();
+            return *bin;
+        }
+
+        void push(H handle)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _handles.push_back(handle);
+            }
+            notify();
+        }
+
+        void flush() override
+        {
+            std::vector<H> batch;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                batch.swap(_handles);
+            }
+            if(batch.empty())
+                return;
+            D deleter {};
+            release(deleter, batch.data(), batch.data() + batch.size(), 0);
+        }
+
+    private:
+        BinOf()
+        {
+            attach(this);
+        }
+
+        std::mutex      _mutex;
+        std::vector<H>  _handles;
+    };
+} // namespace impl
+} // namespace reaper
+    /** Deleter policy which hands handles over to background reaper instead of releasing them inline
+     *  @tparam Deleter Actual deleter, should be default-constructible; its `zero()` is forwarded, if any
+     */
+    template<typename Deleter>
+    struct Deferred: reaper::impl::ZeroOf<Deleter>
+    {
+        template<typename H>
+        void operator()(H handle) const
+        {
+            reaper::impl::BinOf<H, Deleter>::instance().push(handle);
+        }
+    };
+} // namespace util
+} // namespace toolboxcpp
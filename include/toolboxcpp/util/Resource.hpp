@@ -1,6 +1,7 @@
 #pragma once
 #include <functional>   // std::hash
 #include <type_traits>
+#include <utility>
 
 namespace toolboxcpp
 {
@@ -8,13 +9,13 @@ namespace util
 {
     /** Generic wrapper type for unmanaged resources
      *  @tparam Handle  Resource handle type, can be anything.
-     *  @tparam Deleter Type of deleter functor. Should be compatible with `void (T)` call contract
+     *  @tparam Deleter Type of deleter functor. Should be compatible with `void (T)` call contract.
+     *                  May provide `static Handle zero()` function, which returns custom empty value
+     *                  for cases where default-constructed handle is valid, like POSIX file descriptors
      *  @tparam Tag     Marker type which allows to have multiple distinct wrappers
      *                  with same handle type and same deleter. Useful in cases
      *                  where C interface provides a bunch of distinct handles via `typedef void*`
      *                  which are deleted the same way, but used in different ways
-     *
-     *  @todo           Optional function for T which provides custom empty value
      */
     template<typename Handle, typename Deleter, typename Tag = Deleter>
     class Resource
@@ -40,7 +41,8 @@ namespace util
         /** Move constructor
          *  @param  other   Other resource wrapper
          */
-        Resource(Resource&& other)
+        Resource(Resource&& other) noexcept(std::is_nothrow_default_constructible<Deleter>::value
+                                            && std::is_nothrow_move_constructible<Deleter>::value)
             : Resource()
         {
             swap(other);
@@ -51,13 +53,10 @@ namespace util
          */
         Resource& operator=(Resource&& other)
         {
-            if (this != &other)
-            {
-                // First, destroy and clean current instance by moving it into temporary in nested scope
-                { Resource(std::move(*this)); }
-                // Next, move othar into this
-                swap(other);
-            }
+            // Other's handle is taken first, and current one goes away with temporary;
+            // so self-assignment is harmless without explicit check
+            Resource taken(std::move(other));
+            swap(taken);
             return *this;
         }
 
@@ -199,9 +198,9 @@ namespace resource
 namespace std
 {
     template<typename H, typename D, typename T>
-    struct hash<util::Resource<H, D, T>>
+    struct hash<toolboxcpp::util::Resource<H, D, T>>
     {
-        size_t operator () (util::Resource<H, D, T> const& value) const
+        size_t operator () (toolboxcpp::util::Resource<H, D, T> const& value) const
         {
             return _hasher(value.get());
         }
@@ -221,11 +220,24 @@ namespace resource
 {
 namespace impl
 {
-    template<typename H>
-    constexpr H zeroHandle() noexcept
+    template<typename H, typename D>
+    constexpr auto zeroHandleOf(int) noexcept -> decltype(H(D::zero()))
+    {
+        return D::zero();
+    }
+
+    template<typename H, typename D>
+    constexpr H zeroHandleOf(...) noexcept
     {
         return {};
     }
+    /** Returns deleter-provided empty handle value, if any, or default value of handle type
+     */
+    template<typename H, typename D>
+    constexpr H zeroHandle() noexcept
+    {
+        return zeroHandleOf<H, D>(0);
+    }
 
     template<typename H, typename D, typename T = void> struct Storage;
     /** Implementation of Resource::Storage for stateless deleter
@@ -248,7 +260,7 @@ namespace impl
 
         ~Storage()
         {
-            auto tmp = zeroHandle<H>();
+            auto tmp = zeroHandle<H, D>();
             if (_handle != tmp)
             {
                 std::swap(_handle, tmp);
@@ -282,7 +294,7 @@ namespace impl
 
         ~Storage()
         {
-            auto tmp = zeroHandle<H>();
+            auto tmp = zeroHandle<H, D>();
             if (_handle != tmp)
             {
                 std::swap(_handle, tmp);
@@ -304,7 +316,7 @@ namespace impl
     template<typename H, typename D, typename T>
     H Resource<H, D, T>::zero() noexcept
     {
-        return resource::impl::zeroHandle<H>();
+        return resource::impl::zeroHandle<H, D>();
     }
 
     template<typename H, typename D, typename T>
@@ -0,0 +1,244 @@
+#pragma once
+#include <toolboxcpp/util/Resource.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>   // std::hash
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace pool
+{
+    /** Default reset hook, reuses every returned handle as is
+     */
+    struct KeepAll
+    {
+        template<typename H>
+        bool operator()(H&) const noexcept { return true; }
+    };
+    /** Pool statistics, all counters are cumulative
+     */
+    struct Stats
+    {
+        std::uint64_t   hits;       ///< Leases served from cached handles
+        std::uint64_t   misses;     ///< Leases which required new handle
+        std::uint64_t   evictions;  ///< Returned handles destroyed because pool was full
+        std::uint64_t   rejects;    ///< Returned handles destroyed because reset hook refused them
+    };
+} // namespace pool
+    /** Lock-free cache of released handles, which hands them out as @ref Resource leases
+     *
+     *  When lease is destroyed, its handle goes back to pool instead of being deleted.
+     *  Returned handle is first passed to `Reset` hook, which has signature compatible with
+     *  @code
+     *  bool (Handle&)
+     *  @endcode
+     *  and may clean handle up for reuse; if hook returns false, or pool is full, handle is deleted.
+     *
+     *  Cached handles live in fixed array of atomic slots, where empty slot holds "zero" handle.
+     *  Each thread starts its slot scan at its own home slot, which it moves to the last slot
+     *  it used, so threads mostly get back handles they released and rarely contend on same slots.
+     *  Returning thread reserves place in size counter before it fills slot, and taking thread
+     *  frees it only after it has emptied slot, so counter never drops below number of filled slots
+     *  nor exceeds capacity.
+     *
+     *  Pool should outlive all its leases. `Handle` should be suitable for `std::atomic`,
+     *  like integers or pointers.
+     *
+     *  @tparam Handle  Resource handle type
+     *  @tparam Deleter Deleter for handles which leave the pool
+     *  @tparam Reset   Validation and reset hook for returned handles
+     */
+    template<typename Handle, typename Deleter, typename Reset = pool::KeepAll>
+    class ResourcePool
+    {
+    public:
+        /** Deleter of leases, returns handle to its pool
+         */
+        struct Return
+        {
+            ResourcePool* pool;
+
+            static Handle zero() noexcept { return resource::impl::zeroHandle<Handle, Deleter>(); }
+
+            void operator()(Handle handle) const
+            {
+                pool->release(handle);
+            }
+        };
+        /// Lease of pooled handle, returns it to pool on destruction
+        using Lease = Resource<Handle, Return, Deleter>;
+        /** Constructs empty pool
+         *  @param  capacity    Maximal number of cached handles
+         *  @param  deleter     Deleter for handles which leave the pool
+         *  @param  reset       Validation and reset hook for returned handles
+         */
+        explicit ResourcePool(std::size_t capacity, Deleter deleter = Deleter(), Reset reset = Reset())
+            : _capacity(capacity)
+            , _slots(new std::atomic<Handle>[capacity])
+            , _deleter(std::move(deleter))
+            , _reset(std::move(reset))
+        {
+            for(std::size_t i = 0; i < _capacity; ++i)
+                _slots[i].store(zero(), std::memory_order_relaxed);
+        }
+
+        ResourcePool(ResourcePool const&)            = delete;
+        ResourcePool& operator=(ResourcePool const&) = delete;
+        /** Deletes all cached handles
+         */
+        ~ResourcePool()
+        {
+            for(std::size_t i = 0; i < _capacity; ++i)
+            {
+                Handle handle = _slots[i].exchange(zero(), std::memory_order_acquire);
+                if(handle != zero())
+                    _deleter(handle);
+            }
+        }
+        /** Takes cached handle, or creates new one with factory on miss
+         *  @param  make    Factory functor, `Handle ()`; may return zero handle on failure
+         *  @return         Lease over handle, or empty lease if factory failed
+         */
+        template<typename Make>
+        Lease acquire(Make&& make)
+        {
+            Handle handle = take();
+            if(handle == zero())
+            {
+                _misses.fetch_add(1, std::memory_order_relaxed);
+                handle = make();
+            }
+            else
+                _hits.fetch_add(1, std::memory_order_relaxed);
+            return Lease(handle, Return { this });
+        }
+        /** Takes cached handle, if there's one
+         *  @return Lease over handle, or empty lease if pool is empty
+         */
+        Lease try_acquire()
+        {
+            Handle handle = take();
+            if(handle != zero())
+                _hits.fetch_add(1, std::memory_order_relaxed);
+            return Lease(handle, Return { this });
+        }
+        /** Puts handle into pool, as if it was returned by a lease
+         */
+        void release(Handle handle)
+        {
+            if(handle == zero())
+                return;
+            if(!_reset(handle))
+            {
+                _rejects.fetch_add(1, std::memory_order_relaxed);
+                _deleter(handle);
+                return;
+            }
+            if(!put(handle))
+            {
+                _evictions.fetch_add(1, std::memory_order_relaxed);
+                _deleter(handle);
+            }
+        }
+        /** Number of handles cached right now
+         */
+        std::size_t size() const noexcept
+        {
+            return _size.load(std::memory_order_relaxed);
+        }
+
+        std::size_t capacity() const noexcept
+        {
+            return _capacity;
+        }
+
+        pool::Stats stats() const noexcept
+        {
+            return pool::Stats {
+                _hits.load(std::memory_order_relaxed),
+                _misses.load(std::memory_order_relaxed),
+                _evictions.load(std::memory_order_relaxed),
+                _rejects.load(std::memory_order_relaxed)
+            };
+        }
+
+    private:
+        static Handle zero() noexcept
+        {
+            return Return::zero();
+        }
+
+        std::size_t& home() const noexcept
+        {
+            static thread_local std::size_t home = std::hash<std::thread::id>()(std::this_thread::get_id());
+            return home;
+        }
+
+        Handle take() noexcept
+        {
+            if(_capacity == 0 || _size.load(std::memory_order_relaxed) == 0)
+                return zero();
+
+            std::size_t& start = home();
+            for(std::size_t i = 0; i < _capacity; ++i)
+            {
+                std::size_t index = (start + i) % _capacity;
+                Handle handle = _slots[index].load(std::memory_order_relaxed);
+                if(handle != zero() && _slots[index].compare_exchange_strong(handle, zero(), std::memory_order_acquire))
+                {
+                    _size.fetch_sub(1, std::memory_order_relaxed);
+                    start = index;
+                    return handle;
+                }
+            }
+            return zero();
+        }
+
+        bool put(Handle handle) noexcept
+        {
+            std::size_t size = _size.load(std::memory_order_relaxed);
+            do
+            {
+                if(size >= _capacity)
+                    return false;
+            }
+            while(!_size.compare_exchange_weak(size, size + 1, std::memory_order_relaxed));
+
+            std::size_t& start = home();
+            for(std::size_t i = 0; i < _capacity; ++i)
+            {
+                std::size_t index = (start + i) % _capacity;
+                Handle empty = zero();
+                if(_slots[index].load(std::memory_order_relaxed) == empty &&
+                   _slots[index].compare_exchange_strong(empty, handle, std::memory_order_release))
+                {
+                    start = index;
+                    return true;
+                }
+            }
+            // Free slots were taken by others during scan
+            _size.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        std::size_t                             _capacity;
+        std::unique_ptr<std::atomic<Handle>[]>  _slots;
+        Deleter                                 _deleter;
+        Reset                                   _reset;
+
+        std::atomic<std::size_t>                _size       { 0 };
+        std::atomic<std::uint64_t>              _hits       { 0 };
+        std::atomic<std::uint64_t>              _misses     { 0 };
+        std::atomic<std::uint64_t>              _evictions  { 0 };
+        std::atomic<std::uint64_t>              _rejects    { 0 };
+    };
+} // namespace util
+} // namespace toolboxcpp
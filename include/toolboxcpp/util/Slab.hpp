@@ -0,0 +1,115 @@
+#pragma once
+/** Per-thread slab allocator of fixed-size blocks, for messages which outlive single call
+ *
+ *  Every thread carves blocks out of its own chunks and keeps freed ones in private free-list,
+ *  so allocation is just pop from that list. Block freed by another thread goes back
+ *  to its owner through lock-free remote-free stack, which owner takes over in one exchange
+ *  once its private list runs out.
+ *
+ *  Memory is bounded: each thread may reserve at most @ref slab::MaxChunks chunks, after which
+ *  allocation fails. Chunks are never returned to the system; heap of exited thread
+ *  is handed over to the next thread which starts allocating.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace slab
+{
+    /// Size of single block, including its header
+    static constexpr std::size_t BlockSize      = 256;
+    /// Number of blocks in chunk reserved at once
+    static constexpr std::size_t ChunkBlocks    = 256;
+    /// Maximal number of chunks reserved by single thread
+    static constexpr std::size_t MaxChunks      = 64;
+
+    struct Heap;
+    /** Header of block, followed by payload
+     */
+    struct Block
+    {
+        Block*          next;   ///< Next block of message chain; free-list link while block is free
+        Heap*           owner;
+        std::uint32_t   size;   ///< Payload bytes in use
+
+        char*       data()       noexcept { return reinterpret_cast<char*>(this + 1); }
+        char const* data() const noexcept { return reinterpret_cast<char const*>(this + 1); }
+    };
+    /// Payload bytes available in single block
+    static constexpr std::size_t BlockCapacity = BlockSize - sizeof(Block);
+    /** Takes free block from current thread's heap
+     *  @return Empty block, or nullptr if thread's memory budget is exhausted
+     */
+    Block* allocate() noexcept;
+    /** Returns every block of chain, linked through `next`, to its owner
+     *  May be called from any thread; nullptr is ignored
+     */
+    void free(Block* chain) noexcept;
+    /** Number of bytes reserved by current thread's heap
+     */
+    std::size_t reserved() noexcept;
+} // namespace slab
+    /** Output stream buffer which collects text into chain of slab blocks
+     *
+     *  When thread's slab budget is exhausted, the rest of text spills into heap string,
+     *  so nothing is lost. Blocks are released on destruction.
+     */
+    class SlabStreamBuf: public std::streambuf
+    {
+    public:
+        SlabStreamBuf() noexcept
+            : _head(nullptr)
+            , _tail(nullptr)
+            , _spilling(false)
+        { }
+
+        SlabStreamBuf(SlabStreamBuf const&)            = delete;
+        SlabStreamBuf& operator=(SlabStreamBuf const&) = delete;
+
+        ~SlabStreamBuf()
+        {
+            slab::free(_head);
+        }
+        /** Writes collected text to another stream
+         */
+        void write_to(std::ostream& ost);
+        /** Passes collected text, piece by piece, to functor `void (const char* data, std::size_t size)`
+         */
+        template<typename Fn>
+        void for_each_piece(Fn&& func)
+        {
+            sync_tail();
+            for(auto block = _head; block; block = block->next)
+                func(static_cast<char const*>(block->data()), static_cast<std::size_t>(block->size));
+            if(!_spill.empty())
+                func(_spill.data(), _spill.size());
+        }
+        /** Total number of collected characters
+         */
+        std::size_t size() const noexcept;
+        /** First block of chain, or nullptr if nothing was written into blocks
+         */
+        slab::Block const* blocks() const noexcept { return _head; }
+
+    protected:
+        int_type        overflow(int_type ch) override;
+        std::streamsize xsputn(char const* str, std::streamsize count) override;
+
+    private:
+        // Closes current block and appends new one; returns false if budget is exhausted
+        bool grow();
+        void sync_tail() noexcept;
+
+        slab::Block*    _head;
+        slab::Block*    _tail;
+        std::string     _spill;
+        bool            _spilling;
+    };
+} // namespace util
+} // namespace toolboxcpp
@@ -0,0 +1,294 @@
+#include <toolboxcpp/log/Aggregate.hpp>
+#include <toolboxcpp/log/Sites.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace histogram
+{
+    Extractor last_number()
+    {
+        return [](Metadata const&, char const* text, std::size_t size, std::uint64_t& value) {
+            std::size_t end = size;
+            while(end > 0 && (text[end - 1] < '0' || text[end - 1] > '9'))
+                --end;
+            if(end == 0)
+                return false;
+            std::size_t begin = end;
+            while(begin > 0 && text[begin - 1] >= '0' && text[begin - 1] <= '9')
+                --begin;
+            value = 0;
+            for(std::size_t i = begin; i < end; ++i)
+                value = value * 10 + static_cast<std::uint64_t>(text[i] - '0');
+            return true;
+        };
+    }
+
+    void write_summary(std::ostream& ost, Summary const& summary, std::vector<double> const& percentiles)
+    {
+        auto& values = summary.values;
+        if(summary.site)
+        {
+            try
+            {
+                Site site = sites::get(summary.site);
+                ost << (site.basename ? site.basename : site.file) << ':' << site.line;
+            }
+            catch(std::out_of_range const&)
+            {
+                ost << "site " << summary.site;
+            }
+        }
+        else
+            ost << (summary.channel && *summary.channel ? summary.channel : "-");
+
+        ost << " count=" << values.count()
+            << " mean=" << (values.count() ? values.sum() / values.count() : 0)
+            << " min="  << values.min();
+        for(double quantile : percentiles)
+            ost << " p" << quantile * 100 << '=' << values.percentile(quantile);
+        ost << " max="  << values.max();
+    }
+
+    Record summary_record(Summary const& summary, Severity severity)
+    {
+        Record record {};
+        record.severity  = severity;
+        record.channel   = summary.channel;
+        record.site      = summary.site;
+        record.timestamp = std::chrono::system_clock::now();
+        if(summary.site)
+        {
+            try
+            {
+                Site site = sites::get(summary.site);
+                record.location = Location(site.file, site.line, nullptr);
+            }
+            catch(std::out_of_range const&)
+            { }
+        }
+        return record;
+    }
+
+namespace impl
+{
+    Captured& captured() noexcept
+    {
+        thread_local Captured value { false, 0 };
+        return value;
+    }
+}
+/*
+    Every thread gets its own shard per aggregator. Cells of shard are added by owner thread only,
+    under shard mutex, so owner looks them up without locking; collector locks shard to walk its cells.
+    Counters are cumulative and have single writer, so plain relaxed load and store is enough
+*/
+namespace {
+    using util::Histogram;
+
+    struct Key
+    {
+        SiteId      site;
+        Channel     channel;
+
+        bool operator==(Key const& other) const noexcept
+        {
+            return site == other.site && channel == other.channel;
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const& key) const noexcept
+        {
+            return std::hash<void const*>()(key.channel) * 31 + key.site;
+        }
+    };
+
+    struct Cell
+    {
+        explicit Cell(Channel channel)
+            : channel(channel)
+        {
+            for(auto& count : counts)
+                count.store(0, std::memory_order_relaxed);
+            sum.store(0, std::memory_order_relaxed);
+        }
+
+        static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        Channel                     channel;
+        std::atomic<std::uint64_t>  counts[Histogram::Buckets];
+        std::atomic<std::uint64_t>  sum;
+    };
+
+    struct Shard
+    {
+        std::mutex                                                  mutex;
+        std::unordered_map<Key, std::unique_ptr<Cell>, KeyHash>     cells;
+    };
+    // Totals of histogram as of previous collection
+    struct Snapshot
+    {
+        Snapshot()
+            : counts(Histogram::Buckets, 0)
+            , sum(0)
+            , channel(nullptr)
+        { }
+
+        std::vector<std::uint64_t>  counts;
+        std::uint64_t               sum;
+        Channel                     channel;
+    };
+
+    std::atomic<std::uint64_t> next_aggregator { 1 };
+    // Keyed by aggregator identifier, which is never reused, so entries of dead aggregators are harmless
+    thread_local std::unordered_map<std::uint64_t, Shard*> t_shards;
+}
+
+    struct Aggregator::State
+    {
+        explicit State(Options const& opts)
+            : options(opts)
+            , id(next_aggregator.fetch_add(1, std::memory_order_relaxed))
+        { }
+
+        Shard& shard()
+        {
+            auto found = t_shards.find(id);
+            if(found != t_shards.end())
+                return *found->second;
+            std::lock_guard<std::mutex> lock(mutex);
+            shards.emplace_back(new Shard());
+            t_shards[id] = shards.back().get();
+            return *shards.back();
+        }
+
+        Key key_of(Metadata const& meta) const noexcept
+        {
+            if(options.group_by == GroupBy::Site && meta.site)
+                return Key { meta.site, nullptr };
+            return Key { 0, meta.channel };
+        }
+
+        Options                                         options;
+        std::uint64_t                                   id;
+        std::mutex                                      mutex;          ///< Guards shard list
+        std::vector<std::unique_ptr<Shard>>             shards;
+        std::mutex                                      collecting;     ///< Serializes collections
+        std::unordered_map<Key, Snapshot, KeyHash>      last;
+    };
+
+    Aggregator::Aggregator(Options const& options)
+        : _state(new State(options))
+    { }
+
+    Aggregator::~Aggregator() = default;
+
+    Options const& Aggregator::options() const noexcept
+    {
+        return _state->options;
+    }
+
+    bool Aggregator::consume(Metadata const& meta, WriterFunc writer, util::SlabStreamBuf& text)
+    {
+        auto& captured = impl::captured();
+        captured.set = false;
+        std::ostream ost(&text);
+        writer(ost);
+
+        std::uint64_t value = captured.value;
+        bool found = captured.set;
+        captured.set = false;
+        if(!found && _state->options.extractor)
+        {
+            std::size_t pieces = 0;
+            char const* data = "";
+            std::size_t size = 0;
+            text.for_each_piece([&](char const* piece, std::size_t piece_size) { ++pieces; data = piece; size = piece_size; });
+            if(pieces > 1)
+            {
+                std::string flat;
+                flat.reserve(text.size());
+                text.for_each_piece([&](char const* piece, std::size_t piece_size) { flat.append(piece, piece_size); });
+                found = _state->options.extractor(meta, flat.data(), flat.size(), value);
+            }
+            else
+                found = _state->options.extractor(meta, data, size, value);
+        }
+        if(found)
+            add(meta, value);
+        return found;
+    }
+
+    void Aggregator::add(Metadata const& meta, std::uint64_t value)
+    {
+        Shard& shard = _state->shard();
+        Key key = _state->key_of(meta);
+        auto found = shard.cells.find(key);
+        if(found == shard.cells.end())
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            found = shard.cells.emplace(key, std::unique_ptr<Cell>(new Cell(meta.channel))).first;
+        }
+        Cell& cell = *found->second;
+        Cell::bump(cell.counts[Histogram::bucket_of(value)], 1);
+        Cell::bump(cell.sum, value);
+    }
+
+    std::vector<Summary> Aggregator::collect()
+    {
+        std::lock_guard<std::mutex> collecting(_state->collecting);
+        std::unordered_map<Key, Snapshot, KeyHash> totals;
+        {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+            for(auto& shard : _state->shards)
+            {
+                std::lock_guard<std::mutex> shard_lock(shard->mutex);
+                for(auto& entry : shard->cells)
+                {
+                    Snapshot& total = totals[entry.first];
+                    Cell const& cell = *entry.second;
+                    for(std::size_t i = 0; i < Histogram::Buckets; ++i)
+                        total.counts[i] += cell.counts[i].load(std::memory_order_relaxed);
+                    total.sum    += cell.sum.load(std::memory_order_relaxed);
+                    total.channel = cell.channel;
+                }
+            }
+        }
+
+        std::vector<Summary> summaries;
+        for(auto& entry : totals)
+        {
+            Snapshot& previous = _state->last[entry.first];
+            Snapshot& current  = entry.second;
+            Summary summary { entry.first.site, current.channel, Histogram() };
+            for(std::size_t i = 0; i < Histogram::Buckets; ++i)
+                if(current.counts[i] != previous.counts[i])
+                    summary.values.add_bucket(i, current.counts[i] - previous.counts[i]);
+            summary.values.add_sum(current.sum - previous.sum);
+            previous = std::move(current);
+            if(summary.values.count())
+                summaries.push_back(std::move(summary));
+        }
+        std::sort(summaries.begin(), summaries.end(), [](Summary const& left, Summary const& right) {
+            if(left.site != right.site)
+                return left.site < right.site;
+            return std::strcmp(left.channel ? left.channel : "", right.channel ? right.channel : "") < 0;
+        });
+        return summaries;
+    }
+} // namespace histogram
+} // namespace log
+} // namespace toolboxcpp
@@ -0,0 +1,521 @@
+#include <toolboxcpp/log/Archive.hpp>
+#include <toolboxcpp/util/Lz.hpp>
+#include <toolboxcpp/util/MappedFile.hpp>
+#include <toolboxcpp/util/Resource.hpp>
+#include <toolboxcpp/util/Slab.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace toolboxcpp
+{
+namespace log
+{
+/*
+    Encoding helpers. Reading is done through bounded cursor which turns
+    every overrun into failure flag instead of touching memory past the end
+*/
+namespace {
+    using namespace archive;
+
+    const char          FileMagic[]     = "TBXARC1\n";
+    const std::size_t   FileMagicSize   = sizeof(FileMagic) - 1;
+    const std::uint32_t BlockMagic      = 0x4B4C4254;   // "TBLK"
+    const std::size_t   BlockHeadSize   = 8;
+    const std::size_t   MaxChannels     = 0xFFFF;
+
+    struct CloseFd
+    {
+        static int zero() noexcept { return -1; }
+        void operator()(int fd) const noexcept { ::close(fd); }
+    };
+
+    using Fd = util::Resource<int, CloseFd>;
+
+    template<typename T>
+    void put_fixed(std::string& out, T value)
+    {
+        for(std::size_t i = 0; i < sizeof(T); ++i)
+            out.push_back(static_cast<char>(static_cast<std::uint64_t>(value) >> (8 * i) & 0xFF));
+    }
+
+    void put_varint(std::string& out, std::uint64_t value)
+    {
+        for(; value >= 0x80; value >>= 7)
+            out.push_back(static_cast<char>(value | 0x80));
+        out.push_back(static_cast<char>(value));
+    }
+
+    std::uint64_t zigzag(std::int64_t value) noexcept
+    {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    std::int64_t unzigzag(std::uint64_t value) noexcept
+    {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    struct Input
+    {
+        unsigned char const*    ptr;
+        unsigned char const*    end;
+        bool                    ok;
+
+        Input(char const* data, std::size_t size)
+            : ptr(reinterpret_cast<unsigned char const*>(data))
+            , end(ptr + size)
+            , ok(true)
+        { }
+
+        template<typename T>
+        T fixed() noexcept
+        {
+            if(static_cast<std::size_t>(end - ptr) < sizeof(T))
+                return fail<T>();
+            std::uint64_t value = 0;
+            for(std::size_t i = 0; i < sizeof(T); ++i)
+                value |= static_cast<std::uint64_t>(*ptr++) << (8 * i);
+            return static_cast<T>(value);
+        }
+
+        std::uint64_t varint() noexcept
+        {
+            std::uint64_t value = 0;
+            for(unsigned shift = 0; shift < 64; shift += 7)
+            {
+                if(ptr == end)
+                    break;
+                unsigned char byte = *ptr++;
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                if(!(byte & 0x80))
+                    return value;
+            }
+            return fail<std::uint64_t>();
+        }
+
+        char const* bytes(std::size_t size) noexcept
+        {
+            if(static_cast<std::size_t>(end - ptr) < size)
+                return fail<char const*>();
+            auto data = reinterpret_cast<char const*>(ptr);
+            ptr += size;
+            return data;
+        }
+
+        template<typename T>
+        T fail() noexcept
+        {
+            ok  = false;
+            ptr = end;
+            return T();
+        }
+    };
+
+    std::int64_t to_nanos(Timestamp timestamp)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    }
+
+    Timestamp from_nanos(std::int64_t nanos)
+    {
+        return Timestamp(std::chrono::duration_cast<Timestamp::duration>(std::chrono::nanoseconds(nanos)));
+    }
+
+    bool pread_all(int fd, char* data, std::size_t size, std::uint64_t offset)
+    {
+        while(size > 0)
+        {
+            ssize_t rc = ::pread(fd, data, size, static_cast<off_t>(offset));
+            if(rc < 0 && errno == EINTR)
+                continue;
+            if(rc <= 0)
+                return false;
+            data   += rc;
+            size   -= static_cast<std::size_t>(rc);
+            offset += static_cast<std::uint64_t>(rc);
+        }
+        return true;
+    }
+
+    bool pwrite_all(int fd, char const* data, std::size_t size, std::uint64_t offset)
+    {
+        while(size > 0)
+        {
+            ssize_t rc = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+            if(rc < 0 && errno == EINTR)
+                continue;
+            if(rc <= 0)
+                return false;
+            data   += rc;
+            size   -= static_cast<std::size_t>(rc);
+            offset += static_cast<std::uint64_t>(rc);
+        }
+        return true;
+    }
+    // Records of block being collected, along with its index
+    struct BlockBuilder
+    {
+        std::string                 raw;
+        std::uint32_t               records     = 0;
+        std::int64_t                min_ts      = 0;
+        std::int64_t                max_ts      = 0;
+        std::int64_t                last_ts     = 0;
+        std::uint32_t               severities  = 0;
+        std::vector<Channel>        pointers;   ///< Channel pointers seen so far
+        std::vector<std::size_t>    indexes;    ///< Their 1-based indexes in names
+        std::vector<std::string>    names;
+
+        std::size_t channel_index(Channel channel)
+        {
+            for(std::size_t i = 0; i < pointers.size(); ++i)
+                if(pointers[i] == channel)
+                    return indexes[i];
+            // Same name may come through different pointers
+            std::string name = channel ? channel : "";
+            auto found = std::find(names.begin(), names.end(), name);
+            std::size_t index = static_cast<std::size_t>(found - names.begin()) + 1;
+            if(found == names.end())
+                names.push_back(std::move(name));
+            pointers.push_back(channel);
+            indexes.push_back(index);
+            return index;
+        }
+
+        void add(Record const& record, util::SlabStreamBuf& message)
+        {
+            std::int64_t timestamp = to_nanos(record.timestamp);
+            min_ts = records == 0 ? timestamp : std::min(min_ts, timestamp);
+            max_ts = records == 0 ? timestamp : std::max(max_ts, timestamp);
+            put_varint(raw, zigzag(timestamp - last_ts));
+            last_ts = timestamp;
+            raw.push_back(static_cast<char>(record.severity));
+            severities |= severity_bit(record.severity);
+            put_varint(raw, channel_index(record.channel));
+            put_varint(raw, message.size());
+            message.for_each_piece([&](char const* data, std::size_t size) { raw.append(data, size); });
+            ++records;
+        }
+
+        std::string encode() const
+        {
+            std::string payload;
+            util::lz::compress(raw.data(), raw.size(), payload);
+
+            std::string index;
+            put_fixed<std::uint32_t>(index, payload.size());
+            put_fixed<std::uint32_t>(index, raw.size());
+            put_fixed<std::uint32_t>(index, records);
+            put_fixed<std::int64_t>(index, min_ts);
+            put_fixed<std::int64_t>(index, max_ts);
+            put_fixed<std::uint32_t>(index, severities);
+            put_fixed<std::uint16_t>(index, names.size());
+            for(auto& name : names)
+            {
+                auto size = std::min<std::size_t>(name.size(), 0xFFFF);
+                put_fixed<std::uint16_t>(index, size);
+                index.append(name, 0, size);
+            }
+
+            std::string block;
+            block.reserve(BlockHeadSize + index.size() + payload.size());
+            put_fixed<std::uint32_t>(block, BlockMagic);
+            put_fixed<std::uint32_t>(block, index.size());
+            block += index;
+            block += payload;
+            return block;
+        }
+    };
+
+    bool parse_index(std::string const& data, BlockInfo& info)
+    {
+        Input in(data.data(), data.size());
+        info.compressed_size    = in.fixed<std::uint32_t>();
+        info.raw_size           = in.fixed<std::uint32_t>();
+        info.records            = in.fixed<std::uint32_t>();
+        info.min_timestamp      = from_nanos(in.fixed<std::int64_t>());
+        info.max_timestamp      = from_nanos(in.fixed<std::int64_t>());
+        info.severities         = in.fixed<std::uint32_t>();
+        auto count              = in.fixed<std::uint16_t>();
+        for(std::size_t i = 0; i < count && in.ok; ++i)
+        {
+            auto size = in.fixed<std::uint16_t>();
+            auto name = in.bytes(size);
+            if(in.ok)
+                info.channels.emplace_back(name, size);
+        }
+        return in.ok;
+    }
+    // Reads indexes of complete blocks; `end` receives offset past the last of them
+    void scan(int fd, std::vector<BlockInfo>& blocks, std::vector<std::uint64_t>& payloads, std::uint64_t& end)
+    {
+        struct stat st;
+        if(::fstat(fd, &st) != 0)
+            throw std::system_error(errno, std::system_category(), "Failed to stat log archive");
+        auto size = static_cast<std::uint64_t>(st.st_size);
+
+        char magic[FileMagicSize];
+        if(size < FileMagicSize || !pread_all(fd, magic, FileMagicSize, 0) || std::memcmp(magic, FileMagic, FileMagicSize) != 0)
+            throw std::runtime_error("File isn't a log archive");
+
+        end = FileMagicSize;
+        while(end + BlockHeadSize <= size)
+        {
+            char head[BlockHeadSize];
+            if(!pread_all(fd, head, BlockHeadSize, end))
+                break;
+            Input in(head, BlockHeadSize);
+            auto block_magic    = in.fixed<std::uint32_t>();
+            auto index_size     = in.fixed<std::uint32_t>();
+            if(block_magic != BlockMagic || end + BlockHeadSize + index_size > size)
+                break;
+
+            std::string index(index_size, '\0');
+            BlockInfo info {};
+            info.offset = end;
+            if(!pread_all(fd, &index[0], index_size, end + BlockHeadSize) || !parse_index(index, info))
+                break;
+            std::uint64_t payload = end + BlockHeadSize + index_size;
+            if(payload + info.compressed_size > size)
+                break;
+
+            blocks.push_back(std::move(info));
+            payloads.push_back(payload);
+            end = payload + blocks.back().compressed_size;
+        }
+    }
+
+    bool block_matches(BlockInfo const& block, Query const& query)
+    {
+        if(block.max_timestamp < query.from || block.min_timestamp > query.to || !(block.severities & query.severities))
+            return false;
+        if(query.channels.empty())
+            return true;
+        for(auto& channel : block.channels)
+            if(std::find(query.channels.begin(), query.channels.end(), channel) != query.channels.end())
+                return true;
+        return false;
+    }
+}
+
+    struct ArchiveLogger::State
+    {
+        State(std::string const& path, Options const& opts)
+            : options(opts)
+        {
+            file = Fd(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+            if(file.empty())
+                throw std::system_error(errno, std::system_category(), path);
+
+            struct stat st;
+            if(::fstat(file, &st) == 0 && st.st_size == 0)
+            {
+                if(!pwrite_all(file, FileMagic, FileMagicSize, 0))
+                    throw std::system_error(errno, std::system_category(), path);
+                end = FileMagicSize;
+                return;
+            }
+            std::vector<BlockInfo>      blocks;
+            std::vector<std::uint64_t>  payloads;
+            scan(file, blocks, payloads, end);
+            // Drop torn block left by crash, so that new blocks are reachable
+            if(static_cast<std::uint64_t>(st.st_size) > end)
+                (void)::ftruncate(file, static_cast<off_t>(end));
+        }
+
+        ~State()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            seal(lock);
+        }
+        /*
+            Output lock is taken before buffer lock is released, so blocks reach
+            the file in the order they were sealed, while compression doesn't hold up writers
+        */
+        void seal(std::unique_lock<std::mutex>& lock)
+        {
+            if(current.records == 0)
+                return;
+            BlockBuilder block;
+            std::swap(block, current);
+            std::lock_guard<std::mutex> out(output);
+            lock.unlock();
+
+            std::string bytes = block.encode();
+            if(pwrite_all(file, bytes.data(), bytes.size(), end))
+            {
+                end += bytes.size();
+                stats.records           += block.records;
+                stats.blocks            += 1;
+                stats.raw_bytes         += block.raw.size();
+                stats.compressed_bytes  += bytes.size();
+            }
+            else
+                ++stats.errors;
+        }
+
+        Options             options;
+        Fd                  file;
+        std::uint64_t       end         = 0;    ///< Guarded by `output`
+        Stats               stats       = Stats();
+
+        std::mutex          mutex;
+        std::mutex          output;
+        BlockBuilder        current;
+    };
+
+    ArchiveLogger::ArchiveLogger(std::string const& path, Options const& options)
+        : _state(new State(path, options))
+    { }
+
+    ArchiveLogger::ArchiveLogger(ArchiveLogger&&)               = default;
+    ArchiveLogger& ArchiveLogger::operator=(ArchiveLogger&&)    = default;
+    ArchiveLogger::~ArchiveLogger()                             = default;
+
+    void ArchiveLogger::write(Record const& record, WriterFunc writer)
+    {
+        util::SlabStreamBuf message;
+        std::ostream ost(&message);
+        writer(ost);
+
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        auto& current = _state->current;
+        current.add(record, message);
+        if(current.raw.size() >= _state->options.block_size || current.names.size() >= MaxChannels)
+            _state->seal(lock);
+    }
+
+    void ArchiveLogger::flush()
+    {
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        _state->seal(lock);
+    }
+
+    Stats ArchiveLogger::stats() const
+    {
+        std::lock_guard<std::mutex> lock(_state->output);
+        return _state->stats;
+    }
+
+    struct ArchiveReader::State
+    {
+        explicit State(std::string const& path)
+        {
+            file = util::MappedFile(path);
+            std::uint64_t end = 0;
+            scan(file.descriptor(), blocks, payloads, end);
+            // Blocks are read straight from page cache; queries jump between blocks, so readahead is off
+            util::mapped::Options options;
+            options.advice = util::mapped::Advice::Random;
+            data = file.map(0, static_cast<std::size_t>(end), options);
+        }
+
+        std::vector<Entry> read_block(std::size_t index, Query const& query) const
+        {
+            auto& block = blocks[index];
+            std::string raw(block.raw_size, '\0');
+            if(!util::lz::decompress(data.data() + payloads[index], block.compressed_size, &raw[0], raw.size()))
+                throw std::runtime_error("Damaged log archive block at offset " + std::to_string(block.offset));
+
+            std::vector<Entry> entries;
+            Input in(raw.data(), raw.size());
+            std::int64_t timestamp = 0;
+            for(std::uint32_t i = 0; i < block.records && in.ok; ++i)
+            {
+                timestamp      += unzigzag(in.varint());
+                auto severity   = in.fixed<std::uint8_t>();
+                auto channel    = in.varint();
+                auto size       = in.varint();
+                auto message    = in.bytes(static_cast<std::size_t>(size));
+                if(!in.ok || severity >= static_cast<unsigned>(Severity::_Count) || channel > block.channels.size())
+                    throw std::runtime_error("Damaged log archive block at offset " + std::to_string(block.offset));
+
+                Entry entry { from_nanos(timestamp), static_cast<Severity>(severity),
+                    channel ? block.channels[channel - 1] : std::string(), std::string() };
+                if(entry.timestamp < query.from || entry.timestamp > query.to || !(severity_bit(entry.severity) & query.severities))
+                    continue;
+                if(!query.channels.empty() && std::find(query.channels.begin(), query.channels.end(), entry.channel) == query.channels.end())
+                    continue;
+                entry.message.assign(message, static_cast<std::size_t>(size));
+                entries.push_back(std::move(entry));
+            }
+            return entries;
+        }
+
+        util::MappedFile            file;
+        util::MappedRegion          data;
+        std::vector<BlockInfo>      blocks;
+        std::vector<std::uint64_t>  payloads;   ///< Payload offsets, parallel to blocks
+    };
+
+    ArchiveReader::ArchiveReader(std::string const& path)
+        : _state(new State(path))
+    { }
+
+    ArchiveReader::ArchiveReader(ArchiveReader&&)               = default;
+    ArchiveReader& ArchiveReader::operator=(ArchiveReader&&)    = default;
+    ArchiveReader::~ArchiveReader()                             = default;
+
+    std::vector<BlockInfo> const& ArchiveReader::blocks() const noexcept
+    {
+        return _state->blocks;
+    }
+
+    std::vector<Entry> ArchiveReader::query(Query const& query, std::size_t threads) const
+    {
+        std::vector<std::size_t> selected;
+        for(std::size_t i = 0; i < _state->blocks.size(); ++i)
+            if(block_matches(_state->blocks[i], query))
+                selected.push_back(i);
+
+        // Workers take blocks one by one; results are kept per block to preserve file order
+        std::vector<std::vector<Entry>> results(selected.size());
+        std::atomic<std::size_t>        next { 0 };
+        std::exception_ptr              error;
+        std::mutex                      error_mutex;
+        auto work = [&] {
+            try
+            {
+                for(std::size_t i; (i = next.fetch_add(1)) < selected.size(); )
+                    results[i] = _state->read_block(selected[i], query);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if(!error)
+                    error = std::current_exception();
+                next = selected.size();
+            }
+        };
+
+        if(threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, selected.size());
+        std::vector<std::thread> workers;
+        for(std::size_t i = 1; i < threads; ++i)
+            workers.emplace_back(work);
+        work();
+        for(auto& worker : workers)
+            worker.join();
+        if(error)
+            std::rethrow_exception(error);
+
+        std::vector<Entry> entries;
+        for(auto& part : results)
+            std::move(part.begin(), part.end(), std::back_inserter(entries));
+        return entries;
+    }
+} // namespace log
+} // namespace toolboxcpp
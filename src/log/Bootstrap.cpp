@@ -0,0 +1,138 @@
+#include <toolboxcpp/log/Bootstrap.hpp>
+#include <toolboxcpp/log/Queue.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace bootstrap
+{
+/*
+    Buffer is never destroyed, since threads which loaded it as current logger
+    may still call it after real logger is set. Its mutex orders buffered records, replay
+    and records which reach buffer after replay, so real logger sees them in that order
+*/
+namespace {
+    struct Buffer: public Logger
+    {
+        explicit Buffer(Options const& opts)
+            : options(opts)
+            , target(nullptr)
+            , bytes(0)
+            , dropped(0)
+        { }
+
+        bool is_enabled(Metadata const& meta) override
+        {
+            Logger* logger = target.load(std::memory_order_acquire);
+            if(logger)
+                return logger->is_enabled(meta);
+            return meta.severity <= options.severity;
+        }
+
+        void write(Record const& record, WriterFunc writer) override
+        {
+            std::ostringstream ost;
+            writer(ost);
+            std::string text = ost.str();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            Logger* logger = target.load(std::memory_order_relaxed);
+            if(logger)
+            {
+                if(logger->is_enabled(record))
+                    logger->write(record, [&](std::ostream& out) { out << text; });
+                return;
+            }
+            if(records.size() >= options.max_records || text.size() > options.max_bytes - bytes)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            bytes += text.size();
+            records.emplace_back(record, std::move(text));
+        }
+
+        Options                     options;
+        std::mutex                  mutex;
+        std::atomic<Logger*>        target;
+        std::vector<OwnedRecord>    records;
+        std::size_t                 bytes;
+        std::atomic<std::uint64_t>  dropped;
+    };
+
+    std::atomic<Buffer*> g_buffer;
+}
+
+    void enable(Options const& options)
+    {
+        std::unique_ptr<Buffer> buffer(new Buffer(options));
+        Buffer* expected = nullptr;
+        if(!g_buffer.compare_exchange_strong(expected, buffer.get(), std::memory_order_acq_rel))
+            throw std::logic_error("Bootstrap buffer already enabled");
+        try
+        {
+            set_logger_pointer(buffer.get());
+        }
+        catch(...)
+        {
+            g_buffer.store(nullptr, std::memory_order_release);
+            throw;
+        }
+        buffer.release();
+    }
+
+    std::uint64_t dropped() noexcept
+    {
+        Buffer* buffer = g_buffer.load(std::memory_order_acquire);
+        return buffer ? buffer->dropped.load(std::memory_order_relaxed) : 0;
+    }
+
+namespace impl
+{
+    bool replay(Logger* current, Logger& logger)
+    {
+        Buffer* buffer = g_buffer.load(std::memory_order_acquire);
+        if(!buffer || buffer != current || buffer == &logger)
+            return false;
+
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        if(buffer->target.load(std::memory_order_relaxed))
+            return false;
+
+        std::vector<BatchEntry> batch;
+        batch.reserve(buffer->records.size());
+        for(auto& buffered : buffer->records)
+            batch.push_back(buffered.entry());
+        logger.write_batch(batch.data(), batch.size());
+
+        std::uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if(dropped)
+        {
+            Record record {};
+            record.severity  = Severity::Warning;
+            record.channel   = "toolboxcpp.log";
+            record.location  = $SourceLocation;
+            record.timestamp = std::chrono::system_clock::now();
+            if(logger.is_enabled(record))
+                logger.write(record, [&](std::ostream& ost) {
+                    ost << "Bootstrap log buffer overflowed, " << dropped << " records dropped";
+                });
+        }
+        // Buffer memory is released, later records are passed straight to logger
+        std::vector<OwnedRecord>().swap(buffer->records);
+        buffer->target.store(&logger, std::memory_order_release);
+        return true;
+    }
+} // namespace impl
+} // namespace bootstrap
+} // namespace log
+} // namespace toolboxcpp
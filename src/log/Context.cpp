@@ -0,0 +1,75 @@
+#include <toolboxcpp/log/Context.hpp>
+
+namespace toolboxcpp
+{
+namespace log
+{
+    OwnedContext::OwnedContext(Context const& context)
+    {
+        std::size_t size = 0;
+        for(auto& entry : context)
+            size += std::strlen(entry.key) + 1 + entry.size + 1;
+        _data.resize(size);
+        _entries.reserve(context.size());
+        char* cursor = _data.data();
+        for(auto& entry : context)
+        {
+            std::size_t key_size = std::strlen(entry.key) + 1;
+            std::memcpy(cursor, entry.key, key_size);
+            char* value = cursor + key_size;
+            std::memcpy(value, entry.value, entry.size);
+            value[entry.size] = '\0';
+            _entries.push_back(ContextEntry { cursor, value, entry.size });
+            cursor = value + entry.size + 1;
+        }
+    }
+
+namespace context
+{
+/*
+    Per-thread context stack. Plain POD, so no dynamic TLS initialization is needed,
+    and both push and pop are just bumps of two indices
+*/
+namespace {
+    struct Arena
+    {
+        ContextEntry    entries[MaxEntries];
+        char            chars[ArenaSize];
+        std::size_t     depth;
+        std::size_t     used;
+    };
+
+    thread_local Arena t_arena;
+}
+
+    bool push(const char* key, const char* value, std::size_t size) noexcept
+    {
+        Arena& arena = t_arena;
+        if(arena.depth == MaxEntries || size >= ArenaSize - arena.used)
+            return false;
+
+        char* dest = arena.chars + arena.used;
+        std::memcpy(dest, value, size);
+        dest[size] = '\0';
+
+        arena.entries[arena.depth++] = ContextEntry { key ? key : "", dest, size };
+        arena.used += size + 1;
+        return true;
+    }
+
+    void pop() noexcept
+    {
+        Arena& arena = t_arena;
+        if(arena.depth == 0)
+            return;
+        arena.used = static_cast<std::size_t>(arena.entries[--arena.depth].value - arena.chars);
+    }
+
+    Context current() noexcept
+    {
+        Arena& arena = t_arena;
+        return Context(arena.entries, arena.entries + arena.depth);
+    }
+} // namespace context
+} // namespace log
+} // namespace toolboxcpp
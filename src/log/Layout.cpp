@@ -0,0 +1,148 @@
+#include <toolboxcpp/log/Layout.hpp>
+#include <toolboxcpp/util/CharConv.hpp>
+#include <toolboxcpp/util/Slab.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace {
+    void write_cstr(std::ostream& ost, const char* str)
+    {
+        if(str)
+            ost.write(str, static_cast<std::streamsize>(std::strlen(str)));
+    }
+    /*
+        Emitters, one per directive
+    */
+    void emit_literal(std::ostream& ost, Record const&, WriterFunc, const char* text, std::size_t size)
+    {
+        ost.write(text, static_cast<std::streamsize>(size));
+    }
+
+    void emit_timestamp(std::ostream& ost, Record const& rec, WriterFunc, const char*, std::size_t)
+    {
+        char buffer[util::TimestampChars];
+        ost.write(buffer, util::write_timestamp(buffer, rec.timestamp) - buffer);
+    }
+
+    void emit_severity(std::ostream& ost, Record const& rec, WriterFunc, const char*, std::size_t)
+    {
+        auto& name = impl::severity_name_of(rec.severity);
+        ost.write(name.text, static_cast<std::streamsize>(name.size));
+    }
+
+    void emit_channel(std::ostream& ost, Record const& rec, WriterFunc, const char*, std::size_t)
+    {
+        write_cstr(ost, rec.channel);
+    }
+
+    void emit_file(std::ostream& ost, Record const& rec, WriterFunc, const char*, std::size_t)
+    {
+        write_cstr(ost, rec.location.file);
+    }
+
+    void emit_basename(std::ostream& ost, Record const& rec, WriterFunc, const char*, std::size_t)
+    {
+        const char* file = rec.location.file;
+        if(!file)
+            return;
+        for(const char* it = file; *it; ++it)
+            if(*it == '/' || *it == '\\')
+                file = it + 1;
+        write_cstr(ost, file);
+    }
+
+    void emit_line(std::ostream& ost, Record const& rec, WriterFunc, const char*, std::size_t)
+    {
+        char buffer[util::MaxIntegerChars];
+        ost.write(buffer, util::write_integer(buffer, rec.location.line) - buffer);
+    }
+
+    void emit_function(std::ostream& ost, Record const& rec, WriterFunc, const char*, std::size_t)
+    {
+        write_cstr(ost, rec.location.func);
+    }
+
+    void emit_site(std::ostream& ost, Record const& rec, WriterFunc, const char*, std::size_t)
+    {
+        char buffer[util::MaxIntegerChars];
+        ost.write(buffer, util::write_integer(buffer, rec.site) - buffer);
+    }
+
+    void emit_context(std::ostream& ost, Record const& rec, WriterFunc, const char*, std::size_t)
+    {
+        ost << rec.context;
+    }
+
+    void emit_message(std::ostream& ost, Record const&, WriterFunc writer, const char*, std::size_t)
+    {
+        writer(ost);
+    }
+
+    template<util::escape::Mode Mode>
+    void emit_escaped(std::ostream& ost, Record const&, WriterFunc writer, const char*, std::size_t)
+    {
+        write_escaped(ost, Mode, writer);
+    }
+}
+
+    void write_escaped(std::ostream& ost, util::escape::Mode mode, WriterFunc writer)
+    {
+        util::SlabStreamBuf text;
+        std::ostream msg(&text);
+        writer(msg);
+        text.for_each_piece([&](const char* data, std::size_t size) { util::escape::write(mode, data, size, ost); });
+    }
+
+    Layout::Layout(std::string const& pattern)
+    {
+        for(std::size_t pos = 0; pos < pattern.size(); ++pos)
+        {
+            char ch = pattern[pos];
+            if(ch == '%')
+            {
+                if(++pos == pattern.size())
+                    throw std::invalid_argument("Layout pattern ends with '%'");
+                ch = pattern[pos];
+            }
+            else
+                ch = '%';   // Plain character is handled the same way as escaped percent sign
+
+            Emitter emit = nullptr;
+            switch(ch)
+            {
+            case '%': emit = &emit_literal;     break;
+            case 'T': emit = &emit_timestamp;   break;
+            case 'L': emit = &emit_severity;    break;
+            case 'C': emit = &emit_channel;     break;
+            case 'f': emit = &emit_file;        break;
+            case 'b': emit = &emit_basename;    break;
+            case 'l': emit = &emit_line;        break;
+            case 'F': emit = &emit_function;    break;
+            case 'S': emit = &emit_site;        break;
+            case 'X': emit = &emit_context;     break;
+            case 'm': emit = &emit_message;     break;
+            case 'J': emit = &emit_escaped<util::escape::Mode::Json>;   break;
+            case 'M': emit = &emit_escaped<util::escape::Mode::Line>;   break;
+            default:
+                throw std::invalid_argument(std::string("Unknown layout directive '%") + ch + "'");
+            }
+
+            if(emit != &emit_literal)
+            {
+                _segments.push_back(Segment { emit, 0, 0 });
+                continue;
+            }
+            // Adjacent literal characters are merged into single span
+            if(_segments.empty() || _segments.back().emit != &emit_literal)
+                _segments.push_back(Segment { emit, _literals.size(), 0 });
+            _literals.push_back(pattern[pos]);
+            ++_segments.back().size;
+        }
+    }
+} // namespace log
+} // namespace toolboxcpp
@@ -2,8 +2,11 @@
 #include <atomic>
 #include <stdexcept>
 
+#include <toolboxcpp/log/Bootstrap.hpp>
 #include <toolboxcpp/log/Log.hpp>
 #include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/log/Profile.hpp>
+#include <toolboxcpp/log/Sites.hpp>
 
 namespace toolboxcpp
 {
@@ -14,9 +17,23 @@ namespace log
 */
 namespace {
     std::atomic<Logger*> g_logger;
+    // Site of the last checked callsite, taken back by its write
+    thread_local SiteId t_entered_site = 0;
+    // Pre-rendered severity names, indexed by severity value
+    const impl::SeverityName SeverityNames[] = {
+        { "NONE",  4 },
+        { "ERROR", 5 },
+        { "WARN",  4 },
+        { "INFO",  4 },
+        { "DEBUG", 5 },
+        { "TRACE", 5 },
+    };
+    static_assert(sizeof(SeverityNames) / sizeof(SeverityNames[0]) == static_cast<std::size_t>(Severity::_Count),
+        "Severity names table doesn't match Severity enum");
 
-    void initMeta(Severity sev, Channel chan, Location loc, Metadata& meta)
+    void initMeta(SiteId site, Severity sev, Channel chan, Location loc, Metadata& meta)
     {
+        meta.site     = site;
         meta.severity = std::min(std::max(sev, Severity::None), Severity::Trace);
         meta.channel  = chan ? chan : "";
         meta.location.file = loc.file ? loc.file : "<unknown>";
@@ -24,42 +41,88 @@ namespace {
         meta.location.func = loc.func ? loc.func : "";    
     }
 
-    void initRecord(Severity sev, Channel chan, Location loc, Record& rec)
+    void initRecord(SiteId site, Severity sev, Channel chan, Location loc, Record& rec)
     {
-        initMeta(sev, chan, loc, rec);
+        initMeta(site, sev, chan, loc, rec);
         rec.timestamp = std::chrono::system_clock::now();
+        rec.context   = context::current();
     }
 }
 
+    const char* severity_name(Severity severity) noexcept
+    {
+        return impl::severity_name_of(severity).text;
+    }
+
     void set_logger_pointer(Logger* logger)
     {
         if(!logger)
             throw std::invalid_argument("logger");
         Logger* expected = nullptr;
-        if(!g_logger.compare_exchange_weak(expected, logger, std::memory_order_acq_rel, std::memory_order_relaxed))
+        if(g_logger.compare_exchange_strong(expected, logger, std::memory_order_acq_rel, std::memory_order_acquire))
+            return;
+        // Bootstrap buffer gives way to the first real logger, after replaying its records into it
+        if(!bootstrap::impl::replay(expected, *logger))
             throw std::logic_error("Logger already initialized");
+        g_logger.store(logger, std::memory_order_release);
     }
 
 namespace impl
 {
+    SeverityName const& severity_name_of(Severity severity) noexcept
+    {
+        auto index = static_cast<std::size_t>(severity);
+        return SeverityNames[index < static_cast<std::size_t>(Severity::_Count) ? index : 0];
+    }
+
     bool is_enabled(Severity sev, Channel chan, Location loc)
+    {
+        return is_enabled(SiteId(), sev, chan, loc);
+    }
+
+    void write(Severity sev, Channel chan, Location loc, WriterFunc writer)
+    {
+        write(SiteId(), sev, chan, loc, writer);
+    }
+
+    bool is_enabled(SiteId site, Severity sev, Channel chan, Location loc)
     {
         Logger* logger = g_logger.load(std::memory_order_relaxed);
-        if(logger == nullptr)
+        if(logger == nullptr || !sites::is_enabled(site))
             return false;
         Metadata meta;
-        initMeta(sev, chan, loc, meta);
-        return logger != nullptr && logger->is_enabled(meta);
+        initMeta(site, sev, chan, loc, meta);
+        return logger->is_enabled(meta);
     }
 
-    void write(Severity sev, Channel chan, Location loc, WriterFunc writer)
+    void write(SiteId site, Severity sev, Channel chan, Location loc, WriterFunc writer)
     {
         Logger* logger = g_logger.load(std::memory_order_relaxed);
         if(logger == nullptr)
             return;
         Record record;
-        initRecord(sev, chan, loc, record);
-        logger->write(record, writer);
+        initRecord(site, sev, chan, loc, record);
+        if(profile::is_enabled())
+            profile::impl::write(*logger, record, writer);
+        else
+            logger->write(record, writer);
+    }
+
+    bool enter_site(SiteId site, Severity sev, Channel chan, Location loc)
+    {
+        bool enabled = is_enabled(site, sev, chan, loc);
+        t_entered_site = site;
+        return enabled;
+    }
+
+    SiteId entered_site() noexcept
+    {
+        return t_entered_site;
+    }
+
+    void write(SiteWrite const& site_write, Severity sev, Channel chan, Location loc)
+    {
+        write(site_write.site, sev, chan, loc, site_write.writer);
     }
 } // namespace impl
 
@@ -0,0 +1,65 @@
+#include <toolboxcpp/log/Priority.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace priority
+{
+    Lanes::Lanes(Options const& options)
+        : _queue(std::vector<Lane>(options.lanes.begin(), options.lanes.end()))
+    { }
+
+    Lanes::~Lanes() = default;
+
+    bool Lanes::push(Record const& record, WriterFunc writer)
+    {
+        return _queue.push(lane_of(record.severity), record, writer);
+    }
+
+    std::size_t Lanes::pop(util::FuncRef<void (Record const&, WriterFunc)> consumer, std::size_t max_records)
+    {
+        auto per_record = [&](BatchEntry const* entries, std::size_t count)
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                auto& entry = entries[i];
+                consumer(entry.record, [&](std::ostream& ost) { write_message(ost, entry); });
+            }
+        };
+        return pop_batch(per_record, max_records);
+    }
+
+    std::size_t Lanes::pop_batch(util::FuncRef<void (BatchEntry const*, std::size_t)> consumer, std::size_t max_records)
+    {
+        return _queue.pop_batch(consumer, max_records);
+    }
+
+    bool Lanes::wait(std::chrono::milliseconds timeout)
+    {
+        return _queue.wait(timeout);
+    }
+
+    void Lanes::wake()
+    {
+        _queue.wake();
+    }
+
+    std::size_t Lanes::depth() const
+    {
+        return _queue.depth();
+    }
+
+    Stats Lanes::stats() const
+    {
+        auto lanes = _queue.stats().lanes;
+        Stats stats;
+        std::copy(lanes.begin(), lanes.end(), stats.begin());
+        return stats;
+    }
+} // namespace priority
+} // namespace log
+} // namespace toolboxcpp
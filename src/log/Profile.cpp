@@ -0,0 +1,398 @@
+#include <toolboxcpp/log/Profile.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <unordered_set>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace profile
+{
+/*
+    Each thread has its own shard: sketch counters have single writer, so they're bumped with
+    relaxed load and store. Owner keeps its heaviest callsites in private list, and publishes
+    copy of that list under shard mutex whenever its membership changes, which is rare once
+    heavy callsites settle. Shard of exited thread is merged into registry's retired totals
+*/
+namespace {
+    static_assert((SketchWidth & (SketchWidth - 1)) == 0, "Sketch width should be power of 2");
+
+    const std::size_t MaxRetiredCandidates = Candidates * 8;
+
+    std::atomic<bool> g_enabled { false };
+
+    struct Candidate
+    {
+        std::uint64_t   key;
+        SiteId          site;
+        Location        location;
+        std::uint64_t   estimate;   ///< Owner's own estimate, used to choose candidate to evict
+    };
+
+    std::uint64_t key_of(Record const& record) noexcept
+    {
+        if(record.site)
+            return record.site;
+        auto file = reinterpret_cast<std::uintptr_t>(record.location.file);
+        return (std::uint64_t(1) << 63) | (std::uint64_t(file) * 31 + static_cast<std::uint64_t>(record.location.line));
+    }
+    // splitmix64 finalizer over key mixed with row seed
+    std::size_t slot_of(std::uint64_t key, std::size_t row) noexcept
+    {
+        std::uint64_t x = key + (row + 1) * 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        return static_cast<std::size_t>(x & (SketchWidth - 1));
+    }
+
+    using Counters = std::vector<std::uint64_t>;
+
+    struct Shard
+    {
+        Shard()
+        {
+            for(auto& counter : bytes)
+                counter.store(0, std::memory_order_relaxed);
+            for(auto& counter : records)
+                counter.store(0, std::memory_order_relaxed);
+        }
+
+        static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        void add(Record const& record, std::uint64_t size)
+        {
+            std::uint64_t key = key_of(record);
+            std::uint64_t estimate = ~std::uint64_t(0);
+            for(std::size_t row = 0; row < SketchDepth; ++row)
+            {
+                std::size_t index = row * SketchWidth + slot_of(key, row);
+                bump(bytes[index], size);
+                bump(records[index], 1);
+                estimate = std::min(estimate, bytes[index].load(std::memory_order_relaxed));
+            }
+
+            auto lightest = heaviest.end();
+            for(auto it = heaviest.begin(); it != heaviest.end(); ++it)
+            {
+                if(it->key == key)
+                {
+                    it->estimate = estimate;
+                    return;
+                }
+                if(lightest == heaviest.end() || it->estimate < lightest->estimate)
+                    lightest = it;
+            }
+            Candidate candidate { key, record.site, record.location, estimate };
+            if(heaviest.size() < Candidates)
+                heaviest.push_back(candidate);
+            else if(estimate > lightest->estimate)
+                *lightest = candidate;
+            else
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            published = heaviest;
+        }
+
+        void merge_into(Counters& total_bytes, Counters& total_records) const
+        {
+            for(std::size_t i = 0; i < SketchWidth * SketchDepth; ++i)
+            {
+                total_bytes[i]   += bytes[i].load(std::memory_order_relaxed);
+                total_records[i] += records[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<std::uint64_t>  bytes[SketchWidth * SketchDepth];
+        std::atomic<std::uint64_t>  records[SketchWidth * SketchDepth];
+        std::vector<Candidate>      heaviest;       ///< Touched by owner only
+        std::mutex                  mutex;          ///< Guards published list
+        std::vector<Candidate>      published;
+    };
+
+    struct Registry
+    {
+        Registry()
+            : retired_bytes(SketchWidth * SketchDepth, 0)
+            , retired_records(SketchWidth * SketchDepth, 0)
+        { }
+
+        static std::uint64_t estimate(Counters const& counters, std::uint64_t key) noexcept
+        {
+            std::uint64_t value = ~std::uint64_t(0);
+            for(std::size_t row = 0; row < SketchDepth; ++row)
+                value = std::min(value, counters[row * SketchWidth + slot_of(key, row)]);
+            return value;
+        }
+
+        void attach(Shard* shard)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shards.push_back(shard);
+        }
+
+        void retire(Shard* shard)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shards.erase(std::find(shards.begin(), shards.end(), shard));
+            shard->merge_into(retired_bytes, retired_records);
+            for(auto& candidate : shard->heaviest)
+                if(std::none_of(retired.begin(), retired.end(), [&](Candidate const& c) { return c.key == candidate.key; }))
+                    retired.push_back(candidate);
+            if(retired.size() > MaxRetiredCandidates)
+            {
+                for(auto& candidate : retired)
+                    candidate.estimate = estimate(retired_bytes, candidate.key);
+                std::sort(retired.begin(), retired.end(), [](Candidate const& left, Candidate const& right) {
+                    return left.estimate > right.estimate;
+                });
+                retired.resize(MaxRetiredCandidates);
+            }
+        }
+
+        std::mutex              mutex;
+        std::vector<Shard*>     shards;
+        Counters                retired_bytes;
+        Counters                retired_records;
+        std::vector<Candidate>  retired;
+    };
+    // Never destroyed, since threads may exit after static destructors have run
+    Registry& registry()
+    {
+        static Registry* instance = new Registry();
+        return *instance;
+    }
+
+    struct ShardHolder
+    {
+        ~ShardHolder()
+        {
+            if(shard)
+                registry().retire(shard.get());
+        }
+
+        std::unique_ptr<Shard> shard;
+    };
+
+    Shard& local_shard()
+    {
+        thread_local ShardHolder holder;
+        if(!holder.shard)
+        {
+            holder.shard.reset(new Shard());
+            registry().attach(holder.shard.get());
+        }
+        return *holder.shard;
+    }
+    // Forwards characters to wrapped buffer through small local put area, counting them
+    class CountingBuf: public std::streambuf
+    {
+    public:
+        explicit CountingBuf(std::streambuf* target)
+            : _target(target)
+            , _count(0)
+        {
+            setp(_buffer, _buffer + sizeof(_buffer));
+        }
+
+        std::uint64_t count() const noexcept { return _count; }
+
+        bool flush_buffer()
+        {
+            std::streamsize size = pptr() - pbase();
+            std::streamsize written = size ? _target->sputn(pbase(), size) : 0;
+            _count += static_cast<std::uint64_t>(written);
+            setp(_buffer, _buffer + sizeof(_buffer));
+            return written == size;
+        }
+
+    protected:
+        int_type overflow(int_type ch) override
+        {
+            if(!flush_buffer())
+                return traits_type::eof();
+            if(traits_type::eq_int_type(ch, traits_type::eof()))
+                return traits_type::not_eof(ch);
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+            return ch;
+        }
+
+        std::streamsize xsputn(const char* data, std::streamsize size) override
+        {
+            if(size <= epptr() - pptr())
+            {
+                traits_type::copy(pptr(), data, static_cast<std::size_t>(size));
+                pbump(static_cast<int>(size));
+                return size;
+            }
+            if(!flush_buffer())
+                return 0;
+            std::streamsize written = _target->sputn(data, size);
+            _count += static_cast<std::uint64_t>(written);
+            return written;
+        }
+
+        int sync() override
+        {
+            return flush_buffer() ? _target->pubsync() : -1;
+        }
+
+    private:
+        std::streambuf* _target;
+        std::uint64_t   _count;
+        char            _buffer[256];
+    };
+    // Swaps stream buffer for counting one, and restores original one together with stream state
+    class CountingScope
+    {
+    public:
+        explicit CountingScope(std::ostream& ost)
+            : _ost(ost)
+            , _state(ost.rdstate())
+            , _original(ost.rdbuf())
+            , _buffer(_original)
+        {
+            ost.rdbuf(&_buffer);
+            ost.clear(_state);
+        }
+
+        ~CountingScope()
+        {
+            _buffer.flush_buffer();
+            std::ios::iostate state = _ost.rdstate();
+            _ost.rdbuf(_original);
+            _ost.clear(_state | state);
+        }
+        // Flushes local put area, so everything written so far gets counted
+        std::uint64_t count()
+        {
+            _buffer.flush_buffer();
+            return _buffer.count();
+        }
+
+    private:
+        std::ostream&       _ost;
+        std::ios::iostate   _state;
+        std::streambuf*     _original;
+        CountingBuf         _buffer;
+    };
+}
+
+    void set_enabled(bool enabled) noexcept
+    {
+        g_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool is_enabled() noexcept
+    {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    std::vector<Callsite> top_callsites(std::size_t count)
+    {
+        auto& reg = registry();
+        Counters bytes, records;
+        std::vector<Candidate> candidates;
+        {
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            bytes   = reg.retired_bytes;
+            records = reg.retired_records;
+            candidates = reg.retired;
+            for(Shard* shard : reg.shards)
+            {
+                shard->merge_into(bytes, records);
+                std::lock_guard<std::mutex> shard_lock(shard->mutex);
+                candidates.insert(candidates.end(), shard->published.begin(), shard->published.end());
+            }
+        }
+
+        std::vector<Callsite> callsites;
+        std::unordered_set<std::uint64_t> seen;
+        for(auto& candidate : candidates)
+            if(seen.insert(candidate.key).second)
+                callsites.push_back(Callsite {
+                    candidate.site, candidate.location,
+                    Registry::estimate(bytes, candidate.key), Registry::estimate(records, candidate.key)
+                });
+        std::sort(callsites.begin(), callsites.end(), [](Callsite const& left, Callsite const& right) {
+            return left.bytes > right.bytes;
+        });
+        if(callsites.size() > count)
+            callsites.resize(count);
+        return callsites;
+    }
+
+    void write_report(std::ostream& ost, std::vector<Callsite> const& callsites)
+    {
+        bool first = true;
+        for(auto& callsite : callsites)
+        {
+            if(!first)
+                ost << "; ";
+            ost << (callsite.location.file ? callsite.location.file : "<unknown>") << ':' << callsite.location.line
+                << " bytes=" << callsite.bytes << " records=" << callsite.records;
+            first = false;
+        }
+    }
+
+    Reporter::Reporter(ReportOptions const& options, util::Executor& executor)
+        : _options(options)
+        , _executor(&executor)
+    {
+        set_enabled(true);
+        _timer = executor.schedule_every(options.interval, [this] { report(); });
+    }
+
+    Reporter::~Reporter()
+    {
+        _executor->cancel(_timer);
+        set_enabled(false);
+    }
+
+    void Reporter::report()
+    {
+        auto callsites = top_callsites(_options.count);
+        Location location = $SourceLocation;
+        if(callsites.empty() || !log::impl::is_enabled(_options.severity, "toolboxcpp.log", location))
+            return;
+        log::impl::write(_options.severity, "toolboxcpp.log", location, [&](std::ostream& ost) {
+            ost << "Top log callsites: ";
+            write_report(ost, callsites);
+        });
+    }
+
+namespace impl
+{
+    void write(Logger& logger, Record const& record, WriterFunc writer)
+    {
+        bool counted = false;
+        std::uint64_t size = 0;
+        // Only the first formatting of message is counted, if logger does it several times
+        auto proxy = [&](std::ostream& ost) {
+            if(counted || !ost.rdbuf())
+            {
+                writer(ost);
+                return;
+            }
+            CountingScope scope(ost);
+            counted = true;
+            writer(ost);
+            size = scope.count();
+        };
+        logger.write(record, proxy);
+        if(counted)
+            local_shard().add(record, size);
+    }
+}
+} // namespace profile
+} // namespace log
+} // namespace toolboxcpp
@@ -0,0 +1,189 @@
+#include <toolboxcpp/log/Queue.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sstream>
+
+namespace toolboxcpp
+{
+namespace log
+{
+    OwnedRecord::OwnedRecord(Record const& record, std::string&& message)
+        : _record(record)
+        , _text(std::move(message))
+        , _context(record.context)
+    {
+        _record.context = Context();
+    }
+
+    struct RecordQueue::State
+    {
+        struct Lane
+        {
+            queue::Lane                 options;
+            std::deque<OwnedRecord>     records;
+            queue::LaneStats            stats;
+        };
+
+        // Lanes are never reallocated, so deque doesn't need to be movable without exceptions
+        explicit State(std::vector<queue::Lane> const& settings)
+            : lanes(settings.size())
+            , current(0)
+            , batches(0)
+            , woken(false)
+        {
+            for(std::size_t i = 0; i < lanes.size(); ++i)
+                lanes[i].options = settings[i];
+            credit = std::max(1u, lanes[0].options.weight);
+        }
+        // Moves round-robin cursor to next lane, refilling its credit
+        void advance()
+        {
+            current = (current + 1) % lanes.size();
+            credit  = std::max(1u, lanes[current].options.weight);
+        }
+
+        bool empty() const
+        {
+            for(auto& lane : lanes)
+                if(!lane.records.empty())
+                    return false;
+            return true;
+        }
+
+        mutable std::mutex          mutex;
+        std::condition_variable     ready;
+        std::vector<Lane>           lanes;
+        std::size_t                 current;    ///< Lane which is being taken from
+        unsigned                    credit;     ///< Records current lane may still give this round
+        std::uint64_t               batches;
+        bool                        woken;
+    };
+
+    RecordQueue::RecordQueue(std::vector<queue::Lane> const& lanes)
+        : _state(new State(lanes))
+    { }
+
+    RecordQueue::~RecordQueue() = default;
+
+    bool RecordQueue::push(std::size_t index, Record const& record, WriterFunc writer)
+    {
+        auto& state = *_state;
+        auto& lane  = state.lanes[index];
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if(lane.records.size() >= lane.options.capacity)
+            {
+                ++lane.stats.dropped;
+                return false;
+            }
+        }
+        // Message is formatted outside of lock; full lane is checked both before and after that
+        std::ostringstream ost;
+        writer(ost);
+        OwnedRecord owned(record, ost.str());
+
+        bool was_empty;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if(lane.records.size() >= lane.options.capacity)
+            {
+                ++lane.stats.dropped;
+                return false;
+            }
+            was_empty = state.empty();
+            lane.records.push_back(std::move(owned));
+            ++lane.stats.queued;
+        }
+        if(was_empty)
+            state.ready.notify_one();
+        return true;
+    }
+
+    std::size_t RecordQueue::pop_batch(util::FuncRef<void (BatchEntry const*, std::size_t)> consumer, std::size_t max_records)
+    {
+        auto& state = *_state;
+        std::vector<OwnedRecord> taken;
+        std::vector<std::size_t> taken_from;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            std::size_t empty = 0;
+            while(taken.size() < max_records && empty < state.lanes.size())
+            {
+                auto& lane = state.lanes[state.current];
+                if(lane.records.empty() || state.credit == 0)
+                {
+                    empty = lane.records.empty() ? empty + 1 : 0;
+                    state.advance();
+                    continue;
+                }
+                empty = 0;
+                taken.push_back(std::move(lane.records.front()));
+                taken_from.push_back(state.current);
+                lane.records.pop_front();
+                --state.credit;
+            }
+        }
+        if(taken.empty())
+            return 0;
+
+        std::vector<BatchEntry> entries;
+        entries.reserve(taken.size());
+        for(auto& owned : taken)
+            entries.push_back(owned.entry());
+        consumer(entries.data(), entries.size());
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for(std::size_t i = 0; i < taken.size(); ++i)
+        {
+            auto& stats = state.lanes[taken_from[i]].stats;
+            ++stats.taken;
+            stats.bytes += taken[i].size();
+        }
+        ++state.batches;
+        return taken.size();
+    }
+
+    bool RecordQueue::wait(std::chrono::milliseconds timeout)
+    {
+        auto& state = *_state;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.ready.wait_for(lock, timeout, [&] { return state.woken || !state.empty(); });
+        state.woken = false;
+        return !state.empty();
+    }
+
+    void RecordQueue::wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+            _state->woken = true;
+        }
+        _state->ready.notify_all();
+    }
+
+    std::size_t RecordQueue::depth() const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        std::size_t depth = 0;
+        for(auto& lane : _state->lanes)
+            depth += lane.records.size();
+        return depth;
+    }
+
+    queue::Stats RecordQueue::stats() const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        queue::Stats stats { std::vector<queue::LaneStats>(), _state->batches };
+        stats.lanes.reserve(_state->lanes.size());
+        for(auto& lane : _state->lanes)
+        {
+            stats.lanes.push_back(lane.stats);
+            stats.lanes.back().depth = lane.records.size();
+        }
+        return stats;
+    }
+} // namespace log
+} // namespace toolboxcpp
@@ -0,0 +1,158 @@
+#include <toolboxcpp/log/Router.hpp>
+
+#include <mutex>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace router
+{
+/*
+    Lookup table slots are only ever filled, never changed or cleared. Index is stored before key,
+    and key is published with release, so reader which sees key sees its index too.
+    Since table is never more than half full, probing always stops at empty slot.
+*/
+namespace {
+    struct Slot
+    {
+        std::atomic<const char*>    key;
+        std::atomic<std::size_t>    index;
+    };
+
+    std::size_t round_up_pow2(std::size_t value)
+    {
+        std::size_t result = 16;
+        while(result < value)
+            result *= 2;
+        return result;
+    }
+    // Fibonacci hashing of pointer; low bits are dropped since they're mostly alignment
+    std::size_t hash(Channel channel, unsigned shift)
+    {
+        auto bits = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(channel)) >> 3;
+        return static_cast<std::size_t>((bits * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+}
+
+    struct Table::State
+    {
+        State(std::vector<std::string>&& names, std::size_t size)
+            : channels(std::move(names))
+            , slots(new Slot[round_up_pow2(size)])
+            , mask(round_up_pow2(size) - 1)
+            , shift(64)
+            , used(0)
+        {
+            for(std::size_t i = 0; i <= mask; ++i)
+            {
+                slots[i].key.store(nullptr, std::memory_order_relaxed);
+                slots[i].index.store(0, std::memory_order_relaxed);
+            }
+            for(std::size_t i = mask; i != 0; i >>= 1)
+                --shift;
+            channels.emplace_back();
+        }
+        // Slot which holds channel, or first empty slot in its probe sequence
+        Slot& probe(Channel channel) const
+        {
+            for(std::size_t i = hash(channel, shift);; i = (i + 1) & mask)
+            {
+                const char* key = slots[i].key.load(std::memory_order_acquire);
+                if(key == channel || key == nullptr)
+                    return slots[i];
+            }
+        }
+
+        std::vector<std::string>    channels;   ///< Fallback has empty channel at the end
+        std::unique_ptr<Slot[]>     slots;
+        std::size_t                 mask;
+        unsigned                    shift;
+        std::size_t                 used;       ///< Number of filled slots, guarded by mutex
+        std::mutex                  mutex;
+    };
+
+    Table::Table(std::vector<std::string> channels, std::size_t slots)
+        : _state(new State(std::move(channels), slots))
+    { }
+
+    Table::~Table() = default;
+
+    std::size_t Table::find(Channel channel) const
+    {
+        if(channel == nullptr)
+            return size();
+        Slot& slot = _state->probe(channel);
+        if(slot.key.load(std::memory_order_relaxed) == channel)
+            return slot.index.load(std::memory_order_relaxed);
+        return insert(channel);
+    }
+
+    std::size_t Table::insert(Channel channel) const
+    {
+        auto& state = *_state;
+        std::size_t index = 0;
+        while(index < size() && state.channels[index] != channel)
+            ++index;
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        // Another thread might have cached it already
+        Slot& slot = state.probe(channel);
+        if(slot.key.load(std::memory_order_relaxed) == nullptr && (state.used + 1) * 2 <= state.mask + 1)
+        {
+            slot.index.store(index, std::memory_order_relaxed);
+            slot.key.store(channel, std::memory_order_release);
+            ++state.used;
+        }
+        return index;
+    }
+
+    std::size_t Table::size() const noexcept
+    {
+        return _state->channels.size() - 1;
+    }
+
+    std::string const& Table::channel(std::size_t index) const noexcept
+    {
+        return _state->channels[index < size() ? index : size()];
+    }
+    Queue::Queue(std::size_t capacity)
+        : _queue(std::vector<queue::Lane>(1, queue::Lane { capacity, 1 }))
+    { }
+
+    Queue::~Queue() = default;
+
+    bool Queue::push(Record const& record, WriterFunc writer)
+    {
+        return _queue.push(0, record, writer);
+    }
+
+    std::size_t Queue::pop_batch(util::FuncRef<void (BatchEntry const*, std::size_t)> consumer, std::size_t max_records)
+    {
+        return _queue.pop_batch(consumer, max_records);
+    }
+
+    bool Queue::wait(std::chrono::milliseconds timeout)
+    {
+        return _queue.wait(timeout);
+    }
+
+    void Queue::wake()
+    {
+        _queue.wake();
+    }
+
+    std::size_t Queue::depth() const
+    {
+        return _queue.depth();
+    }
+
+    Stats Queue::stats() const
+    {
+        auto stats = _queue.stats();
+        auto& lane = stats.lanes[0];
+        return Stats { lane.queued, lane.taken, lane.bytes, stats.batches, lane.dropped, lane.depth };
+    }
+} // namespace router
+} // namespace log
+} // namespace toolboxcpp
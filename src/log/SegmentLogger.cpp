@@ -0,0 +1,312 @@
+#include <toolboxcpp/log/SegmentLogger.hpp>
+#include <toolboxcpp/util/Executor.hpp>
+#include <toolboxcpp/util/Resource.hpp>
+#include <toolboxcpp/util/Slab.hpp>
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace segment
+{
+    std::string segment_path(std::string const& base_path, std::size_t index)
+    {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%06zu", index);
+        return base_path + suffix;
+    }
+} // namespace segment
+/*
+    Segment files are created exclusively, so existing segments are never overwritten;
+    index is simply advanced past them. Spare segment is created and reserved
+    on shared executor and handed over through shared state
+*/
+namespace {
+    struct CloseFd
+    {
+        static int zero() noexcept { return -1; }
+        void operator()(int fd) const noexcept { ::close(fd); }
+    };
+
+    using Fd = util::Resource<int, CloseFd>;
+
+    Fd create_segment(std::string const& path, std::size_t size)
+    {
+        Fd fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644));
+        if(fd.empty())
+            return fd;
+        // Filesystem without reservation support still works, just without flat latency
+#ifdef __linux__
+        (void)::fallocate(fd, 0, 0, static_cast<off_t>(size));
+#else
+        (void)::posix_fallocate(fd, 0, static_cast<off_t>(size));
+#endif
+        return fd;
+    }
+    // Finds first free index starting from specified one; empty descriptor on failure other than EEXIST
+    Fd create_free_segment(std::string const& base_path, std::size_t size, std::size_t& index, std::string& path)
+    {
+        while(true)
+        {
+            path = segment::segment_path(base_path, index);
+            Fd fd = create_segment(path, size);
+            if(!fd.empty() || errno != EEXIST)
+                return fd;
+            ++index;
+        }
+    }
+    // Writes all vectors at specified offset, resuming after short writes
+    bool write_all(int fd, iovec* vec, int count, std::uint64_t offset, std::uint64_t& written)
+    {
+        while(count > 0)
+        {
+            ssize_t rc = ::pwritev(fd, vec, count, static_cast<off_t>(offset));
+            if(rc < 0 && errno == EINTR)
+                continue;
+            if(rc <= 0)
+                return false;
+            auto done = static_cast<std::size_t>(rc);
+            offset  += done;
+            written += done;
+            while(count > 0 && done >= vec->iov_len)
+            {
+                done -= vec->iov_len;
+                ++vec;
+                --count;
+            }
+            if(count > 0)
+            {
+                vec->iov_base = static_cast<char*>(vec->iov_base) + done;
+                vec->iov_len -= done;
+            }
+        }
+        return true;
+    }
+
+    struct Spare
+    {
+        std::mutex              mutex;
+        std::condition_variable ready_cv;
+        bool                    ready   = false;
+        std::size_t             index   = 0;
+        std::string             path;
+        Fd                      fd;
+    };
+}
+
+    struct SegmentLogger::State
+    {
+        State(std::string const& base, segment::Options const& opts)
+            : options(opts)
+            , base_path(base)
+        {
+            fd = create_free_segment(base_path, options.segment_size, index, path);
+            if(fd.empty())
+                throw std::system_error(errno, std::system_category(), path);
+            ++stats.segments;
+            prepare_spare();
+        }
+
+        ~State()
+        {
+            close_current();
+            if(spare)
+            {
+                std::unique_lock<std::mutex> lock(spare->mutex);
+                spare->ready_cv.wait(lock, [&] { return spare->ready; });
+                if(!spare->fd.empty())
+                {
+                    spare->fd.reset(CloseFd::zero());
+                    ::unlink(spare->path.c_str());
+                }
+            }
+        }
+
+        void prepare_spare()
+        {
+            if(!options.preallocate_next)
+                return;
+            spare = std::make_shared<Spare>();
+            spare->index = index + 1;
+            spare->path  = segment::segment_path(base_path, spare->index);
+            std::shared_ptr<Spare> next = spare;
+            std::size_t size = options.segment_size;
+            util::Executor::shared().submit([next, size] {
+                Fd fd = create_segment(next->path, size);
+                std::lock_guard<std::mutex> lock(next->mutex);
+                next->fd    = std::move(fd);
+                next->ready = true;
+                next->ready_cv.notify_all();
+            });
+        }
+
+        bool open_next()
+        {
+            close_current();
+            std::size_t next_index = index + 1;
+            if(spare)
+            {
+                std::unique_lock<std::mutex> lock(spare->mutex);
+                spare->ready_cv.wait(lock, [&] { return spare->ready; });
+                if(!spare->fd.empty())
+                {
+                    fd   = std::move(spare->fd);
+                    path = spare->path;
+                }
+                next_index = spare->index;
+                lock.unlock();
+                spare.reset();
+            }
+            if(fd.empty())
+                fd = create_free_segment(base_path, options.segment_size, next_index, path);
+            if(fd.empty())
+                return false;
+            index = next_index;
+            ++stats.segments;
+            prepare_spare();
+            return true;
+        }
+
+        void close_current()
+        {
+            if(fd.empty())
+                return;
+            sync_all();
+            // Cut reserved but unused space, so that segment ends with the last record
+            (void)::ftruncate(fd, static_cast<off_t>(cursor));
+            fd.reset(CloseFd::zero());
+            cursor = synced = waited = 0;
+        }
+        /*
+            Writeback of the new chunk is only started, while the previous chunk, whose writeback
+            was started one step earlier and has most likely finished, is waited for.
+            So dirty data is bounded by two chunks and writer rarely blocks on disk
+        */
+        void sync_behind()
+        {
+#ifdef __linux__
+            ::sync_file_range(fd, static_cast<off64_t>(synced), static_cast<off64_t>(cursor - synced), SYNC_FILE_RANGE_WRITE);
+            if(synced > waited)
+                ::sync_file_range(fd, static_cast<off64_t>(waited), static_cast<off64_t>(synced - waited),
+                    SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            ++stats.range_syncs;
+#endif
+            waited = synced;
+            synced = cursor;
+        }
+
+        void sync_all()
+        {
+            if(cursor > waited)
+            {
+#ifdef __linux__
+                ::sync_file_range(fd, static_cast<off64_t>(waited), static_cast<off64_t>(cursor - waited),
+                    SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+                ++stats.range_syncs;
+#else
+                ::fdatasync(fd);
+#endif
+            }
+            waited = synced = cursor;
+        }
+
+        void write(util::SlabStreamBuf& buffer)
+        {
+            std::size_t size = buffer.size();
+            // Record larger than segment gets a segment of its own, growing past reserved size
+            if(fd.empty() || (cursor > 0 && cursor + size > options.segment_size))
+            {
+                if(!open_next())
+                {
+                    ++stats.errors;
+                    return;
+                }
+            }
+
+            const int MaxVectors = 16;
+            iovec vec[MaxVectors];
+            int count = 0;
+            bool ok = true;
+            std::uint64_t written = 0;
+            buffer.for_each_piece([&](char const* data, std::size_t piece) {
+                vec[count++] = iovec { const_cast<char*>(data), piece };
+                if(count == MaxVectors)
+                {
+                    ok = ok && write_all(fd, vec, count, cursor + written, written);
+                    count = 0;
+                }
+            });
+            ok = ok && write_all(fd, vec, count, cursor + written, written);
+
+            cursor += written;
+            stats.written_bytes += written;
+            if(!ok)
+                ++stats.errors;
+            if(cursor - synced >= options.sync_chunk)
+                sync_behind();
+        }
+
+        segment::Options        options;
+        std::string             base_path;
+        mutable std::mutex      mutex;
+
+        Fd                      fd;
+        std::string             path;
+        std::size_t             index   = 0;
+        std::uint64_t           cursor  = 0;    ///< Write offset
+        std::uint64_t           synced  = 0;    ///< Writeback is started for everything before this offset
+        std::uint64_t           waited  = 0;    ///< Writeback is finished for everything before this offset
+        std::shared_ptr<Spare>  spare;
+
+        segment::Stats          stats   = segment::Stats();
+    };
+
+    SegmentLogger::SegmentLogger(std::string const& base_path, segment::Options const& options)
+        : _state(new State(base_path, options))
+    { }
+
+    SegmentLogger::SegmentLogger(SegmentLogger&&)               = default;
+    SegmentLogger& SegmentLogger::operator=(SegmentLogger&&)    = default;
+    SegmentLogger::~SegmentLogger()                             = default;
+
+    void SegmentLogger::write(Record const&, WriterFunc writer)
+    {
+        util::SlabStreamBuf buffer;
+        std::ostream ost(&buffer);
+        writer(ost);
+        ost.put('\n');
+
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        _state->write(buffer);
+    }
+
+    void SegmentLogger::flush()
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        if(!_state->fd.empty())
+            _state->sync_all();
+    }
+
+    std::string SegmentLogger::current_path() const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        return _state->path;
+    }
+
+    segment::Stats SegmentLogger::stats() const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        return _state->stats;
+    }
+} // namespace log
+} // namespace toolboxcpp
@@ -0,0 +1,419 @@
+#include <toolboxcpp/log/ShmLogger.hpp>
+#include <toolboxcpp/util/Slab.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace shm
+{
+    void Unmap::operator()(void* address) const noexcept
+    {
+        ::munmap(address, size);
+    }
+
+namespace impl
+{
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "Ring needs address-free atomics");
+    static_assert(sizeof(Slot) % 8 == 0, "Slot header should keep payload aligned");
+/*
+    Creator initializes header and slots, and publishes magic last; others wait for it.
+    Object is created with O_EXCL, so exactly one process becomes creator
+*/
+namespace {
+    struct CloseFd
+    {
+        static int zero() noexcept { return -1; }
+        void operator()(int fd) const noexcept { ::close(fd); }
+    };
+
+    using Fd = util::Resource<int, CloseFd>;
+
+    const int   WaitSteps   = 1000;
+    const auto  WaitStep    = std::chrono::milliseconds(1);
+
+    Mapping map(int fd, std::size_t size)
+    {
+        void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        return Mapping(address == MAP_FAILED ? nullptr : address, Unmap { size });
+    }
+
+    Mapping create(int fd, std::string const& name, Options const& options)
+    {
+        std::size_t slot_size = std::max<std::size_t>(sizeof(Slot) + 8, (options.slot_size + 63) / 64 * 64);
+        std::size_t slots     = std::max<std::size_t>(2, options.slots);
+        std::size_t size      = sizeof(Header) + slot_size * slots;
+        if(::ftruncate(fd, static_cast<off_t>(size)) != 0)
+            throw std::system_error(errno, std::system_category(), name);
+        Mapping mapping = map(fd, size);
+        if(mapping.empty())
+            throw std::system_error(errno, std::system_category(), name);
+
+        auto header = new (mapping.get()) Header();
+        header->version   = Version;
+        header->slot_size = static_cast<std::uint32_t>(slot_size);
+        header->slots     = static_cast<std::uint32_t>(slots);
+        header->head.store(0, std::memory_order_relaxed);
+        header->tail.store(0, std::memory_order_relaxed);
+        header->dropped.store(0, std::memory_order_relaxed);
+        for(std::uint64_t i = 0; i < slots; ++i)
+        {
+            auto slot = new (slot_at(header, i)) Slot();
+            slot->seq.store(i, std::memory_order_relaxed);
+            slot->claim.store(claim_of(i, Unclaimed), std::memory_order_relaxed);
+            slot->pid.store(0, std::memory_order_relaxed);
+        }
+        header->magic.store(Magic, std::memory_order_release);
+        return mapping;
+    }
+
+    Mapping attach(int fd, std::string const& name)
+    {
+        struct stat st;
+        for(int i = 0; ; ++i)
+        {
+            if(::fstat(fd, &st) != 0)
+                throw std::system_error(errno, std::system_category(), name);
+            if(static_cast<std::size_t>(st.st_size) >= sizeof(Header))
+                break;
+            if(i == WaitSteps)
+                throw std::runtime_error("Shared memory ring " + name + " wasn't initialized");
+            std::this_thread::sleep_for(WaitStep);
+        }
+
+        Mapping mapping = map(fd, static_cast<std::size_t>(st.st_size));
+        if(mapping.empty())
+            throw std::system_error(errno, std::system_category(), name);
+        auto header = static_cast<Header*>(mapping.get());
+        for(int i = 0; header->magic.load(std::memory_order_acquire) != Magic; ++i)
+        {
+            if(i == WaitSteps)
+                throw std::runtime_error("Shared memory ring " + name + " wasn't initialized");
+            std::this_thread::sleep_for(WaitStep);
+        }
+        if(header->version != Version
+            || sizeof(Header) + static_cast<std::uint64_t>(header->slot_size) * header->slots > static_cast<std::uint64_t>(st.st_size))
+            throw std::runtime_error("Shared memory object " + name + " isn't compatible log ring");
+        return mapping;
+    }
+}
+
+    Mapping open_ring(std::string const& name, Options const& options)
+    {
+        Fd fd(::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600));
+        if(!fd.empty())
+            return create(fd, name, options);
+        if(errno != EEXIST)
+            throw std::system_error(errno, std::system_category(), name);
+        fd = Fd(::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0600));
+        if(fd.empty())
+            throw std::system_error(errno, std::system_category(), name);
+        return attach(fd, name);
+    }
+} // namespace impl
+} // namespace shm
+/*
+    Process identifier is cached, and refreshed in child after fork
+*/
+namespace {
+    using namespace shm;
+    using namespace shm::impl;
+
+    std::atomic<int> g_pid { 0 };
+
+    void refresh_pid()
+    {
+        g_pid.store(static_cast<int>(::getpid()), std::memory_order_relaxed);
+    }
+
+    int current_pid()
+    {
+        int pid = g_pid.load(std::memory_order_relaxed);
+        if(pid)
+            return pid;
+        static bool registered = (::pthread_atfork(nullptr, nullptr, &refresh_pid), true);
+        (void)registered;
+        refresh_pid();
+        return g_pid.load(std::memory_order_relaxed);
+    }
+
+    bool process_alive(int pid)
+    {
+        return ::kill(pid, 0) == 0 || errno == EPERM;
+    }
+
+    /*
+        Slot's data may be written only by owner of its claim. Free claim is either unclaimed one
+        of this very ticket, or one released by late owner of earlier ticket; anything else means
+        that collector skipped this ticket, or that late owner still holds slot, and record is dropped
+    */
+    bool claim(Slot* slot, std::uint64_t ticket)
+    {
+        std::uint64_t current = slot->claim.load(std::memory_order_acquire);
+        while(current == claim_of(ticket, Unclaimed) || ((current & 3) == Released && (current >> 2) < ticket))
+        {
+            if(slot->claim.compare_exchange_weak(current, claim_of(ticket, Owned), std::memory_order_acquire, std::memory_order_acquire))
+                return true;
+        }
+        return false;
+    }
+
+    std::int64_t to_nanos(Timestamp timestamp)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    }
+}
+
+    struct ShmLogger::State
+    {
+        State(std::string const& name, Options const& options)
+            : mapping(open_ring(name, options))
+            , header(static_cast<Header*>(mapping.get()))
+        { }
+
+        Mapping                     mapping;
+        Header*                     header;
+        std::atomic<std::uint64_t>  written     { 0 };
+        std::atomic<std::uint64_t>  dropped     { 0 };
+        std::atomic<std::uint64_t>  truncated   { 0 };
+    };
+
+    ShmLogger::ShmLogger(std::string const& name, Options const& options)
+        : _state(new State(name, options))
+    { }
+
+    ShmLogger::ShmLogger(ShmLogger&&)               = default;
+    ShmLogger& ShmLogger::operator=(ShmLogger&&)    = default;
+    ShmLogger::~ShmLogger()                         = default;
+
+    void ShmLogger::write(Record const& record, WriterFunc writer)
+    {
+        util::SlabStreamBuf text;
+        std::ostream ost(&text);
+        writer(ost);
+
+        Header* header = _state->header;
+        std::uint64_t ticket = header->head.load(std::memory_order_relaxed);
+        Slot* slot;
+        while(true)
+        {
+            slot = slot_at(header, ticket);
+            auto diff = static_cast<std::int64_t>(slot->seq.load(std::memory_order_acquire) - ticket);
+            if(diff == 0)
+            {
+                if(header->head.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+            {
+                // Collector is a whole lap behind
+                header->dropped.fetch_add(1, std::memory_order_relaxed);
+                _state->dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+                ticket = header->head.load(std::memory_order_relaxed);
+        }
+        if(!claim(slot, ticket))
+        {
+            header->dropped.fetch_add(1, std::memory_order_relaxed);
+            _state->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        slot->pid.store(current_pid(), std::memory_order_relaxed);
+
+        std::size_t capacity = header->slot_size - sizeof(Slot);
+        std::size_t size = 0;
+        text.for_each_piece([&](char const* data, std::size_t piece) {
+            std::size_t chunk = std::min(piece, capacity - size);
+            std::memcpy(slot->data() + size, data, chunk);
+            size += chunk;
+        });
+        char const* channel = record.channel ? record.channel : "";
+        std::size_t channel_size = std::min(std::strlen(channel), sizeof(slot->channel));
+        std::memcpy(slot->channel, channel, channel_size);
+        slot->channel_size  = static_cast<std::uint8_t>(channel_size);
+        slot->size          = static_cast<std::uint32_t>(size);
+        slot->timestamp     = to_nanos(record.timestamp);
+        slot->severity      = static_cast<std::uint8_t>(record.severity);
+        bool truncated      = size < text.size();
+        slot->truncated     = truncated;
+
+        std::uint64_t expected = ticket;
+        if(slot->seq.compare_exchange_strong(expected, ticket + 1, std::memory_order_release, std::memory_order_relaxed))
+        {
+            _state->written.fetch_add(1, std::memory_order_relaxed);
+            if(truncated)
+                _state->truncated.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            // Collector has given up on this slot; it may be reused only after we're done with it
+            slot->pid.store(0, std::memory_order_relaxed);
+            slot->claim.store(claim_of(ticket, Released), std::memory_order_release);
+            _state->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Stats ShmLogger::stats() const
+    {
+        return Stats {
+            _state->written.load(std::memory_order_relaxed),
+            _state->dropped.load(std::memory_order_relaxed),
+            _state->truncated.load(std::memory_order_relaxed),
+        };
+    }
+
+    struct ShmCollector::State
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Ring
+        {
+            Mapping                 mapping;
+            Header*                 header;
+            std::uint64_t           stalled_ticket;     ///< Uncommitted slot of live or unknown owner seen last time
+            Clock::time_point       stalled_since;
+        };
+
+        State(std::vector<std::string> const& names, Options const& opts)
+            : options(opts)
+        {
+            for(auto& name : names)
+            {
+                Mapping mapping = open_ring(name, options);
+                auto header = static_cast<Header*>(mapping.get());
+                rings.push_back(Ring { std::move(mapping), header, ~std::uint64_t(0), Clock::time_point() });
+            }
+        }
+        /*
+            Reserved but uncommitted slot is skipped at once if its owner is dead, or if it's still held
+            by late owner of earlier ticket, so its own producer can't claim it. Slot of live or unknown owner
+            is skipped once it stays uncommitted longer than `abandon_after`; pid may be stale or recycled.
+            Skipping races with claim and commit through CAS, so exactly one side wins. Claim of slot whose
+            owner may still write is left abandoned, and slot isn't reused till that owner releases it
+        */
+        void drain(Ring& ring, std::vector<Entry>& entries)
+        {
+            Header* header = ring.header;
+            std::uint64_t tail = header->tail.load(std::memory_order_relaxed);
+            while(true)
+            {
+                Slot* slot = slot_at(header, tail);
+                std::uint64_t seq = slot->seq.load(std::memory_order_acquire);
+                if(seq == tail + 1)
+                {
+                    Entry entry {
+                        Timestamp(std::chrono::duration_cast<Timestamp::duration>(std::chrono::nanoseconds(slot->timestamp))),
+                        slot->severity < static_cast<unsigned>(Severity::_Count) ? static_cast<Severity>(slot->severity) : Severity::None,
+                        slot->pid.load(std::memory_order_relaxed),
+                        std::string(slot->channel, std::min<std::size_t>(slot->channel_size, sizeof(slot->channel))),
+                        std::string(slot->data(), std::min<std::size_t>(slot->size, header->slot_size - sizeof(Slot))),
+                        slot->truncated != 0,
+                    };
+                    entries.push_back(std::move(entry));
+                    release(header, slot, tail);
+                    ++tail;
+                    continue;
+                }
+                if(seq != tail || header->head.load(std::memory_order_acquire) <= tail)
+                    break;  // Nothing reserved yet
+
+                std::uint64_t claim = slot->claim.load(std::memory_order_acquire);
+                bool held_by_earlier = (claim >> 2) < tail && ((claim & 3) == Owned || (claim & 3) == Abandoned);
+                if(!held_by_earlier)
+                {
+                    int pid = claim == claim_of(tail, Owned) ? slot->pid.load(std::memory_order_relaxed) : 0;
+                    bool dead = pid != 0 && !process_alive(pid);
+                    if(!dead)
+                    {
+                        auto now = Clock::now();
+                        if(ring.stalled_ticket != tail)
+                        {
+                            ring.stalled_ticket = tail;
+                            ring.stalled_since  = now;
+                            break;
+                        }
+                        if(now - ring.stalled_since < options.abandon_after)
+                            break;
+                    }
+                    // Dead owner won't touch slot anymore, and neither will producer which hasn't claimed it
+                    bool reusable = dead || claim != claim_of(tail, Owned);
+                    std::uint64_t next = reusable ? claim_of(tail + header->slots, Unclaimed) : claim_of(tail, Abandoned);
+                    if(!slot->claim.compare_exchange_strong(claim, next, std::memory_order_acq_rel))
+                        continue;   // Claimed or released just now
+                    if(reusable)
+                        slot->pid.store(0, std::memory_order_relaxed);
+                }
+                std::uint64_t expected = tail;
+                if(!slot->seq.compare_exchange_strong(expected, tail + header->slots, std::memory_order_acq_rel))
+                    continue;   // Committed just now
+                ++stats.abandoned;
+                header->tail.store(++tail, std::memory_order_release);
+            }
+        }
+
+        void release(Header* header, Slot* slot, std::uint64_t ticket)
+        {
+            slot->pid.store(0, std::memory_order_relaxed);
+            slot->claim.store(claim_of(ticket + header->slots, Unclaimed), std::memory_order_relaxed);
+            slot->seq.store(ticket + header->slots, std::memory_order_release);
+            header->tail.store(ticket + 1, std::memory_order_release);
+        }
+
+        Options                 options;
+        std::vector<Ring>       rings;
+        mutable std::mutex      mutex;
+        CollectorStats          stats   = CollectorStats();
+    };
+
+    ShmCollector::ShmCollector(std::vector<std::string> const& names, Options const& options)
+        : _state(new State(names, options))
+    { }
+
+    ShmCollector::ShmCollector(ShmCollector&&)              = default;
+    ShmCollector& ShmCollector::operator=(ShmCollector&&)   = default;
+    ShmCollector::~ShmCollector()                           = default;
+
+    std::size_t ShmCollector::drain(util::FuncRef<void (Entry const&)> consumer)
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        std::vector<Entry> entries;
+        for(auto& ring : _state->rings)
+            _state->drain(ring, entries);
+        std::stable_sort(entries.begin(), entries.end(), [](Entry const& left, Entry const& right) {
+            return left.timestamp < right.timestamp;
+        });
+        for(auto& entry : entries)
+            consumer(entry);
+        _state->stats.collected += entries.size();
+        return entries.size();
+    }
+
+    CollectorStats ShmCollector::stats() const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        CollectorStats stats = _state->stats;
+        stats.dropped = 0;
+        for(auto& ring : _state->rings)
+            stats.dropped += ring.header->dropped.load(std::memory_order_relaxed);
+        return stats;
+    }
+} // namespace log
+} // namespace toolboxcpp
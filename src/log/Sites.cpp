@@ -0,0 +1,129 @@
+#include <toolboxcpp/log/Sites.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace sites
+{
+/*
+    Sites are registered from static initializers of arbitrary translation units,
+    so registry is constructed on first use and never destroyed.
+    Registry keeps its own copies of site strings, since descriptors of unloaded
+    libraries point into unmapped memory.
+    Switched off sites are kept in statically zero-initialized bitmap,
+    which makes check lock-free and valid at any point of program's lifetime
+*/
+namespace {
+    using Key = std::tuple<std::string, int, Severity>;
+
+    struct Registry
+    {
+        std::mutex              mutex;
+        std::deque<Site>        sites;      ///< Indexed by identifier minus one
+        std::map<Key, SiteId>   index;
+        std::set<std::string>   strings;    ///< Copies of site strings, nodes are never moved
+    };
+
+    Registry& registry()
+    {
+        static Registry* instance = new Registry();
+        return *instance;
+    }
+
+    std::atomic<std::uint64_t> g_disabled[MaxToggled / 64];
+
+    const char* intern(Registry& reg, const char* text)
+    {
+        return reg.strings.insert(text).first->c_str();
+    }
+
+    const char* basename(const char* file)
+    {
+        for(const char* it = file; *it; ++it)
+            if(*it == '/' || *it == '\\')
+                file = it + 1;
+        return file;
+    }
+}
+
+    std::size_t count() noexcept
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        return reg.sites.size();
+    }
+
+    Site get(SiteId id)
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        if(id == 0 || id > reg.sites.size())
+            throw std::out_of_range("Unknown log site");
+        return reg.sites[id - 1];
+    }
+
+    std::vector<Site> list()
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        return std::vector<Site>(reg.sites.begin(), reg.sites.end());
+    }
+
+    bool is_enabled(SiteId id) noexcept
+    {
+        if(id == 0 || id > MaxToggled)
+            return true;
+        std::size_t bit = id - 1;
+        return !(g_disabled[bit / 64].load(std::memory_order_relaxed) & (std::uint64_t(1) << bit % 64));
+    }
+
+    void set_enabled(SiteId id, bool enabled)
+    {
+        if(id == 0 || id > count() || id > MaxToggled)
+            throw std::out_of_range("Unknown log site");
+        std::size_t bit  = id - 1;
+        auto        mask = std::uint64_t(1) << bit % 64;
+        if(enabled)
+            g_disabled[bit / 64].fetch_and(~mask, std::memory_order_relaxed);
+        else
+            g_disabled[bit / 64].fetch_or(mask, std::memory_order_relaxed);
+    }
+} // namespace sites
+
+namespace impl
+{
+    SiteId attach_site(Site const& site)
+    {
+        auto& reg  = sites::registry();
+        auto  file = site.file ? site.file : "<unknown>";
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        auto inserted = reg.index.insert(std::make_pair(sites::Key(file, site.line, site.severity), SiteId(0)));
+        if(!inserted.second)
+            return inserted.first->second;
+
+        SiteId id = static_cast<SiteId>(reg.sites.size() + 1);
+        Site stored = site;
+        stored.id       = id;
+        stored.channel  = sites::intern(reg, site.channel ? site.channel : "");
+        stored.file     = sites::intern(reg, file);
+        stored.basename = sites::basename(stored.file);
+        reg.sites.push_back(stored);
+        inserted.first->second = id;
+        return id;
+    }
+} // namespace impl
+} // namespace log
+} // namespace toolboxcpp
@@ -0,0 +1,377 @@
+#include <toolboxcpp/log/SocketLogger.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace toolboxcpp
+{
+namespace log
+{
+namespace socket
+{
+    void FdCloser::operator()(int fd) const noexcept
+    {
+        ::close(fd);
+    }
+
+namespace {
+    bool set_nonblocking(int fd)
+    {
+        int flags = ::fcntl(fd, F_GETFL);
+        return flags != -1 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+    }
+
+    FileDescriptor connect_unix(std::string const& path, int type)
+    {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if(path.size() >= sizeof(addr.sun_path))
+            return FileDescriptor();
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+        FileDescriptor fd(::socket(AF_UNIX, type, 0));
+        if(fd.empty() || ::fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
+            return FileDescriptor();
+        if(::connect(fd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == -1)
+            return FileDescriptor();
+        if(!set_nonblocking(fd))
+            return FileDescriptor();
+        return fd;
+    }
+}
+
+    Connector unix_stream(std::string path)
+    {
+        return [path] { return connect_unix(path, SOCK_STREAM); };
+    }
+
+    Connector unix_datagram(std::string path)
+    {
+        return [path] { return connect_unix(path, SOCK_DGRAM); };
+    }
+
+    Connector fifo(std::string path)
+    {
+        // Opening FIFO for writing in non-blocking mode fails with ENXIO
+        // when there's no reader, which is exactly "peer is down" for us
+        return [path] { return FileDescriptor(::open(path.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC)); };
+    }
+} // namespace socket
+/*
+    State shared between writers and background thread
+    Everything except descriptor is guarded by mutex; descriptor is touched only by background thread
+*/
+namespace {
+    using Clock = std::chrono::steady_clock;
+    // How long background thread waits for peer to accept data before re-checking stop flag
+    const int PollTimeoutMs = 100;
+}
+
+    struct SocketLogger::State
+    {
+        State(socket::Connector connector, socket::FileDescriptor fd, socket::Options const& options)
+            : connector(std::move(connector))
+            , options(options)
+            , fd(std::move(fd))
+        {
+            this->options.max_batch = std::max<std::size_t>(1, std::min<std::size_t>(this->options.max_batch, IOV_MAX));
+            if(!this->fd.empty())
+                on_connected();
+            else
+                peer_down = !this->connector;
+            worker = std::thread([this] { run(); });
+        }
+
+        ~State()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            worker.join();
+        }
+
+        void push(std::string message)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(message.size() > options.buffer_limit - std::min(pending_bytes, options.buffer_limit))
+                {
+                    ++dropped_records;
+                    dropped_bytes += message.size();
+                    return;
+                }
+                pending_bytes += message.size();
+                queue.push_back(std::move(message));
+            }
+            wake.notify_one();
+        }
+
+        void on_connected()
+        {
+            int type = 0;
+            socklen_t len = sizeof(type);
+            is_socket   = ::getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) == 0;
+            is_datagram = is_socket && type != SOCK_STREAM;
+            socket::set_nonblocking(fd);
+            connected   = true;
+            peer_down   = false;
+            ++reconnects;
+        }
+
+        void on_disconnected()
+        {
+            // Tail of partially sent record would be garbage for the next connection
+            if(head_offset != 0)
+                consume(1, false);
+            fd.reset(socket::FdCloser::zero());
+            connected = false;
+            peer_down = true;
+            drained.notify_all();
+        }
+        // Removes `count` leading records from queue, with accounting
+        void consume(std::size_t count, bool sent)
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                auto size = queue.front().size() - head_offset;
+                pending_bytes -= queue.front().size();
+                if(sent)
+                    ++sent_records;
+                else
+                {
+                    ++dropped_records;
+                    dropped_bytes += size;
+                }
+                head_offset = 0;
+                queue.pop_front();
+            }
+            if(queue.empty())
+                drained.notify_all();
+        }
+        // Accounts `sent` bytes starting from current head, for stream transports
+        void consume_bytes(std::size_t sent)
+        {
+            while(sent > 0)
+            {
+                auto left = queue.front().size() - head_offset;
+                if(sent < left)
+                {
+                    head_offset += sent;
+                    return;
+                }
+                sent -= left;
+                consume(1, true);
+            }
+        }
+
+        ssize_t send(iovec* iov, std::size_t count)
+        {
+            if(!is_socket)
+                return ::writev(fd, iov, static_cast<int>(count));
+
+            msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov    = iov;
+            msg.msg_iovlen = count;
+            return ::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        }
+
+        void run()
+        {
+            // Writes into FIFO without reader raise SIGPIPE, which we don't want to kill the process
+            sigset_t sigpipe;
+            sigemptyset(&sigpipe);
+            sigaddset(&sigpipe, SIGPIPE);
+            pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+
+            std::vector<iovec> iov;
+            std::size_t batch_limit = options.max_batch;
+            Clock::time_point stop_deadline;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            while(true)
+            {
+                if(stopping && stop_deadline == Clock::time_point())
+                    stop_deadline = Clock::now() + options.reconnect_interval;
+
+                if(fd.empty())
+                {
+                    if(stopping || !connector)
+                    {
+                        if(stopping)
+                            break;
+                        wake.wait(lock, [this] { return stopping; });
+                        continue;
+                    }
+                    lock.unlock();
+                    auto next = connector();
+                    lock.lock();
+                    if(next.empty())
+                    {
+                        peer_down = true;
+                        drained.notify_all();
+                        wake.wait_for(lock, options.reconnect_interval, [this] { return stopping; });
+                        continue;
+                    }
+                    fd = std::move(next);
+                    on_connected();
+                }
+
+                if(queue.empty())
+                {
+                    if(stopping)
+                        break;
+                    wake.wait(lock, [this] { return stopping || !queue.empty(); });
+                    continue;
+                }
+                if(stopping && Clock::now() > stop_deadline)
+                    break;
+                // Deque elements aren't relocated by push_back, and only this thread pops them,
+                // so we can send directly from queued strings with mutex released
+                std::size_t count = std::min(queue.size(), is_datagram ? batch_limit : options.max_batch);
+                iov.resize(count);
+                for(std::size_t i = 0; i < count; ++i)
+                {
+                    std::string& message = queue[i];
+                    std::size_t  offset  = i == 0 ? head_offset : 0;
+                    iov[i].iov_base = &message[0] + offset;
+                    iov[i].iov_len  = message.size() - offset;
+                }
+                lock.unlock();
+                ssize_t sent = send(iov.data(), count);
+                int error = errno;
+                if(sent < 0 && (error == EAGAIN || error == EWOULDBLOCK))
+                {
+                    pollfd pfd { fd, POLLOUT, 0 };
+                    ::poll(&pfd, 1, PollTimeoutMs);
+                }
+                lock.lock();
+
+                if(sent >= 0)
+                {
+                    if(is_datagram)
+                        consume(count, true);
+                    else
+                        consume_bytes(static_cast<std::size_t>(sent));
+                    continue;
+                }
+                switch(error)
+                {
+                case EINTR: case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+                case EWOULDBLOCK:
+#endif
+                    break;
+                case EMSGSIZE:
+                    // Datagram is too big: send fewer records at once, and drop single record which doesn't fit
+                    if(batch_limit > 1)
+                        batch_limit = std::max<std::size_t>(1, count / 2);
+                    else
+                        consume(1, false);
+                    break;
+                default:
+                    if(error == EPIPE)
+                    {
+                        // Swallow SIGPIPE left pending by write into broken pipe
+                        timespec zero { 0, 0 };
+                        sigtimedwait(&sigpipe, nullptr, &zero);
+                    }
+                    on_disconnected();
+                    break;
+                }
+            }
+            // Whatever is left at this point is lost
+            if(!queue.empty())
+                consume(queue.size(), false);
+            drained.notify_all();
+        }
+
+        socket::Connector           connector;
+        socket::Options             options;
+        socket::FileDescriptor      fd;
+        bool                        is_socket   = false;
+        bool                        is_datagram = false;
+
+        mutable std::mutex          mutex;
+        std::condition_variable     wake;
+        std::condition_variable     drained;
+        std::deque<std::string>     queue;
+        std::size_t                 head_offset     = 0;
+        std::size_t                 pending_bytes   = 0;
+        bool                        stopping        = false;
+        bool                        connected       = false;
+        bool                        peer_down       = false;    ///< Last connection attempt or send failed
+        std::uint64_t               sent_records    = 0;
+        std::uint64_t               dropped_records = 0;
+        std::uint64_t               dropped_bytes   = 0;
+        std::uint64_t               reconnects      = 0;
+
+        std::thread                 worker;
+    };
+
+    SocketLogger::SocketLogger(socket::Connector connector, socket::Options const& options)
+        : _state(new State(std::move(connector), socket::FileDescriptor(), options))
+    { }
+
+    SocketLogger::SocketLogger(socket::FileDescriptor fd, socket::Options const& options)
+        : _state(new State(socket::Connector(), std::move(fd), options))
+    { }
+
+    SocketLogger::SocketLogger(SocketLogger&&)              = default;
+    SocketLogger& SocketLogger::operator=(SocketLogger&&)   = default;
+    SocketLogger::~SocketLogger()                           = default;
+
+    void SocketLogger::write(Record const&, WriterFunc writer)
+    {
+        std::ostringstream message;
+        writer(message);
+        message << '\n';
+        _state->push(message.str());
+    }
+
+    bool SocketLogger::flush(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        _state->drained.wait_for(lock, timeout, [this] { return _state->queue.empty() || _state->peer_down; });
+        return _state->queue.empty();
+    }
+
+    std::size_t SocketLogger::pending() const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        return _state->pending_bytes;
+    }
+
+    socket::Stats SocketLogger::stats() const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        return socket::Stats {
+            _state->sent_records,
+            _state->dropped_records,
+            _state->dropped_bytes,
+            _state->reconnects,
+            _state->pending_bytes,
+            _state->connected
+        };
+    }
+} // namespace log
+} // namespace toolboxcpp
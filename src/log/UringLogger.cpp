@@ -0,0 +1,551 @@
+#include <toolboxcpp/log/UringLogger.hpp>
+#include <toolboxcpp/util/Resource.hpp>
+#include <toolboxcpp/util/Slab.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace toolboxcpp
+{
+namespace log
+{
+/*
+    Minimal io_uring wrapper over raw syscalls, so there's no dependency on liburing
+    Submission queue is filled by single thread only, so its tail is kept locally
+    and published with release store
+*/
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct CloseFd
+    {
+        static int zero() noexcept { return -1; }
+        void operator()(int fd) const noexcept { ::close(fd); }
+    };
+
+    using Fd = util::Resource<int, CloseFd>;
+
+    class Ring
+    {
+    public:
+        Ring() = default;
+        Ring(Ring const&)            = delete;
+        Ring& operator=(Ring const&) = delete;
+
+        ~Ring()
+        {
+            if(_sqes)
+                ::munmap(_sqes, _sqes_size);
+            if(_cq_ptr && _cq_ptr != _sq_ptr)
+                ::munmap(_cq_ptr, _cq_size);
+            if(_sq_ptr)
+                ::munmap(_sq_ptr, _sq_size);
+        }
+        /** Sets ring up and registers file and buffers with it
+         *  Buffers and file which can't be registered are used in non-fixed mode
+         *  @return false if io_uring isn't available
+         */
+        bool open(unsigned entries, int file, iovec const* buffers, unsigned count)
+        {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            _fd = Fd(static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params)));
+            if(_fd.empty())
+                return false;
+
+            _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            _cq_size = params.cq_off.cqes  + params.cq_entries * sizeof(io_uring_cqe);
+            bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if(single)
+                _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+
+            _sq_ptr = map(_sq_size, IORING_OFF_SQ_RING);
+            _cq_ptr = single ? _sq_ptr : map(_cq_size, IORING_OFF_CQ_RING);
+            _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            _sqes   = static_cast<io_uring_sqe*>(map(_sqes_size, IORING_OFF_SQES));
+            if(!_sq_ptr || !_cq_ptr || !_sqes)
+                return false;
+
+            char* sq = static_cast<char*>(_sq_ptr);
+            char* cq = static_cast<char*>(_cq_ptr);
+            _sq_head    = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            _sq_tail    = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            _sq_mask    = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            _sq_array   = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            _cq_head    = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            _cq_tail    = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            _cq_mask    = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            _cqes       = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            _entries    = params.sq_entries;
+            _local_tail = *_sq_tail;
+
+            _fixed_file    = ::syscall(__NR_io_uring_register, static_cast<int>(_fd), IORING_REGISTER_FILES, &file, 1) == 0;
+            // Registration pins memory and may fail on low RLIMIT_MEMLOCK
+            _fixed_buffers = ::syscall(__NR_io_uring_register, static_cast<int>(_fd), IORING_REGISTER_BUFFERS, buffers, count) == 0;
+            _file = file;
+            return true;
+        }
+
+        unsigned space() const noexcept
+        {
+            return _entries - (_local_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE));
+        }
+
+        void prep_write(char* data, unsigned size, std::uint64_t offset, unsigned buffer, std::uint64_t user_data)
+        {
+            io_uring_sqe* sqe = next();
+            sqe->opcode     = _fixed_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITEV;
+            sqe->addr       = reinterpret_cast<std::uint64_t>(data);
+            sqe->len        = size;
+            sqe->off        = offset;
+            sqe->user_data  = user_data;
+            if(_fixed_buffers)
+                sqe->buf_index = static_cast<std::uint16_t>(buffer);
+            else
+            {
+                // Plain writev with single-entry vector, works on every io_uring kernel
+                _iovecs[_local_tail & _sq_mask] = iovec { data, size };
+                sqe->addr = reinterpret_cast<std::uint64_t>(&_iovecs[_local_tail & _sq_mask]);
+                sqe->len  = 1;
+            }
+            commit(sqe);
+        }
+        /** Links `fdatasync` to previously prepared operation
+         */
+        void prep_linked_fsync(std::uint64_t user_data)
+        {
+            _sqes[(_local_tail - 1) & _sq_mask].flags |= IOSQE_IO_LINK;
+            io_uring_sqe* sqe = next();
+            sqe->opcode         = IORING_OP_FSYNC;
+            sqe->fsync_flags    = IORING_FSYNC_DATASYNC;
+            sqe->user_data      = user_data;
+            commit(sqe);
+        }
+        /** Publishes prepared entries, submits them and waits for at least one completion
+         *  @return Number of entries consumed by kernel, or negative errno
+         */
+        int submit_and_wait()
+        {
+            __atomic_store_n(_sq_tail, _local_tail, __ATOMIC_RELEASE);
+            unsigned pending = _local_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+            while(true)
+            {
+                long rc = ::syscall(__NR_io_uring_enter, static_cast<int>(_fd), pending, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if(rc >= 0)
+                    return static_cast<int>(rc);
+                if(errno != EINTR)
+                    return -errno;
+            }
+        }
+        /** Passes each available completion to `fn(user_data, result)`
+         */
+        template<typename Fn>
+        void reap(Fn&& fn)
+        {
+            unsigned head = *_cq_head;
+            unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+            for(; head != tail; ++head)
+            {
+                io_uring_cqe const& cqe = _cqes[head & _cq_mask];
+                fn(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+        }
+
+        bool fixed_buffers() const noexcept { return _fixed_buffers; }
+
+    private:
+        void* map(std::size_t size, off_t offset)
+        {
+            void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+            return ptr == MAP_FAILED ? nullptr : ptr;
+        }
+
+        io_uring_sqe* next()
+        {
+            unsigned index = _local_tail & _sq_mask;
+            io_uring_sqe* sqe = &_sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->fd = _fixed_file ? 0 : _file;
+            if(_fixed_file)
+                sqe->flags |= IOSQE_FIXED_FILE;
+            _sq_array[index] = index;
+            return sqe;
+        }
+
+        void commit(io_uring_sqe*)
+        {
+            ++_local_tail;
+        }
+
+        Fd                  _fd;
+        int                 _file           = -1;
+        bool                _fixed_file     = false;
+        bool                _fixed_buffers  = false;
+
+        void*               _sq_ptr         = nullptr;
+        void*               _cq_ptr         = nullptr;
+        io_uring_sqe*       _sqes           = nullptr;
+        std::size_t         _sq_size        = 0;
+        std::size_t         _cq_size        = 0;
+        std::size_t         _sqes_size      = 0;
+
+        unsigned*           _sq_head        = nullptr;
+        unsigned*           _sq_tail        = nullptr;
+        unsigned*           _sq_array       = nullptr;
+        unsigned            _sq_mask        = 0;
+        unsigned*           _cq_head        = nullptr;
+        unsigned*           _cq_tail        = nullptr;
+        unsigned            _cq_mask        = 0;
+        io_uring_cqe*       _cqes           = nullptr;
+        unsigned            _entries        = 0;
+        unsigned            _local_tail     = 0;
+        // Vectors for non-fixed writes, one per submission slot
+        iovec               _iovecs[256];
+    };
+    // Part of buffer waiting to be written at specified file offset
+    struct Pending
+    {
+        unsigned        buffer;
+        std::size_t     start;
+        std::size_t     size;
+        std::uint64_t   offset;
+        std::uint64_t   seq;
+    };
+
+    const std::uint64_t FsyncTag = ~std::uint64_t(0);
+}
+/*
+    Writers fill current buffer and seal it when it's full; background thread turns sealed
+    buffers into writes and returns buffers to free list once writes complete.
+    Everything except ring itself is guarded by mutex
+*/
+    struct UringLogger::State
+    {
+        State(std::string const& path, uring::Options const& opts)
+            : options(opts)
+        {
+            options.buffers     = std::max<std::size_t>(1, std::min<std::size_t>(options.buffers, 64));
+            options.buffer_size = std::max<std::size_t>(4096, options.buffer_size);
+
+            int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (options.truncate ? O_TRUNC : 0);
+            // No O_APPEND: writes carry explicit offsets, so several of them can be in flight at once
+            file = Fd(::open(path.c_str(), flags, 0644));
+            if(file.empty())
+                throw std::system_error(errno, std::system_category(), path);
+            struct stat st;
+            offset = ::fstat(file, &st) == 0 ? static_cast<std::uint64_t>(st.st_size) : 0;
+
+            memory.reset(new char[options.buffers * options.buffer_size]);
+            std::vector<iovec> iovecs;
+            for(std::size_t i = 0; i < options.buffers; ++i)
+            {
+                iovecs.push_back(iovec { base(static_cast<unsigned>(i)), options.buffer_size });
+                free_buffers.push_back(static_cast<unsigned>(options.buffers - 1 - i));
+            }
+            ops.resize(options.buffers);
+
+            // Each buffer needs at most write and linked fsync
+            unsigned entries = static_cast<unsigned>(2 * options.buffers + 2);
+            use_ring = !options.force_posix && ring.open(entries, file, iovecs.data(), static_cast<unsigned>(iovecs.size()));
+
+            thread = std::thread([this] { run(); });
+        }
+
+        ~State()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            thread.join();
+            ::fdatasync(file);
+        }
+
+        char* base(unsigned buffer)
+        {
+            return memory.get() + buffer * options.buffer_size;
+        }
+
+        void append(std::unique_lock<std::mutex>& lock, char const* data, std::size_t size)
+        {
+            while(size > 0)
+            {
+                if(!has_current)
+                {
+                    if(free_buffers.empty())
+                    {
+                        ++stats.buffer_waits;
+                        space.wait(lock, [this] { return !free_buffers.empty(); });
+                    }
+                    current = free_buffers.back();
+                    free_buffers.pop_back();
+                    has_current   = true;
+                    used          = 0;
+                    current_since = Clock::now();
+                    // Background thread starts counting flush interval
+                    wake.notify_one();
+                }
+                std::size_t chunk = std::min(size, options.buffer_size - used);
+                std::memcpy(base(current) + used, data, chunk);
+                used += chunk;
+                data += chunk;
+                size -= chunk;
+                if(used == options.buffer_size)
+                    seal();
+            }
+        }
+
+        void seal()
+        {
+            if(!has_current)
+                return;
+            if(used == 0)
+            {
+                free_buffers.push_back(current);
+                has_current = false;
+                return;
+            }
+            sealed.push_back(Pending { current, 0, used, offset, next_seq });
+            outstanding.insert(next_seq++);
+            offset     += used;
+            has_current = false;
+            used        = 0;
+            wake.notify_one();
+        }
+
+        void release(Pending const& op)
+        {
+            free_buffers.push_back(op.buffer);
+            outstanding.erase(op.seq);
+            space.notify_one();
+            done.notify_all();
+        }
+
+        bool fsync_due(Clock::time_point now) const
+        {
+            return options.fsync_interval.count() > 0 && now - last_fsync >= options.fsync_interval;
+        }
+
+        void flush()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            seal();
+            std::uint64_t target = next_seq;
+            done.wait(lock, [&] { return outstanding.empty() || *outstanding.begin() >= target; });
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(true)
+            {
+                if(has_current && (stopping || Clock::now() - current_since >= options.flush_interval))
+                    seal();
+                if(sealed.empty() && inflight == 0)
+                {
+                    if(stopping && !has_current)
+                        break;
+                    if(has_current)
+                        wake.wait_until(lock, current_since + options.flush_interval);
+                    else
+                        wake.wait(lock);
+                    continue;
+                }
+                if(use_ring)
+                    pump_ring(lock);
+                else
+                    pump_posix(lock);
+            }
+        }
+
+        void pump_ring(std::unique_lock<std::mutex>& lock)
+        {
+            auto now = Clock::now();
+            while(!sealed.empty() && ring.space() >= 2)
+            {
+                Pending op = sealed.front();
+                sealed.pop_front();
+                ops[op.buffer] = op;
+                ring.prep_write(base(op.buffer) + op.start, static_cast<unsigned>(op.size), op.offset, op.buffer, op.buffer);
+                ++inflight;
+                if(fsync_due(now))
+                {
+                    ring.prep_linked_fsync(FsyncTag);
+                    last_fsync = now;
+                    ++inflight;
+                }
+            }
+
+            lock.unlock();
+            int rc = ring.submit_and_wait();
+            lock.lock();
+            if(rc < 0)
+                ++stats.errors;
+            ring.reap([this](std::uint64_t user_data, int res) { complete(user_data, res); });
+        }
+
+        void complete(std::uint64_t user_data, int res)
+        {
+            --inflight;
+            if(user_data == FsyncTag)
+            {
+                if(res >= 0)
+                    ++stats.fsyncs;
+                else if(res == -ECANCELED)
+                    last_fsync = Clock::time_point();   // Linked write was short, sync with the next one
+                else
+                    ++stats.errors;
+                return;
+            }
+
+            Pending& op = ops[user_data];
+            if(res == -EINTR || res == -EAGAIN)
+            {
+                sealed.push_front(op);
+                return;
+            }
+            if(res <= 0)
+            {
+                // Nothing sensible to do with data which can't be written
+                ++stats.errors;
+                release(op);
+                return;
+            }
+            ++stats.writes;
+            stats.written_bytes += static_cast<std::uint64_t>(res);
+            if(static_cast<std::size_t>(res) < op.size)
+            {
+                op.start  += static_cast<std::size_t>(res);
+                op.size   -= static_cast<std::size_t>(res);
+                op.offset += static_cast<std::uint64_t>(res);
+                sealed.push_front(op);
+                return;
+            }
+            release(op);
+        }
+
+        void pump_posix(std::unique_lock<std::mutex>& lock)
+        {
+            Pending op = sealed.front();
+            sealed.pop_front();
+            auto now  = Clock::now();
+            bool sync = fsync_due(now);
+            if(sync)
+                last_fsync = now;
+            ++inflight;
+
+            lock.unlock();
+            std::uint64_t written = 0, writes = 0, errors = 0;
+            while(op.size > 0)
+            {
+                ssize_t rc = ::pwrite(file, base(op.buffer) + op.start, op.size, static_cast<off_t>(op.offset));
+                if(rc < 0 && errno == EINTR)
+                    continue;
+                if(rc <= 0)
+                {
+                    ++errors;
+                    break;
+                }
+                ++writes;
+                written   += static_cast<std::uint64_t>(rc);
+                op.start  += static_cast<std::size_t>(rc);
+                op.size   -= static_cast<std::size_t>(rc);
+                op.offset += static_cast<std::uint64_t>(rc);
+            }
+            bool synced = sync && ::fdatasync(file) == 0;
+            lock.lock();
+
+            --inflight;
+            stats.written_bytes += written;
+            stats.writes        += writes;
+            stats.errors        += errors + (sync && !synced ? 1 : 0);
+            stats.fsyncs        += synced ? 1 : 0;
+            release(op);
+        }
+
+        uring::Options              options;
+        Fd                          file;
+        Ring                        ring;
+        bool                        use_ring    = false;
+        std::unique_ptr<char[]>     memory;
+
+        std::mutex                  appending;  ///< Keeps record whole while writer waits for buffer
+        std::mutex                  mutex;
+        std::condition_variable     wake;       ///< Background thread
+        std::condition_variable     space;      ///< Writers waiting for free buffer
+        std::condition_variable     done;       ///< Flushers
+
+        std::vector<unsigned>       free_buffers;
+        bool                        has_current = false;
+        unsigned                    current     = 0;
+        std::size_t                 used        = 0;
+        Clock::time_point           current_since;
+
+        std::deque<Pending>         sealed;
+        std::vector<Pending>        ops;        ///< Operation in flight, indexed by buffer
+        std::set<std::uint64_t>     outstanding;
+        std::uint64_t               next_seq    = 0;
+        std::uint64_t               offset      = 0;
+        std::size_t                 inflight    = 0;
+        Clock::time_point           last_fsync;
+        bool                        stopping    = false;
+
+        uring::Stats                stats       = uring::Stats();
+        std::thread                 thread;
+    };
+
+    UringLogger::UringLogger(std::string const& path, uring::Options const& options)
+        : _state(new State(path, options))
+    { }
+
+    UringLogger::UringLogger(UringLogger&&)               = default;
+    UringLogger& UringLogger::operator=(UringLogger&&)    = default;
+    UringLogger::~UringLogger()                           = default;
+
+    void UringLogger::write(Record const&, WriterFunc writer)
+    {
+        util::SlabStreamBuf buffer;
+        std::ostream ost(&buffer);
+        writer(ost);
+        ost.put('\n');
+
+        std::lock_guard<std::mutex>  whole(_state->appending);
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        buffer.for_each_piece([&](char const* data, std::size_t size) { _state->append(lock, data, size); });
+    }
+
+    void UringLogger::flush()
+    {
+        _state->flush();
+    }
+
+    bool UringLogger::uses_uring() const
+    {
+        return _state->use_ring;
+    }
+
+    uring::Stats UringLogger::stats() const
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        return _state->stats;
+    }
+} // namespace log
+} // namespace toolboxcpp
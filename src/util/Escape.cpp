@@ -0,0 +1,260 @@
+#include <toolboxcpp/util/Escape.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   define TOOLBOXCPP_ESCAPE_X86
+#   include <immintrin.h>
+#endif
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace escape
+{
+/*
+    Byte needs escaping in JSON mode if it's below 0x20, quote or backslash; in line mode,
+    if it's below 0x20 and isn't tab, or backslash, so escaped text can't be mistaken for escape sequence.
+    Vector kernels compare whole block against these classes, and scalar loop finishes tail shorter than single block.
+    Unsigned `byte <= 0x1F` is computed as `max(byte, 0x1F) == 0x1F`, since x86 has no unsigned byte compare
+*/
+namespace {
+    using Finder = std::size_t (*)(Mode, char const*, std::size_t);
+
+    bool is_special(Mode mode, unsigned char ch) noexcept
+    {
+        if(mode == Mode::Json)
+            return ch < 0x20 || ch == '"' || ch == '\\';
+        return (ch < 0x20 && ch != '\t') || ch == '\\';
+    }
+
+    std::size_t find_scalar(Mode mode, char const* data, std::size_t size) noexcept
+    {
+        for(std::size_t i = 0; i < size; ++i)
+            if(is_special(mode, static_cast<unsigned char>(data[i])))
+                return i;
+        return size;
+    }
+
+#ifdef TOOLBOXCPP_ESCAPE_X86
+    unsigned count_zeros(unsigned mask) noexcept
+    {
+        return static_cast<unsigned>(__builtin_ctz(mask));
+    }
+
+    std::size_t find_sse2(Mode mode, char const* data, std::size_t size) noexcept
+    {
+        const __m128i control   = _mm_set1_epi8(0x1F);
+        const __m128i quote     = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i tab       = _mm_set1_epi8('\t');
+        std::size_t i = 0;
+        for(; i + 16 <= size; i += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+            __m128i hits  = _mm_cmpeq_epi8(_mm_max_epu8(block, control), control);
+            if(mode == Mode::Json)
+                hits = _mm_or_si128(hits, _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+            else
+                hits = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(block, tab), hits), _mm_cmpeq_epi8(block, backslash));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+            if(mask)
+                return i + count_zeros(mask);
+        }
+        return i + find_scalar(mode, data + i, size - i);
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t find_avx2(Mode mode, char const* data, std::size_t size) noexcept
+    {
+        const __m256i control   = _mm256_set1_epi8(0x1F);
+        const __m256i quote     = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i tab       = _mm256_set1_epi8('\t');
+        std::size_t i = 0;
+        for(; i + 32 <= size; i += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i));
+            __m256i hits  = _mm256_cmpeq_epi8(_mm256_max_epu8(block, control), control);
+            if(mode == Mode::Json)
+                hits = _mm256_or_si256(hits, _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)));
+            else
+                hits = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(block, tab), hits), _mm256_cmpeq_epi8(block, backslash));
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+            if(mask)
+                return i + count_zeros(mask);
+        }
+        // Tail is handled here rather than by SSE2 kernel, which would pay for switching from AVX state
+        for(; i + 16 <= size; i += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+            __m128i hits  = _mm_cmpeq_epi8(_mm_max_epu8(block, _mm256_castsi256_si128(control)), _mm256_castsi256_si128(control));
+            if(mode == Mode::Json)
+                hits = _mm_or_si128(hits, _mm_or_si128(_mm_cmpeq_epi8(block, _mm256_castsi256_si128(quote)),
+                                                       _mm_cmpeq_epi8(block, _mm256_castsi256_si128(backslash))));
+            else
+                hits = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(block, _mm256_castsi256_si128(tab)), hits),
+                                    _mm_cmpeq_epi8(block, _mm256_castsi256_si128(backslash)));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+            if(mask)
+                return i + count_zeros(mask);
+        }
+        for(; i < size; ++i)
+            if(is_special(mode, static_cast<unsigned char>(data[i])))
+                return i;
+        return size;
+    }
+
+    bool supported(Kernel kernel) noexcept
+    {
+        switch(kernel)
+        {
+        case Kernel::Avx2:  return __builtin_cpu_supports("avx2");
+        case Kernel::Sse2:  return __builtin_cpu_supports("sse2");
+        default:            return true;
+        }
+    }
+#else
+    bool supported(Kernel kernel) noexcept
+    {
+        return kernel == Kernel::Scalar;
+    }
+#endif
+
+    Finder finder_of(Kernel kernel) noexcept
+    {
+        switch(kernel)
+        {
+#ifdef TOOLBOXCPP_ESCAPE_X86
+        case Kernel::Avx2:  return &find_avx2;
+        case Kernel::Sse2:  return &find_sse2;
+#endif
+        default:            return &find_scalar;
+        }
+    }
+
+    struct Selected
+    {
+        std::atomic<Kernel> kernel;
+        std::atomic<Finder> finder;
+    };
+
+    Selected& selected() noexcept
+    {
+        static Selected instance { { best_kernel() }, { finder_of(best_kernel()) } };
+        return instance;
+    }
+    // Writes escape sequence of single byte, returns its length
+    std::size_t escape_byte(Mode mode, unsigned char ch, char* out) noexcept
+    {
+        static const char Hex[] = "0123456789abcdef";
+        char simple = 0;
+        switch(ch)
+        {
+        case '\n':  simple = 'n';   break;
+        case '\r':  simple = 'r';   break;
+        case '\t':  simple = 't';   break;
+        case '\b':  simple = mode == Mode::Json ? 'b' : 0;  break;
+        case '\f':  simple = mode == Mode::Json ? 'f' : 0;  break;
+        case '"':   simple = '"';   break;
+        case '\\':  simple = '\\';  break;
+        }
+        out[0] = '\\';
+        if(simple)
+        {
+            out[1] = simple;
+            return 2;
+        }
+        if(mode == Mode::Json)
+        {
+            out[1] = 'u'; out[2] = '0'; out[3] = '0';
+            out[4] = Hex[ch >> 4]; out[5] = Hex[ch & 0xF];
+            return 6;
+        }
+        out[1] = 'x'; out[2] = Hex[ch >> 4]; out[3] = Hex[ch & 0xF];
+        return 4;
+    }
+    // Passes clean runs and escape sequences to sink `void (char const*, std::size_t)`
+    template<typename Sink>
+    void run(Mode mode, char const* data, std::size_t size, Sink&& sink)
+    {
+        Finder find = selected().finder.load(std::memory_order_relaxed);
+        char escaped[8];
+        while(size)
+        {
+            std::size_t clean = find(mode, data, size);
+            if(clean)
+                sink(data, clean);
+            if(clean == size)
+                return;
+            sink(escaped, escape_byte(mode, static_cast<unsigned char>(data[clean]), escaped));
+            data += clean + 1;
+            size -= clean + 1;
+        }
+    }
+}
+
+    Kernel kernel() noexcept
+    {
+        return selected().kernel.load(std::memory_order_relaxed);
+    }
+
+    Kernel best_kernel() noexcept
+    {
+        if(supported(Kernel::Avx2))
+            return Kernel::Avx2;
+        if(supported(Kernel::Sse2))
+            return Kernel::Sse2;
+        return Kernel::Scalar;
+    }
+
+    Kernel set_kernel(Kernel kernel) noexcept
+    {
+        if(!supported(kernel))
+            kernel = best_kernel();
+        selected().finder.store(finder_of(kernel), std::memory_order_relaxed);
+        selected().kernel.store(kernel, std::memory_order_relaxed);
+        return kernel;
+    }
+
+    char const* kernel_name(Kernel kernel) noexcept
+    {
+        switch(kernel)
+        {
+        case Kernel::Avx2:  return "avx2";
+        case Kernel::Sse2:  return "sse2";
+        default:            return "scalar";
+        }
+    }
+
+    std::size_t find_special(Mode mode, char const* data, std::size_t size) noexcept
+    {
+        return selected().finder.load(std::memory_order_relaxed)(mode, data, size);
+    }
+
+    void append(Mode mode, char const* data, std::size_t size, std::string& out)
+    {
+        run(mode, data, size, [&](char const* piece, std::size_t length) { out.append(piece, length); });
+    }
+
+    void write(Mode mode, char const* data, std::size_t size, std::ostream& ost)
+    {
+        std::streambuf* buffer = ost.rdbuf();
+        if(!buffer)
+        {
+            ost.setstate(std::ios::badbit);
+            return;
+        }
+        bool failed = false;
+        run(mode, data, size, [&](char const* piece, std::size_t length) {
+            auto count = static_cast<std::streamsize>(length);
+            failed = failed || buffer->sputn(piece, count) != count;
+        });
+        if(failed)
+            ost.setstate(std::ios::badbit);
+    }
+} // namespace escape
+} // namespace util
+} // namespace toolboxcpp
@@ -0,0 +1,379 @@
+#include <toolboxcpp/util/Executor.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+namespace toolboxcpp
+{
+namespace util
+{
+/*
+    Workers first drain their own deque from the back, then injection queue, then steal
+    from the front of other workers' deques. Idle worker sleeps on condition variable
+    till new task, or till the nearest timer deadline.
+
+    Lost wake-ups are prevented by pair of counters: submitter bumps `queued` and then checks
+    `sleepers`, while worker bumps `sleepers` under mutex and then checks `queued`,
+    so at least one of them sees the other
+*/
+namespace {
+    using Clock = executor::Clock;
+
+    struct Worker
+    {
+        std::mutex          mutex;
+        std::deque<Task>    tasks;
+        std::thread         thread;
+    };
+
+    struct Timer
+    {
+        Task                task;
+        Clock::duration     period;     ///< Zero for one-shot timers
+        bool                running;
+        bool                cancelled;
+        std::thread::id     runner;
+    };
+
+    using Deadline = std::pair<Clock::time_point, executor::TimerId>;
+
+    void run_task(Task& task)
+    {
+        try
+        {
+            task();
+        }
+        catch(...)
+        {
+            // Nobody to report to; task should handle its errors itself
+        }
+    }
+
+    void pin_to_cpu(int cpu)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#else
+        (void)cpu;
+#endif
+    }
+}
+
+    struct Executor::State
+    {
+        explicit State(executor::Options const& options)
+        {
+            std::size_t count = std::max<std::size_t>(1, options.threads);
+            for(std::size_t i = 0; i < count; ++i)
+                workers.emplace_back(new Worker());
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                int cpu = options.affinity.empty() ? -1 : options.affinity[i % options.affinity.size()];
+                workers[i]->thread = std::thread([this, i, cpu] { run(i, cpu); });
+            }
+        }
+
+        ~State()
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                for(auto& entry: timers)
+                    entry.second.cancelled = true;
+                timer_done.wait(lock, [this] { return running_timers == 0; });
+                timers.clear();
+                deadlines = std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>>();
+                next_deadline.store(Clock::time_point::max().time_since_epoch().count());
+                stopping = true;
+            }
+            wake.notify_all();
+            for(auto& worker: workers)
+                worker->thread.join();
+        }
+
+        void submit(Task task)
+        {
+            queued.fetch_add(1);
+            Worker* own = current_worker();
+            if(own)
+            {
+                std::lock_guard<std::mutex> lock(own->mutex);
+                own->tasks.push_back(std::move(task));
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                injected.push_back(std::move(task));
+            }
+            if(sleepers.load() > 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                wake.notify_one();
+            }
+        }
+
+        executor::TimerId schedule(Clock::duration delay, Clock::duration period, Task task)
+        {
+            executor::TimerId id;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                id = next_timer++;
+                timers.insert(std::make_pair(id, Timer { std::move(task), period, false, false, std::thread::id() }));
+                push_deadline(Clock::now() + delay, id);
+            }
+            // Any sleeping worker re-evaluates its wait deadline
+            wake.notify_one();
+            return id;
+        }
+
+        void cancel(executor::TimerId id)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto it = timers.find(id);
+            if(it == timers.end())
+                return;
+            if(!it->second.running)
+            {
+                timers.erase(it);
+                return;
+            }
+            it->second.cancelled = true;
+            if(it->second.runner == std::this_thread::get_id())
+                return;
+            timer_done.wait(lock, [&] { return timers.find(id) == timers.end(); });
+        }
+
+        Worker* current_worker()
+        {
+            return t_owner == this ? workers[t_index].get() : nullptr;
+        }
+
+        void run(std::size_t index, int cpu)
+        {
+            t_owner = this;
+            t_index = index;
+            if(cpu >= 0)
+                pin_to_cpu(cpu);
+
+            std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+            while(true)
+            {
+                if(next_deadline.load(std::memory_order_relaxed) <= Clock::now().time_since_epoch().count())
+                {
+                    lock.lock();
+                    run_due_timer(lock);
+                    lock.unlock();
+                }
+
+                Task task;
+                if(take(index, task))
+                {
+                    run_task(task);
+                    continue;
+                }
+
+                lock.lock();
+                if(run_due_timer(lock))
+                {
+                    lock.unlock();
+                    continue;
+                }
+                if(stopping && queued.load() == 0)
+                    break;
+                sleepers.fetch_add(1);
+                if(queued.load() == 0)
+                {
+                    if(deadlines.empty())
+                        wake.wait(lock);
+                    else
+                        wake.wait_until(lock, deadlines.top().first);
+                }
+                sleepers.fetch_sub(1);
+                lock.unlock();
+            }
+        }
+        // Takes task from own deque, injection queue, or steals one from other worker
+        bool take(std::size_t index, Task& task)
+        {
+            if(queued.load(std::memory_order_relaxed) == 0)
+                return false;
+            {
+                Worker& own = *workers[index];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if(!own.tasks.empty())
+                {
+                    task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    queued.fetch_sub(1);
+                    return true;
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!injected.empty())
+                {
+                    task = std::move(injected.front());
+                    injected.pop_front();
+                    queued.fetch_sub(1);
+                    return true;
+                }
+            }
+            for(std::size_t i = 1; i < workers.size(); ++i)
+            {
+                Worker& victim = *workers[(index + i) % workers.size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if(!victim.tasks.empty())
+                {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    queued.fetch_sub(1);
+                    return true;
+                }
+            }
+            return false;
+        }
+        // Runs single due timer with mutex released; returns false if there was none
+        bool run_due_timer(std::unique_lock<std::mutex>& lock)
+        {
+            auto now = Clock::now();
+            while(!deadlines.empty() && deadlines.top().first <= now)
+            {
+                executor::TimerId id = deadlines.top().second;
+                deadlines.pop();
+                update_next_deadline();
+
+                auto it = timers.find(id);
+                if(it == timers.end() || it->second.cancelled || it->second.running)
+                    continue;
+
+                Timer& timer = it->second;
+                timer.running = true;
+                timer.runner  = std::this_thread::get_id();
+                ++running_timers;
+                lock.unlock();
+                run_task(timer.task);
+                lock.lock();
+                --running_timers;
+                // Timer entry can't be erased while it's running, so reference is still valid
+                timer.running = false;
+                timer.runner  = std::thread::id();
+                if(timer.cancelled || timer.period == Clock::duration::zero())
+                    timers.erase(id);
+                else
+                {
+                    // Skip missed periods instead of running timer several times in a row
+                    auto next = now + timer.period;
+                    push_deadline(std::max(next, Clock::now()), id);
+                }
+                timer_done.notify_all();
+                return true;
+            }
+            return false;
+        }
+
+        void push_deadline(Clock::time_point when, executor::TimerId id)
+        {
+            deadlines.push(Deadline(when, id));
+            update_next_deadline();
+        }
+
+        void update_next_deadline()
+        {
+            auto next = deadlines.empty() ? Clock::time_point::max() : deadlines.top().first;
+            next_deadline.store(next.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        std::vector<std::unique_ptr<Worker>>    workers;
+
+        std::mutex                              mutex;
+        std::condition_variable                 wake;
+        std::condition_variable                 timer_done;
+        std::deque<Task>                        injected;
+        std::map<executor::TimerId, Timer>      timers;
+        std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines;
+        executor::TimerId                       next_timer      = 1;
+        std::size_t                             running_timers  = 0;
+        bool                                    stopping        = false;
+
+        std::atomic<std::size_t>                queued          { 0 };
+        std::atomic<std::size_t>                sleepers        { 0 };
+        std::atomic<Clock::rep>                 next_deadline   { Clock::time_point::max().time_since_epoch().count() };
+
+        static thread_local State*              t_owner;
+        static thread_local std::size_t         t_index;
+    };
+
+    thread_local Executor::State*   Executor::State::t_owner = nullptr;
+    thread_local std::size_t        Executor::State::t_index = 0;
+
+    Executor::Executor(executor::Options const& options)
+        : _state(new State(options))
+    { }
+
+    Executor::~Executor() = default;
+
+    void Executor::submit(Task task)
+    {
+        _state->submit(std::move(task));
+    }
+
+    executor::TimerId Executor::schedule_after(executor::Clock::duration delay, Task task)
+    {
+        return _state->schedule(delay, executor::Clock::duration::zero(), std::move(task));
+    }
+
+    executor::TimerId Executor::schedule_every(executor::Clock::duration period, Task task)
+    {
+        return _state->schedule(period, std::max(period, executor::Clock::duration(1)), std::move(task));
+    }
+
+    void Executor::cancel(executor::TimerId timer)
+    {
+        _state->cancel(timer);
+    }
+
+    std::size_t Executor::threads() const noexcept
+    {
+        return _state->workers.size();
+    }
+/*
+    Shared executor is never destroyed, so components can use it even during static destruction
+*/
+namespace {
+    std::mutex          g_shared_mutex;
+    Executor*           g_shared = nullptr;
+    executor::Options   g_shared_options;
+}
+
+    Executor& Executor::shared()
+    {
+        std::lock_guard<std::mutex> lock(g_shared_mutex);
+        if(!g_shared)
+            g_shared = new Executor(g_shared_options);
+        return *g_shared;
+    }
+
+    void Executor::configure_shared(executor::Options const& options)
+    {
+        std::lock_guard<std::mutex> lock(g_shared_mutex);
+        if(g_shared)
+            throw std::logic_error("Shared executor already started");
+        g_shared_options = options;
+    }
+} // namespace util
+} // namespace toolboxcpp
@@ -0,0 +1,92 @@
+#include <toolboxcpp/util/Histogram.hpp>
+
+#include <cmath>
+
+namespace toolboxcpp
+{
+namespace util
+{
+    constexpr unsigned      Histogram::SubBits;
+    constexpr std::size_t   Histogram::Buckets;
+/*
+    Value with highest bit E >= SubBits goes to range (E - SubBits), bucket inside range
+    is given by the next SubBits - 1 bits below the highest one
+*/
+namespace {
+    const std::size_t   Exact   = std::size_t(1) << Histogram::SubBits;
+    const std::size_t   Half    = Exact / 2;
+
+    unsigned highest_bit(std::uint64_t value) noexcept
+    {
+        return 63 - static_cast<unsigned>(__builtin_clzll(value));
+    }
+}
+
+    std::size_t Histogram::bucket_of(std::uint64_t value) noexcept
+    {
+        if(value < Exact)
+            return static_cast<std::size_t>(value);
+        unsigned top   = highest_bit(value);
+        unsigned shift = top - (SubBits - 1);
+        return Exact + (top - SubBits) * Half + static_cast<std::size_t>(value >> shift) - Half;
+    }
+
+    std::uint64_t Histogram::bucket_low(std::size_t bucket) noexcept
+    {
+        if(bucket < Exact)
+            return bucket;
+        std::size_t range = (bucket - Exact) / Half;
+        std::uint64_t mantissa = Half + (bucket - Exact) % Half;
+        return mantissa << (range + 1);
+    }
+
+    std::uint64_t Histogram::bucket_high(std::size_t bucket) noexcept
+    {
+        if(bucket < Exact)
+            return bucket;
+        std::size_t range = (bucket - Exact) / Half;
+        return bucket_low(bucket) + ((std::uint64_t(1) << (range + 1)) - 1);
+    }
+
+    void Histogram::merge(Histogram const& other) noexcept
+    {
+        for(std::size_t i = 0; i < Buckets; ++i)
+            _counts[i] += other._counts[i];
+        _total  += other._total;
+        _sum    += other._sum;
+    }
+
+    std::uint64_t Histogram::min() const noexcept
+    {
+        for(std::size_t i = 0; i < Buckets; ++i)
+            if(_counts[i])
+                return bucket_low(i);
+        return 0;
+    }
+
+    std::uint64_t Histogram::max() const noexcept
+    {
+        for(std::size_t i = Buckets; i > 0; --i)
+            if(_counts[i - 1])
+                return bucket_high(i - 1);
+        return 0;
+    }
+
+    std::uint64_t Histogram::percentile(double quantile) const noexcept
+    {
+        if(_total == 0)
+            return 0;
+        quantile = quantile < 0 ? 0 : quantile > 1 ? 1 : quantile;
+        auto rank = static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(_total)));
+        rank = rank ? rank : 1;
+        std::uint64_t seen = 0;
+        for(std::size_t i = 0; i < Buckets; ++i)
+        {
+            seen += _counts[i];
+            if(seen >= rank)
+                return bucket_low(i) + (bucket_high(i) - bucket_low(i)) / 2;
+        }
+        return max();
+    }
+} // namespace util
+} // namespace toolboxcpp
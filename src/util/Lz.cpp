@@ -0,0 +1,142 @@
+#include <toolboxcpp/util/Lz.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace lz
+{
+/*
+    Token: high nibble is literal count, low nibble is match length minus MinMatch.
+    Nibble value 15 means that length continues in following bytes, each adding up to 255;
+    byte less than 255 terminates the length
+*/
+namespace {
+    const std::size_t   MinMatch    = 4;
+    const std::size_t   MaxOffset   = 0xFFFF;
+    const unsigned      HashBits    = 14;
+
+    std::uint32_t read32(char const* ptr) noexcept
+    {
+        std::uint32_t value;
+        std::memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+
+    std::uint32_t hash(std::uint32_t sequence) noexcept
+    {
+        return (sequence * 2654435761u) >> (32 - HashBits);
+    }
+
+    void put_length(std::string& out, std::size_t length)
+    {
+        for(; length >= 255; length -= 255)
+            out.push_back(static_cast<char>(255));
+        out.push_back(static_cast<char>(length));
+    }
+
+    void put_sequence(std::string& out, char const* literals, std::size_t literal_count, std::size_t offset, std::size_t match)
+    {
+        std::size_t match_code = match ? match - MinMatch : 0;
+        out.push_back(static_cast<char>(
+            (literal_count < 15 ? literal_count : 15) << 4 | (match_code < 15 ? match_code : 15)));
+        if(literal_count >= 15)
+            put_length(out, literal_count - 15);
+        out.append(literals, literal_count);
+        if(!match)
+            return;
+        out.push_back(static_cast<char>(offset & 0xFF));
+        out.push_back(static_cast<char>(offset >> 8));
+        if(match_code >= 15)
+            put_length(out, match_code - 15);
+    }
+
+    bool get_length(unsigned char const*& ip, unsigned char const* end, std::size_t& length) noexcept
+    {
+        unsigned char byte;
+        do
+        {
+            if(ip == end)
+                return false;
+            byte = *ip++;
+            length += byte;
+        }
+        while(byte == 255);
+        return true;
+    }
+}
+
+    std::size_t max_compressed_size(std::size_t size) noexcept
+    {
+        // One token plus extension bytes for literal run covering whole input
+        return size + size / 255 + 16;
+    }
+
+    void compress(char const* data, std::size_t size, std::string& out)
+    {
+        out.reserve(out.size() + max_compressed_size(size));
+        std::unique_ptr<std::uint32_t[]> table(new std::uint32_t[1u << HashBits]());
+        std::size_t anchor = 0, pos = 0;
+        while(pos + MinMatch <= size)
+        {
+            std::uint32_t sequence  = read32(data + pos);
+            std::uint32_t& slot     = table[hash(sequence)];
+            std::size_t candidate   = slot;
+            slot = static_cast<std::uint32_t>(pos);
+            if(candidate >= pos || pos - candidate > MaxOffset || read32(data + candidate) != sequence)
+            {
+                ++pos;
+                continue;
+            }
+            std::size_t match = MinMatch;
+            while(pos + match < size && data[candidate + match] == data[pos + match])
+                ++match;
+            put_sequence(out, data + anchor, pos - anchor, pos - candidate, match);
+            pos   += match;
+            anchor = pos;
+        }
+        put_sequence(out, data + anchor, size - anchor, 0, 0);
+    }
+
+    bool decompress(char const* data, std::size_t size, char* out, std::size_t out_size) noexcept
+    {
+        auto ip  = reinterpret_cast<unsigned char const*>(data);
+        auto end = ip + size;
+        std::size_t op = 0;
+        while(ip < end)
+        {
+            unsigned token = *ip++;
+            std::size_t literals = token >> 4;
+            if(literals == 15 && !get_length(ip, end, literals))
+                return false;
+            if(literals > static_cast<std::size_t>(end - ip) || literals > out_size - op)
+                return false;
+            std::memcpy(out + op, ip, literals);
+            ip += literals;
+            op += literals;
+            if(ip == end)
+                break;  // Last token has no match
+
+            if(end - ip < 2)
+                return false;
+            std::size_t offset = ip[0] | static_cast<std::size_t>(ip[1]) << 8;
+            ip += 2;
+            std::size_t match = token & 15;
+            if(match == 15 && !get_length(ip, end, match))
+                return false;
+            match += MinMatch;
+            if(offset == 0 || offset > op || match > out_size - op)
+                return false;
+            // Byte by byte, since match may overlap its own output
+            for(std::size_t i = 0; i < match; ++i, ++op)
+                out[op] = out[op - offset];
+        }
+        return op == out_size;
+    }
+} // namespace lz
+} // namespace util
+} // namespace toolboxcpp
@@ -0,0 +1,215 @@
+#include <toolboxcpp/util/MappedFile.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace toolboxcpp
+{
+namespace util
+{
+/*
+    Mappings start at page boundary, so window offset is split into page-aligned base
+    and number of bytes skipped from it. Huge-page alignment is done by reserving larger
+    inaccessible area, mapping file over its aligned part and releasing the rest
+*/
+namespace {
+    int advice_of(mapped::Advice advice) noexcept
+    {
+        switch(advice)
+        {
+        case mapped::Advice::Sequential:    return MADV_SEQUENTIAL;
+        case mapped::Advice::Random:        return MADV_RANDOM;
+        case mapped::Advice::WillNeed:      return MADV_WILLNEED;
+        default:                            return MADV_NORMAL;
+        }
+    }
+
+    void* map_aligned(std::size_t size, int prot, int flags, int fd, off_t offset)
+    {
+        std::size_t reserved = size + mapped::HugePageSize;
+        void* area = ::mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(area == MAP_FAILED)
+            return MAP_FAILED;
+        auto begin   = reinterpret_cast<std::uintptr_t>(area);
+        auto aligned = (begin + mapped::HugePageSize - 1) & ~std::uintptr_t(mapped::HugePageSize - 1);
+        void* address = ::mmap(reinterpret_cast<void*>(aligned), size, prot, flags | MAP_FIXED, fd, offset);
+        if(address == MAP_FAILED)
+        {
+            int error = errno;
+            ::munmap(area, reserved);
+            errno = error;
+            return MAP_FAILED;
+        }
+        // Release reserved space around mapping; tail starts at page boundary past mapping end
+        std::size_t page = mapped::page_size();
+        std::uintptr_t tail = aligned + (size + page - 1) / page * page;
+        if(aligned > begin)
+            ::munmap(area, aligned - begin);
+        if(begin + reserved > tail)
+            ::munmap(reinterpret_cast<void*>(tail), begin + reserved - tail);
+#ifdef MADV_HUGEPAGE
+        ::madvise(address, size, MADV_HUGEPAGE);
+#endif
+        return address;
+    }
+}
+
+namespace mapped
+{
+    void Unmap::operator()(Span span) const noexcept
+    {
+        ::munmap(span.address, span.size);
+    }
+
+    void Unmap::operator()(Span* begin, Span* end) const noexcept
+    {
+        std::sort(begin, end, [](Span const& left, Span const& right) {
+            return std::less<void*>()(left.address, right.address);
+        });
+        while(begin != end)
+        {
+            // Mappings are whole pages, so adjacent ones meet exactly at rounded-up end
+            std::size_t page = page_size();
+            auto start = reinterpret_cast<std::uintptr_t>(begin->address);
+            auto stop  = start + (begin->size + page - 1) / page * page;
+            for(++begin; begin != end && reinterpret_cast<std::uintptr_t>(begin->address) == stop; ++begin)
+                stop += (begin->size + page - 1) / page * page;
+            ::munmap(reinterpret_cast<void*>(start), stop - start);
+        }
+    }
+
+    std::size_t page_size() noexcept
+    {
+        static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+} // namespace mapped
+
+    void MappedRegion::advise(mapped::Advice advice, std::size_t from, std::size_t length) const noexcept
+    {
+        if(from >= _size)
+            return;
+        length = std::min(length, _size - from);
+        // Range passed to kernel should start at page boundary
+        std::size_t page = mapped::page_size();
+        auto begin = reinterpret_cast<std::uintptr_t>(_data + from);
+        auto start = begin & ~std::uintptr_t(page - 1);
+        ::madvise(reinterpret_cast<void*>(start), length + (begin - start), advice_of(advice));
+    }
+
+    void MappedRegion::sync() const
+    {
+        if(_mapping.empty())
+            return;
+        auto span = _mapping.get();
+        if(::msync(span.address, static_cast<std::size_t>(_data - static_cast<char const*>(span.address)) + _size, MS_SYNC) != 0)
+            throw std::system_error(errno, std::system_category(), "Failed to sync mapped region");
+    }
+
+    void MappedFile::CloseFd::operator()(int fd) const noexcept
+    {
+        ::close(fd);
+    }
+
+    MappedFile::MappedFile(std::string const& path, mapped::Access access)
+        : _size(0)
+        , _access(access)
+    {
+        int flags = access == mapped::Access::ReadWrite ? O_RDWR | O_CREAT : O_RDONLY;
+        _fd.reset(::open(path.c_str(), flags | O_CLOEXEC, 0644));
+        if(_fd.empty())
+            throw std::system_error(errno, std::system_category(), path);
+        struct stat st;
+        if(::fstat(_fd, &st) != 0)
+            throw std::system_error(errno, std::system_category(), path);
+        _size = static_cast<std::uint64_t>(st.st_size);
+    }
+
+    void MappedFile::resize(std::uint64_t size)
+    {
+        if(::ftruncate(_fd, static_cast<off_t>(size)) != 0)
+            throw std::system_error(errno, std::system_category(), "Failed to resize mapped file");
+        _size = size;
+    }
+
+    MappedRegion MappedFile::map(std::uint64_t offset, std::size_t size, mapped::Options const& options) const
+    {
+        if(offset > _size)
+            throw std::out_of_range("Mapped window starts past file end");
+        size = static_cast<std::size_t>(std::min<std::uint64_t>(size, _size - offset));
+        if(size == 0)
+            return MappedRegion();
+
+        std::uint64_t base = offset / mapped::page_size() * mapped::page_size();
+        std::size_t skip   = static_cast<std::size_t>(offset - base);
+        std::size_t length = skip + size;
+        bool writable      = _access == mapped::Access::ReadWrite;
+        int prot  = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        if(options.populate)
+            flags |= MAP_POPULATE;
+#endif
+        void* address = options.huge_pages
+            ? map_aligned(length, prot, flags, _fd, static_cast<off_t>(base))
+            : ::mmap(nullptr, length, prot, flags, _fd, static_cast<off_t>(base));
+        if(address == MAP_FAILED)
+            throw std::system_error(errno, std::system_category(), "Failed to map file");
+
+        MappedRegion region(mapped::Mapping(mapped::Span { address, length }), skip, size, offset, writable);
+        if(options.advice != mapped::Advice::Normal)
+            region.advise(options.advice);
+        return region;
+    }
+
+    MappedRegion MappedFile::map(mapped::Options const& options) const
+    {
+        if(_size > std::uint64_t(std::size_t(-1)))
+            throw std::length_error("File is too large to be mapped whole");
+        return map(0, static_cast<std::size_t>(_size), options);
+    }
+
+    void MappedFile::readahead(std::uint64_t offset, std::uint64_t size) const noexcept
+    {
+#ifdef POSIX_FADV_WILLNEED
+        if(offset < _size)
+            ::posix_fadvise(_fd, static_cast<off_t>(offset), static_cast<off_t>(std::min(size, _size - offset)), POSIX_FADV_WILLNEED);
+#else
+        (void)offset;
+        (void)size;
+#endif
+    }
+
+    MappedChunks MappedFile::chunks(std::size_t window, mapped::Options const& options) const
+    {
+        std::size_t page = mapped::page_size();
+        return MappedChunks(*this, std::max(page, (window + page - 1) / page * page), options);
+    }
+
+    MappedChunks::Iterator MappedChunks::begin()
+    {
+        return advance() ? Iterator(this) : Iterator();
+    }
+
+    bool MappedChunks::advance()
+    {
+        // Previous window is released before next one is mapped, so range holds only one window;
+        // reaper thread unmaps released ones later, so a few of them may still be mapped meanwhile
+        _current = MappedRegion();
+        if(_next >= _file->size())
+            return false;
+        _current = _file->map(_next, _window, _options);
+        _next += _current.size();
+        _file->readahead(_next, _window);
+        return true;
+    }
+} // namespace util
+} // namespace toolboxcpp
@@ -0,0 +1,130 @@
+#include <toolboxcpp/util/Reaper.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace reaper
+{
+/*
+    Single background thread which flushes all registered bins
+    Flushes are serialized, so `drain` returning means every handle queued before it is released
+    Reaper is never destroyed, so handles can be dropped even during static destruction
+*/
+namespace {
+    class Reaper
+    {
+    public:
+        Reaper()
+            : _thread([this] { run(); })
+        { }
+
+        void attach(Bin* bin)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _bins.push_back(bin);
+        }
+
+        void notify()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _pending = true;
+            }
+            _wake.notify_one();
+        }
+
+        void flush_all()
+        {
+            std::lock_guard<std::mutex> flush_lock(_flush_mutex);
+            std::vector<Bin*> bins;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                bins = _bins;
+            }
+            for(auto bin: bins)
+                bin->flush();
+        }
+
+    private:
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while(true)
+            {
+                _wake.wait(lock, [this] { return _pending; });
+                _pending = false;
+                lock.unlock();
+                flush_all();
+                lock.lock();
+            }
+        }
+
+        std::mutex              _mutex;
+        std::mutex              _flush_mutex;
+        std::condition_variable _wake;
+        std::vector<Bin*>       _bins;
+        bool                    _pending    = false;
+        std::thread             _thread;
+    };
+
+    Reaper& instance()
+    {
+        static Reaper* reaper = new Reaper();
+        return *reaper;
+    }
+
+    void close_run(int first, int last) noexcept
+    {
+#ifdef SYS_close_range
+        if(first != last && ::syscall(SYS_close_range, static_cast<unsigned>(first), static_cast<unsigned>(last), 0u) == 0)
+            return;
+#endif
+        for(int fd = first; fd <= last; ++fd)
+            ::close(fd);
+    }
+}
+
+    void attach(Bin* bin)
+    {
+        instance().attach(bin);
+    }
+
+    void notify()
+    {
+        instance().notify();
+    }
+
+    void drain()
+    {
+        instance().flush_all();
+    }
+
+    void CloseFds::operator()(int fd) const noexcept
+    {
+        ::close(fd);
+    }
+
+    void CloseFds::operator()(int* begin, int* end) const noexcept
+    {
+        std::sort(begin, end);
+        while(begin != end)
+        {
+            // Find contiguous run of descriptors, skipping duplicates
+            int* last = begin;
+            while(last + 1 != end && *(last + 1) - *last <= 1)
+                ++last;
+            close_run(*begin, *last);
+            begin = last + 1;
+        }
+    }
+} // namespace reaper
+} // namespace util
+} // namespace toolboxcpp
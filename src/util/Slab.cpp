@@ -0,0 +1,219 @@
+#include <toolboxcpp/util/Slab.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace toolboxcpp
+{
+namespace util
+{
+namespace slab
+{
+    struct Heap
+    {
+        Block*                  local       = nullptr;  ///< Touched by owner thread only
+        std::atomic<Block*>     remote      { nullptr };
+        char*                   carve       = nullptr;  ///< Unused tail of the last chunk
+        char*                   carve_end   = nullptr;
+        std::size_t             chunks      = 0;
+    };
+/*
+    Heaps are never destroyed: blocks of exited thread may still be in flight,
+    so its heap is parked in orphan list and adopted by the next new thread
+*/
+namespace {
+    struct Orphans
+    {
+        std::mutex          mutex;
+        std::vector<Heap*>  heaps;
+    };
+
+    Orphans& orphans()
+    {
+        static Orphans* instance = new Orphans();
+        return *instance;
+    }
+
+    struct ThreadHeap
+    {
+        Heap* heap = nullptr;
+
+        ~ThreadHeap()
+        {
+            if(!heap)
+                return;
+            auto& list = orphans();
+            std::lock_guard<std::mutex> lock(list.mutex);
+            list.heaps.push_back(heap);
+            heap = nullptr;
+        }
+    };
+
+    thread_local ThreadHeap t_heap;
+
+    Heap& current_heap()
+    {
+        if(!t_heap.heap)
+        {
+            auto& list = orphans();
+            std::lock_guard<std::mutex> lock(list.mutex);
+            if(!list.heaps.empty())
+            {
+                t_heap.heap = list.heaps.back();
+                list.heaps.pop_back();
+            }
+            else
+                t_heap.heap = new Heap();
+        }
+        return *t_heap.heap;
+    }
+
+    Block* carve(Heap& heap) noexcept
+    {
+        if(heap.carve == heap.carve_end)
+        {
+            if(heap.chunks == MaxChunks)
+                return nullptr;
+            char* chunk = new (std::nothrow) char[BlockSize * ChunkBlocks];
+            if(!chunk)
+                return nullptr;
+            ++heap.chunks;
+            heap.carve     = chunk;
+            heap.carve_end = chunk + BlockSize * ChunkBlocks;
+        }
+        Block* block = reinterpret_cast<Block*>(heap.carve);
+        heap.carve += BlockSize;
+        return block;
+    }
+
+    void push_remote(Heap& heap, Block* block) noexcept
+    {
+        Block* head = heap.remote.load(std::memory_order_relaxed);
+        do
+            block->next = head;
+        while(!heap.remote.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+}
+
+    Block* allocate() noexcept
+    {
+        Heap& heap = current_heap();
+        Block* block = heap.local;
+        if(!block)
+            block = heap.remote.exchange(nullptr, std::memory_order_acquire);
+        if(!block)
+        {
+            block = carve(heap);
+            if(!block)
+                return nullptr;
+            block->next = nullptr;
+        }
+        heap.local   = block->next;
+        block->next  = nullptr;
+        block->owner = &heap;
+        block->size  = 0;
+        return block;
+    }
+
+    void free(Block* chain) noexcept
+    {
+        Heap* own = t_heap.heap;
+        while(chain)
+        {
+            Block* next = chain->next;
+            if(chain->owner == own)
+            {
+                chain->next = own->local;
+                own->local  = chain;
+            }
+            else
+                push_remote(*chain->owner, chain);
+            chain = next;
+        }
+    }
+
+    std::size_t reserved() noexcept
+    {
+        return t_heap.heap ? t_heap.heap->chunks * ChunkBlocks * BlockSize : 0;
+    }
+} // namespace slab
+
+    void SlabStreamBuf::write_to(std::ostream& ost)
+    {
+        for_each_piece([&](char const* data, std::size_t size) { ost.write(data, static_cast<std::streamsize>(size)); });
+    }
+
+    std::size_t SlabStreamBuf::size() const noexcept
+    {
+        std::size_t total = _spill.size();
+        for(auto block = _head; block; block = block->next)
+            total += block == _tail && pbase() == block->data() ? static_cast<std::size_t>(pptr() - pbase()) : block->size;
+        return total;
+    }
+
+    SlabStreamBuf::int_type SlabStreamBuf::overflow(int_type ch)
+    {
+        if(traits_type::eq_int_type(ch, traits_type::eof()))
+            return traits_type::not_eof(ch);
+        if(_spilling || !grow())
+        {
+            _spill.push_back(traits_type::to_char_type(ch));
+            return ch;
+        }
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+        return ch;
+    }
+
+    std::streamsize SlabStreamBuf::xsputn(char const* str, std::streamsize count)
+    {
+        std::streamsize written = 0;
+        while(written < count)
+        {
+            if(_spilling)
+            {
+                _spill.append(str + written, static_cast<std::size_t>(count - written));
+                return count;
+            }
+            if(pptr() == epptr() && !grow())
+                continue;   // Next iteration spills the rest
+            auto chunk = std::min<std::streamsize>(count - written, epptr() - pptr());
+            std::memcpy(pptr(), str + written, static_cast<std::size_t>(chunk));
+            // pbump accepts int, chunk is at most block capacity
+            pbump(static_cast<int>(chunk));
+            written += chunk;
+        }
+        return count;
+    }
+
+    bool SlabStreamBuf::grow()
+    {
+        sync_tail();
+        slab::Block* block = slab::allocate();
+        if(!block)
+        {
+            // Once spilled, the rest goes to string too, to keep text in order
+            _spilling = true;
+            setp(nullptr, nullptr);
+            return false;
+        }
+        if(_tail)
+            _tail->next = block;
+        else
+            _head = block;
+        _tail = block;
+        setp(block->data(), block->data() + slab::BlockCapacity);
+        return true;
+    }
+
+    void SlabStreamBuf::sync_tail() noexcept
+    {
+        if(_tail && pbase() == _tail->data())
+            _tail->size = static_cast<std::uint32_t>(pptr() - pbase());
+    }
+} // namespace util
+} // namespace toolboxcpp
@@ -0,0 +1,141 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+#include <toolboxcpp/log/Archive.hpp>
+
+#include "TestUtil.hpp"
+
+#include <fstream>
+#include <string>
+
+using namespace toolboxcpp::log;
+
+namespace
+{
+    const Channel channels[] = { "net", "disk", "" };
+
+    Timestamp at(int second)
+    {
+        return Timestamp(std::chrono::seconds(1600000000 + second));
+    }
+    // Record i has timestamp i seconds, severity cycling from Error to Trace and channel cycling through channels
+    void write_records(ArchiveLogger& logger, int from, int to)
+    {
+        for(int i = from; i < to; ++i)
+        {
+            Record record {};
+            record.timestamp = at(i);
+            record.severity  = static_cast<Severity>(1 + i % 5);
+            record.channel   = channels[i % 3];
+            logger.write(record, [&](std::ostream& ost) { ost << "message " << i; });
+        }
+    }
+}
+
+TEST_CASE("Archive keeps records and block indexes")
+{
+    test::TempFile file("archive");
+    archive::Options options;
+    options.block_size = 4096;
+    {
+        ArchiveLogger logger(file.path, options);
+        write_records(logger, 0, 3000);
+        logger.flush();
+        auto stats = logger.stats();
+        CHECK(stats.records == 3000);
+        CHECK(stats.blocks > 1);
+        CHECK(stats.compressed_bytes < stats.raw_bytes);
+        CHECK(stats.errors == 0);
+    }
+
+    ArchiveReader reader(file.path);
+    auto& blocks = reader.blocks();
+    REQUIRE(blocks.size() > 1);
+    CHECK(blocks.front().min_timestamp == at(0));
+    CHECK(blocks.back().max_timestamp == at(2999));
+    CHECK(blocks.front().channels.size() == 3);
+
+    auto all = reader.query(archive::Query());
+    REQUIRE(all.size() == 3000);
+    for(int i = 0; i < 3000; ++i)
+    {
+        CHECK(all[i].timestamp == at(i));
+        CHECK(all[i].severity == static_cast<Severity>(1 + i % 5));
+        CHECK(all[i].channel == channels[i % 3]);
+        CHECK(all[i].message == "message " + std::to_string(i));
+    }
+}
+
+TEST_CASE("Archive query selects records")
+{
+    test::TempFile file("archive");
+    archive::Options options;
+    options.block_size = 2048;
+    {
+        ArchiveLogger logger(file.path, options);
+        write_records(logger, 0, 3000);
+    }
+    ArchiveReader reader(file.path);
+
+    SECTION("by time range")
+    {
+        archive::Query query;
+        query.from = at(1000);
+        query.to   = at(1099);
+        auto entries = reader.query(query, 4);
+        REQUIRE(entries.size() == 100);
+        CHECK(entries.front().message == "message 1000");
+        CHECK(entries.back().message == "message 1099");
+    }
+    SECTION("by severity and channel")
+    {
+        archive::Query query;
+        query.severities = archive::severity_bit(Severity::Error);
+        query.channels   = { "disk" };
+        auto entries = reader.query(query);
+        // Error is i % 5 == 0, disk is i % 3 == 1
+        REQUIRE(entries.size() == 200);
+        CHECK(entries.front().message == "message 10");
+        for(auto& entry : entries)
+            CHECK((entry.severity == Severity::Error && entry.channel == "disk"));
+    }
+    SECTION("nothing")
+    {
+        archive::Query query;
+        query.channels = { "absent" };
+        CHECK(reader.query(query).empty());
+    }
+}
+
+TEST_CASE("Archive appends and survives torn tail")
+{
+    test::TempFile file("archive");
+    {
+        ArchiveLogger logger(file.path);
+        write_records(logger, 0, 100);
+    }
+    {
+        std::ofstream tail(file.path, std::ios::app | std::ios::binary);
+        tail << "TBLK garbage";
+    }
+    CHECK(ArchiveReader(file.path).query(archive::Query()).size() == 100);
+    {
+        ArchiveLogger logger(file.path);
+        write_records(logger, 100, 200);
+    }
+    ArchiveReader reader(file.path);
+    CHECK(reader.blocks().size() == 2);
+    auto entries = reader.query(archive::Query());
+    REQUIRE(entries.size() == 200);
+    CHECK(entries.back().message == "message 199");
+}
+
+TEST_CASE("Archive rejects foreign files")
+{
+    test::TempFile file("archive");
+    {
+        std::ofstream other(file.path);
+        other << "plain text log\n";
+    }
+    CHECK_THROWS_AS(ArchiveReader(file.path), std::runtime_error);
+    CHECK_THROWS_AS(ArchiveLogger(file.path), std::runtime_error);
+}
@@ -0,0 +1,71 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+#include <toolboxcpp/log/Log.hpp>
+#include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/log/Bootstrap.hpp>
+
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace toolboxcpp::log;
+// Bootstrap buffer is process-wide and can be replayed only once, so whole scenario is single test case
+namespace
+{
+    struct Collector
+    {
+        std::shared_ptr<std::vector<std::string>> messages;
+
+        bool is_enabled(Metadata const& meta) { return meta.severity <= Severity::Debug; }
+        void write(Record const& rec, WriterFunc writer)
+        {
+            std::ostringstream ost;
+            writer(ost);
+            auto user = rec.context.find("user");
+            if(user)
+                ost << " user=" << user->value;
+            messages->push_back(ost.str());
+        }
+    };
+}
+
+TEST_CASE("Bootstrap buffer replays early records into real logger")
+{
+    bootstrap::Options options;
+    options.max_records = 4;
+    options.severity    = Severity::Info;
+    bootstrap::enable(options);
+    CHECK_THROWS_AS(bootstrap::enable(options), std::logic_error);
+
+    {
+        $LogContext("user", "alice");
+        $log_info("first");
+    }
+    $log_debug("too verbose for bootstrap");
+    $log_error("second");
+    $log_warn("third");
+    $log_info("fourth");
+    $log_info("fifth");
+    $log_info("sixth");
+    CHECK(bootstrap::dropped() == 2);
+
+    auto messages = std::make_shared<std::vector<std::string>>();
+    // Real logger may be set from any thread
+    std::thread([&] { set_logger(Collector { messages }); }).join();
+    CHECK_THROWS_AS(set_logger(Collector { messages }), std::logic_error);
+
+    $log_debug("seventh");
+
+    using Catch::Matchers::Equals;
+    REQUIRE(messages->size() == 6);
+    CHECK_THAT((*messages)[0], Equals("first user=alice"));
+    CHECK_THAT((*messages)[1], Equals("second"));
+    CHECK_THAT((*messages)[2], Equals("third"));
+    CHECK_THAT((*messages)[3], Equals("fourth"));
+    CHECK_THAT((*messages)[4], Equals("Bootstrap log buffer overflowed, 2 records dropped"));
+    CHECK_THAT((*messages)[5], Equals("seventh"));
+}
@@ -0,0 +1,225 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+#include <toolboxcpp/log/FastFmt.hpp>
+#include <toolboxcpp/log/FormatString.hpp>
+#include <toolboxcpp/log/Layout.hpp>
+#include <toolboxcpp/util/CharConv.hpp>
+#include <toolboxcpp/util/Escape.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+
+using namespace toolboxcpp;
+
+namespace
+{
+    template<typename T>
+    std::string integer(T value)
+    {
+        char buffer[util::MaxIntegerChars];
+        return std::string(buffer, util::write_integer(buffer, value));
+    }
+
+    template<typename F>
+    std::string floating(F value)
+    {
+        char buffer[util::MaxFloatChars];
+        return std::string(buffer, util::write_float(buffer, value));
+    }
+
+    std::string timestamp(std::chrono::system_clock::time_point time)
+    {
+        char buffer[util::TimestampChars];
+        return std::string(buffer, util::write_timestamp(buffer, time));
+    }
+
+    template<typename Fmt>
+    std::string render(Fmt const& fmt)
+    {
+        std::ostringstream ost;
+        fmt(ost);
+        return ost.str();
+    }
+}
+
+TEST_CASE("Integer encoding")
+{
+    CHECK(integer(0)    == "0");
+    CHECK(integer(7)    == "7");
+    CHECK(integer(42)   == "42");
+    CHECK(integer(-100) == "-100");
+    CHECK(integer(std::numeric_limits<std::int64_t>::min())  == "-9223372036854775808");
+    CHECK(integer(std::numeric_limits<std::uint64_t>::max()) == "18446744073709551615");
+    CHECK(integer(std::numeric_limits<std::int8_t>::min() + 0) == "-128");
+}
+
+TEST_CASE("Floating-point encoding round-trips")
+{
+    CHECK(floating(0.0)     == "0");
+    CHECK(floating(-0.0)    == "-0");
+    CHECK(floating(3.0)     == "3");
+    CHECK(floating(0.1)     == "0.1");
+    CHECK(floating(0.1f)    == "0.1");
+    CHECK(floating(1.5e300) == "1.5e+300");
+    CHECK(floating(std::numeric_limits<double>::infinity())  == "inf");
+    CHECK(floating(-std::numeric_limits<double>::infinity()) == "-inf");
+    CHECK(floating(std::numeric_limits<double>::quiet_NaN()) == "nan");
+
+    for(double value: { 1.0 / 3, 2.0 / 3, 1e-7, 123456.789, 0.30000000000000004 })
+        CHECK(std::strtod(floating(value).c_str(), nullptr) == value);
+}
+
+TEST_CASE("Timestamp encoding")
+{
+    using namespace std::chrono;
+
+    system_clock::time_point epoch;
+    CHECK(timestamp(epoch) == "1970-01-01T00:00:00.000000Z");
+    // 2024-02-29T23:59:59.123456Z
+    auto leap = epoch + seconds(1709251199) + microseconds(123456);
+    CHECK(timestamp(leap) == "2024-02-29T23:59:59.123456Z");
+    // Same second reuses cached prefix, next one re-renders it
+    CHECK(timestamp(leap + microseconds(1))  == "2024-02-29T23:59:59.123457Z");
+    CHECK(timestamp(leap + milliseconds(900)) == "2024-03-01T00:00:00.023456Z");
+    CHECK(timestamp(epoch - microseconds(1)) == "1969-12-31T23:59:59.999999Z");
+}
+
+TEST_CASE("Fast formatter")
+{
+    std::string name("answer");
+    CHECK(render(log::fast_format(name, " is ", 42, ", ratio ", 0.25, ' ', true)) == "answer is 42, ratio 0.25 1");
+    CHECK(render(log::fast_format(std::chrono::system_clock::time_point())) == "1970-01-01T00:00:00.000000Z");
+}
+
+TEST_CASE("Format string is split into spans at compile time")
+{
+    struct Format
+    {
+        static constexpr const char* text() { return "user {} took {}us {{ok}}"; }
+        static constexpr std::size_t size() { return 24; }
+    };
+    using Spec = log::FormatSpec<Format>;
+    static_assert(Spec::valid, "Format should be valid");
+    static_assert(Spec::span_count == 5 && Spec::slot_count == 2, "Format should have 5 spans and 2 slots");
+
+    const log::FormatSpan expected[] = { { 0, 5, 0 }, { 7, 6, 1 }, { 15, 4, -1 }, { 20, 3, -1 }, { 24, 0, -1 } };
+    for(std::size_t i = 0; i < Spec::span_count; ++i)
+    {
+        CAPTURE(i);
+        CHECK(Spec::spans()[i].offset == expected[i].offset);
+        CHECK(Spec::spans()[i].size   == expected[i].size);
+        CHECK(Spec::spans()[i].slot   == expected[i].slot);
+    }
+
+    std::string name("bob");
+    CHECK(render($log_format_f("user {} took {}us {{ok}}", name, 42)) == "user bob took 42us {ok}");
+    CHECK(render($log_format_f("{}{}", 0.5, "!")) == "0.5!");
+    CHECK(render($log_format_f("no slots")) == "no slots");
+    CHECK(render($log_format_f("")) == "");
+}
+
+TEST_CASE("Layout renders record fields")
+{
+    using namespace std::chrono;
+
+    log::Record record;
+    record.severity  = log::Severity::Warning;
+    record.channel   = "db";
+    record.location  = util::SourceLocation("src/db/Pool.cpp", 42, "acquire");
+    record.timestamp = system_clock::time_point() + seconds(86400) + microseconds(5);
+
+    auto message = [](std::ostream& ost) { ost << "pool exhausted"; };
+    auto render_layout = [&](const char* pattern)
+    {
+        std::ostringstream ost;
+        log::Layout layout(pattern);
+        layout(ost, record, message);
+        return ost.str();
+    };
+
+    CHECK(render_layout("%T [%L] %C %b:%l %m")  == "1970-01-02T00:00:00.000005Z [WARN] db Pool.cpp:42 pool exhausted");
+    CHECK(render_layout("%f in %F(): %m 100%%") == "src/db/Pool.cpp in acquire(): pool exhausted 100%");
+    CHECK(render_layout("")                     == "");
+
+    CHECK_THROWS_AS(log::Layout("%Q"), std::invalid_argument);
+    CHECK_THROWS_AS(log::Layout("50%"), std::invalid_argument);
+}
+
+TEST_CASE("Escaping kernels agree with scalar one")
+{
+    using util::escape::Kernel;
+    using util::escape::Mode;
+
+    std::string input         = "say \"hi\"\n\ttab\x01 \\ done";
+    std::string expected_json = "say \\\"hi\\\"\\n\\ttab\\u0001 \\\\ done";
+    std::string expected_line = "say \"hi\"\\n\ttab\\x01 \\\\ done";
+
+    // Bytes which need escaping at every offset of blocks of all kernels
+    std::string random;
+    std::uint32_t seed = 12345;
+    for(int i = 0; i < 4096; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        unsigned value = (seed >> 16) & 0xFF;
+        random.push_back(static_cast<char>(value % 7 == 0 ? value % 0x20 : value % 3 == 0 ? '"' : value % 5 == 0 ? '\\' : value));
+    }
+
+    Kernel best = util::escape::best_kernel();
+    std::string reference[2];
+    for(Kernel kernel : { Kernel::Scalar, Kernel::Sse2, Kernel::Avx2 })
+    {
+        Kernel used = util::escape::set_kernel(kernel);
+        CAPTURE(util::escape::kernel_name(used));
+        CHECK(util::escape::kernel() == used);
+
+        std::string json, line;
+        util::escape::append(Mode::Json, input.data(), input.size(), json);
+        util::escape::append(Mode::Line, input.data(), input.size(), line);
+        CHECK(json == expected_json);
+        CHECK(line == expected_line);
+
+        for(std::size_t offset = 0; offset < 40; ++offset)
+        {
+            std::string clean(offset, 'a');
+            CHECK(util::escape::find_special(Mode::Json, (clean + '"' + std::string(40, 'b')).data(), offset + 41) == offset);
+            CHECK(util::escape::find_special(Mode::Line, (clean + '\t' + std::string(40, 'b')).data(), offset + 41) == offset + 41);
+            CHECK(util::escape::find_special(Mode::Line, (clean + '\x80' + '\n').data(), offset + 2) == offset + 1);
+            CHECK(util::escape::find_special(Mode::Line, (clean + '"' + '\\' + std::string(40, 'b')).data(), offset + 42) == offset + 1);
+        }
+
+        std::string escaped[2];
+        util::escape::append(Mode::Json, random.data(), random.size(), escaped[0]);
+        std::ostringstream ost;
+        util::escape::write(Mode::Line, random.data(), random.size(), ost);
+        escaped[1] = ost.str();
+        if(kernel == Kernel::Scalar)
+        {
+            reference[0] = escaped[0];
+            reference[1] = escaped[1];
+        }
+        CHECK(escaped[0] == reference[0]);
+        CHECK(escaped[1] == reference[1]);
+    }
+    util::escape::set_kernel(best);
+}
+
+TEST_CASE("Layout and sanitizer escape message")
+{
+    log::Record record {};
+    auto message = [](std::ostream& ost) { ost << "user \"bob\"\nlogged in"; };
+
+    std::ostringstream json;
+    log::Layout("{\"msg\":\"%J\"}")(json, record, message);
+    CHECK(json.str() == "{\"msg\":\"user \\\"bob\\\"\\nlogged in\"}");
+
+    std::ostringstream line;
+    log::Layout("%M|")(line, record, message);
+    CHECK(line.str() == "user \"bob\"\\nlogged in|");
+
+    std::ostringstream sanitized;
+    log::Sanitizer()(sanitized, record, message);
+    CHECK(sanitized.str() == "user \"bob\"\\nlogged in");
+}
@@ -3,14 +3,27 @@
 #define LOG_DETAILED
 #include <toolboxcpp/log/Log.hpp>
 #include <toolboxcpp/log/Logger.hpp>
+#include <toolboxcpp/log/Aggregate.hpp>
+#include <toolboxcpp/log/Combinators.hpp>
+#include <toolboxcpp/log/FormatString.hpp>
+#include <toolboxcpp/log/Priority.hpp>
+#include <toolboxcpp/log/Profile.hpp>
+#include <toolboxcpp/log/Router.hpp>
+#include <toolboxcpp/log/Sites.hpp>
 
+#include <atomic>
 #include <stdexcept>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace toolboxcpp::log;
 // These are used to get what's received by logger methods
 static Metadata g_last_metadata;
 static Record   g_last_record;
+static std::string g_last_message;
 
 struct TestLogger: public Logger
 {
@@ -26,9 +39,12 @@ public:
         return true;
     }
 
-    void write(Record const& rec, WriterFunc) override
+    void write(Record const& rec, WriterFunc writer) override
     {
         g_last_record = rec;
+        std::ostringstream ost;
+        writer(ost);
+        g_last_message = ost.str();
     }
 };
 
@@ -91,3 +107,595 @@ TEST_CASE("Logging severities")
     CHECK	  (g_last_metadata.location.line == loc.line);
     CHECK_THAT(g_last_metadata.location.func ,  Equals(loc.func));
 }
+
+TEST_CASE("Logging with format strings")
+{
+    using Catch::Matchers::Equals;
+
+    int user = 42;
+    $log_warn_f("user {} took {} us", user, 1.5); Location loc = $LogCurrentLocation;
+    CHECK     (g_last_record.severity == Severity::Warning);
+    CHECK     (g_last_record.location.line == loc.line);
+    CHECK     (g_last_record.site != SiteId());
+    CHECK_THAT(g_last_message, Equals("user 42 took 1.5 us"));
+
+    $log_trace_f("{{}} is {}", "empty");
+    CHECK     (g_last_record.severity == Severity::Trace);
+    CHECK_THAT(g_last_message, Equals("{} is empty"));
+}
+
+TEST_CASE("Logging context")
+{
+    using Catch::Matchers::Equals;
+
+    CHECK(context::current().empty());
+    {
+        $LogContext("request", "42");
+        std::string tenant("acme");
+        $LogContext("tenant", tenant);
+
+        $log_info("Contextful message");
+        REQUIRE(g_last_record.context.size() == 2);
+        CHECK_THAT(g_last_record.context.find("request")->value, Equals("42"));
+        CHECK_THAT(g_last_record.context.find("tenant")->value,  Equals("acme"));
+        CHECK(g_last_record.context.find("user") == nullptr);
+
+        std::ostringstream ost;
+        ost << g_last_record.context;
+        CHECK_THAT(ost.str(), Equals("request=42 tenant=acme"));
+    }
+    CHECK(context::current().empty());
+    // Overflowing arena is reported, not silently truncated
+    std::string huge(context::ArenaSize, 'x');
+    ScopedContext overflow("huge", huge);
+    CHECK_FALSE(overflow.pushed());
+    CHECK(context::current().empty());
+}
+
+// Never called, but its site should still be registered
+inline void unreached_site() { $log_warn("Unreached"); } static const int g_unreached_line = __LINE__;
+
+// Log statements are expressions, usable at namespace scope too
+static const int g_namespace_scope = ($log_info("Namespace scope"), 0);
+
+static void log_function_name() { $log_info(__func__); }
+// Logs from inside message argument of another statement
+static int nested_log() { $log_warn("Nested"); return 1; }
+
+TEST_CASE("Logging callsites")
+{
+    using Catch::Matchers::Equals;
+
+    auto sites = sites::list();
+    REQUIRE(sites.size() == sites::count());
+    bool unreached = false;
+    for(auto& site: sites)
+        if(site.line == g_unreached_line && site.severity == Severity::Warning)
+        {
+            CHECK_THAT(site.basename, Equals("Log.cpp"));
+            unreached = true;
+        }
+    CHECK(unreached);
+
+    auto write = [] { $log_info("Toggled"); };
+    int line = __LINE__ - 1;
+
+    g_last_record.site = 0;
+    write();
+    SiteId id = g_last_record.site;
+    REQUIRE(id != 0);
+    CHECK(g_last_metadata.site == id);
+
+    Site site = sites::get(id);
+    CHECK(site.id       == id);
+    CHECK(site.line     == line);
+    CHECK(site.severity == Severity::Info);
+    CHECK_THAT(site.file, Equals(__FILE__));
+    // Registry owns its copy, so descriptor outlives library which registered it
+    CHECK(site.file != static_cast<const char*>(__FILE__));
+    // Switched off site doesn't even reach logger
+    sites::set_enabled(id, false);
+    CHECK_FALSE(sites::is_enabled(id));
+    g_last_record.site = 0;
+    write();
+    CHECK(g_last_record.site == 0);
+
+    sites::set_enabled(id, true);
+    write();
+    CHECK(g_last_record.site == id);
+    // Site expression is evaluated once per record, so each callsite defines single descriptor
+    int evaluated = 0;
+    $log_perform_write_site((++evaluated, id), Severity::Info, $LogCurrentChannel, $LogCurrentLocation,
+        [](std::ostream& ost) { ost << "Once"; });
+    CHECK(evaluated == 1);
+    CHECK(g_last_record.site == id);
+    CHECK(g_last_message == "Once");
+    // Message arguments are evaluated in caller's scope
+    log_function_name();
+    CHECK(g_last_message == "log_function_name");
+    // Nested statement doesn't take over site of the outer one
+    $log_info("Outer ", nested_log()); line = __LINE__;
+    REQUIRE(g_last_message == "Outer 1");
+    CHECK(sites::get(g_last_record.site).line == line);
+    CHECK(sites::get(g_last_record.site).severity == Severity::Info);
+
+    CHECK_THROWS_AS(sites::get(0), std::out_of_range);
+    CHECK_THROWS_AS(sites::set_enabled(static_cast<SiteId>(sites::count() + 1), false), std::out_of_range);
+}
+
+TEST_CASE("Adaptive logger escalates severity under pressure")
+{
+    struct Collector
+    {
+        bool is_enabled(Metadata const& meta) { return meta.severity <= max; }
+        void write(Record const& rec, WriterFunc writer)
+        {
+            std::ostringstream ost;
+            writer(ost);
+            messages->push_back(ost.str());
+            if(rec.severity != Severity::Warning)
+                ++*written;
+        }
+
+        std::vector<std::string>* messages;
+        Severity max;
+        int* written;
+    };
+
+    std::vector<std::string> reports;
+    std::size_t pressure = 0;
+    std::size_t probes = 0;
+    int written = 0;
+    auto logger = make_adaptive_logger(
+        [&](Collector&) { ++probes; return pressure; },
+        { { 100, 50, Severity::Info }, { 200, 150, Severity::Error } },
+        Collector { &reports, Severity::Trace, &written }
+    );
+    auto enabled = [&](Severity sev) { return logger.is_enabled(Metadata { sev, "", Location() }); };
+
+    CHECK(enabled(Severity::Trace));
+
+    pressure = 120;
+    CHECK_FALSE(enabled(Severity::Debug));
+    CHECK(enabled(Severity::Info));
+    CHECK(logger.max_severity() == Severity::Info);
+
+    pressure = 250;
+    CHECK_FALSE(enabled(Severity::Warning));
+    CHECK(enabled(Severity::Error));
+    // Hysteresis: pressure dropped below raise point, but not below lowering one
+    pressure = 180;
+    CHECK_FALSE(enabled(Severity::Warning));
+    pressure = 60;
+    CHECK(enabled(Severity::Info));
+    CHECK_FALSE(enabled(Severity::Debug));
+    pressure = 10;
+    CHECK(enabled(Severity::Trace));
+
+    using Catch::Matchers::Equals;
+    REQUIRE(reports.size() == 4);
+    CHECK_THAT(reports[0], Equals("Log pressure 120: severity threshold raised to INFO"));
+    CHECK_THAT(reports[1], Equals("Log pressure 250: severity threshold raised to ERROR"));
+    CHECK_THAT(reports[2], Equals("Log pressure 60: severity threshold lowered to INFO"));
+    CHECK_THAT(reports[3], Equals("Log pressure 10: severity threshold lowered to TRACE"));
+    // Batch is forwarded without probing pressure for each entry
+    std::vector<BatchEntry> batch(3, BatchEntry { Record(), "x", 1 });
+    for(auto& entry : batch)
+        entry.record.severity = Severity::Info;
+    probes = 0;
+    write_batch(logger, batch.data(), batch.size());
+    CHECK(probes == 0);
+    CHECK(written == 3);
+    // Batch is filtered against current threshold, even if caller didn't check it
+    pressure = 120;
+    CHECK_FALSE(enabled(Severity::Debug));
+    batch[1].record.severity = Severity::Debug;
+    written = 0;
+    write_batch(logger, batch.data(), batch.size());
+    CHECK(written == 2);
+    // Level changes aren't reported to logger which doesn't accept warnings
+    std::vector<std::string> quiet;
+    auto strict = make_adaptive_logger(
+        [&](Collector&) { return pressure; },
+        { { 100, 50, Severity::Info } },
+        Collector { &quiet, Severity::Error, &written }
+    );
+    pressure = 120;
+    CHECK(strict.is_enabled(Metadata { Severity::Error, "", Location() }));
+    CHECK(strict.max_severity() == Severity::Info);
+    CHECK(quiet.empty());
+}
+
+TEST_CASE("Flushing logger flushes on executor")
+{
+    struct Flushed
+    {
+        std::atomic<int>* flushes;
+
+        bool is_enabled(Metadata const&) { return true; }
+        void write(Record const&, WriterFunc) {}
+        void flush() { ++*flushes; }
+    };
+
+    std::atomic<int> flushes { 0 };
+    toolboxcpp::util::Executor executor;
+    {
+        auto logger = make_flushing_logger(Flushed { &flushes }, std::chrono::milliseconds(1), executor);
+        for(int i = 0; i < 5000 && flushes < 3; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        CHECK(flushes >= 3);
+    }
+    // Final flush on destruction, and no flushes after it
+    int final = flushes;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(flushes == final);
+}
+
+TEST_CASE("Cached logger formats message once")
+{
+    struct Collector
+    {
+        std::vector<std::string>* messages;
+
+        bool is_enabled(Metadata const&) { return true; }
+        void write(Record const&, WriterFunc writer)
+        {
+            std::ostringstream ost;
+            writer(ost);
+            messages->push_back(ost.str());
+        }
+    };
+
+    std::vector<std::string> messages;
+    auto logger = make_cached_logger(make_multi_logger(Collector { &messages }, Collector { &messages }));
+
+    int calls = 0;
+    std::string text(1000, 'x');
+    auto writer = [&](std::ostream& ost) { ++calls; ost << text; };
+    Record record {};
+    logger.write(record, writer);
+    CHECK(calls == 1);
+    REQUIRE(messages.size() == 2);
+    CHECK(messages[0] == text);
+    CHECK(messages[1] == text);
+}
+
+
+TEST_CASE("Histogram logger aggregates values into summaries")
+{
+    struct Collector
+    {
+        std::shared_ptr<std::vector<std::pair<Record, std::string>>> messages;
+
+        bool is_enabled(Metadata const&) { return true; }
+        void write(Record const& record, WriterFunc writer)
+        {
+            std::ostringstream ost;
+            writer(ost);
+            messages->emplace_back(record, ost.str());
+        }
+    };
+
+    auto messages = std::make_shared<std::vector<std::pair<Record, std::string>>>();
+    histogram::Options options;
+    options.group_by    = histogram::GroupBy::Channel;
+    options.interval    = std::chrono::milliseconds(3600 * 1000);
+    options.percentiles = { 0.5 };
+    auto logger = make_histogram_logger(Collector { messages }, options);
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t)
+        threads.emplace_back([&logger] {
+            Record record {};
+            record.channel = "rpc";
+            for(int i = 1; i <= 100; ++i)
+                logger.write(record, [&](std::ostream& ost) { ost << "call took " << histogram::metric(i) << " us, attempt 7"; });
+            record.channel = "db";
+            for(int i = 0; i < 10; ++i)
+                logger.write(record, [&](std::ostream& ost) { ost << "query took " << 20 << " us"; });
+        });
+    for(auto& thread : threads)
+        thread.join();
+
+    Record plain {};
+    plain.channel = "rpc";
+    logger.write(plain, [](std::ostream& ost) { ost << "no value here"; });
+    REQUIRE(messages->size() == 1);
+    CHECK(messages->back().second == "no value here");
+
+    logger.flush();
+    REQUIRE(messages->size() == 3);
+    CHECK(std::string(messages->at(1).first.channel) == "db");
+    CHECK(messages->at(1).second == "db count=40 mean=20 min=20 p50=20 max=20");
+    CHECK(messages->at(1).first.severity == Severity::Info);
+    CHECK(std::string(messages->at(2).first.channel) == "rpc");
+    CHECK(messages->at(2).second.find("rpc count=400 mean=50 ") == 0);
+
+    // Summaries cover single interval
+    logger.flush();
+    CHECK(messages->size() == 3);
+}
+
+TEST_CASE("Priority lanes take errors first without starving others")
+{
+    priority::Options options;
+    for(auto& lane : options.lanes)
+        lane = priority::Lane { 8, 1 };
+    options.lanes[priority::lane_of(Severity::Error)].weight = 2;
+    priority::Lanes lanes(options);
+
+    Record record {};
+    record.severity = Severity::Debug;
+    for(int i = 0; i < 10; ++i)
+        lanes.push(record, [&](std::ostream& ost) { ost << "debug " << i; });
+    record.severity = Severity::Error;
+    {
+        $LogContext("request", "42");
+        record.context = context::current();
+        for(int i = 0; i < 3; ++i)
+            lanes.push(record, [&](std::ostream& ost) { ost << "error " << i; });
+    }
+
+    auto stats = lanes.stats();
+    CHECK(stats[priority::lane_of(Severity::Debug)].queued  == 8);
+    CHECK(stats[priority::lane_of(Severity::Debug)].dropped == 2);
+    CHECK(stats[priority::lane_of(Severity::Error)].queued  == 3);
+    CHECK(lanes.depth() == 11);
+
+    std::vector<std::string> taken;
+    auto consumer = [&](Record const& rec, WriterFunc writer) {
+        std::ostringstream ost;
+        writer(ost);
+        if(rec.severity == Severity::Error)
+            ost << ' ' << rec.context;
+        taken.push_back(ost.str());
+    };
+    CHECK(lanes.pop(consumer, 5) == 5);
+    CHECK(lanes.pop(consumer, 100) == 6);
+    CHECK(lanes.pop(consumer, 100) == 0);
+    std::vector<std::string> expected = {
+        "error 0 request=42", "error 1 request=42", "debug 0", "error 2 request=42",
+        "debug 1", "debug 2", "debug 3", "debug 4", "debug 5", "debug 6", "debug 7",
+    };
+    CHECK(taken == expected);
+    CHECK(lanes.stats()[priority::lane_of(Severity::Debug)].taken == 8);
+}
+
+TEST_CASE("Priority logger writes queued records from background thread")
+{
+    struct Collector
+    {
+        std::shared_ptr<std::vector<std::string>> messages;
+
+        bool is_enabled(Metadata const&) { return true; }
+        void write(Record const&, WriterFunc writer)
+        {
+            std::ostringstream ost;
+            writer(ost);
+            messages->push_back(ost.str());
+        }
+    };
+
+    auto messages = std::make_shared<std::vector<std::string>>();
+    {
+        auto logger = make_priority_logger(Collector { messages });
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t)
+            threads.emplace_back([&logger, t] {
+                Record record {};
+                record.severity = t % 2 ? Severity::Error : Severity::Info;
+                for(int i = 0; i < 500; ++i)
+                    logger.write(record, [&](std::ostream& ost) { ost << t << ' ' << i; });
+            });
+        for(auto& thread : threads)
+            thread.join();
+    }
+    // Order within single lane is kept
+    REQUIRE(messages->size() == 2000);
+    std::vector<int> next(4, 0);
+    for(auto& message : *messages)
+    {
+        int t = message[0] - '0';
+        CHECK(message == std::to_string(t) + ' ' + std::to_string(next[t]++));
+    }
+}
+
+TEST_CASE("Callsite profiler finds heaviest lines")
+{
+    using Catch::Matchers::Equals;
+    using Catch::Matchers::StartsWith;
+
+    auto heavy = [](int i) { $log_info(std::string(100, 'h'), i % 10); };
+    int heavy_line = __LINE__ - 1;
+    auto light = [](int i) { $log_info("light", i % 10); };
+    int light_line = __LINE__ - 1;
+
+    // Test logger isn't thread-safe, so threads run one after another; shards of both are merged on read
+    profile::set_enabled(true);
+    for(int t = 0; t < 2; ++t)
+        std::thread([&] {
+            for(int i = 0; i < 200; ++i)
+                heavy(i);
+            for(int i = 0; i < 50; ++i)
+                light(i);
+        }).join();
+    // Message still reaches logger intact
+    heavy(3);
+    CHECK(g_last_message == std::string(100, 'h') + "3");
+    profile::set_enabled(false);
+    light(1);
+
+    auto top = profile::top_callsites(2);
+    REQUIRE(top.size() == 2);
+    CHECK(top[0].location.line == heavy_line);
+    CHECK(top[0].site != 0);
+    CHECK(top[0].records >= 401);
+    CHECK(top[0].bytes   >= 401 * 101);
+    CHECK(top[1].location.line == light_line);
+    CHECK(top[1].records >= 100);
+    CHECK(top[1].records <  top[0].records);
+
+    std::ostringstream report;
+    profile::write_report(report, top);
+    CHECK_THAT(report.str(), StartsWith(std::string(__FILE__) + ':' + std::to_string(heavy_line) + " bytes="));
+
+    toolboxcpp::util::Executor executor;
+    {
+        profile::ReportOptions options;
+        options.interval = std::chrono::milliseconds(3600 * 1000);
+        options.count    = 1;
+        profile::Reporter reporter(options, executor);
+        CHECK(profile::is_enabled());
+        reporter.report();
+        CHECK_THAT(g_last_record.channel, Equals("toolboxcpp.log"));
+        CHECK_THAT(g_last_message, StartsWith("Top log callsites: "));
+    }
+    CHECK_FALSE(profile::is_enabled());
+}
+
+TEST_CASE("Batch write passes filtered runs to nested loggers")
+{
+    struct BatchCollector
+    {
+        std::vector<std::size_t>* batches;
+        std::vector<std::string>* messages;
+
+        bool is_enabled(Metadata const&) { return true; }
+        void write(Record const&, WriterFunc) { FAIL("Batch should not be split into single writes"); }
+        void write_batch(BatchEntry const* entries, std::size_t count)
+        {
+            batches->push_back(count);
+            for(std::size_t i = 0; i < count; ++i)
+                messages->push_back(std::string(entries[i].message, entries[i].size));
+        }
+    };
+    // Has no `write_batch`, so receives batch record by record
+    struct Collector
+    {
+        std::vector<std::string>* messages;
+
+        bool is_enabled(Metadata const& meta) { return meta.severity != Severity::Trace; }
+        void write(Record const&, WriterFunc writer)
+        {
+            std::ostringstream ost;
+            writer(ost);
+            messages->push_back(ost.str());
+        }
+    };
+
+    std::vector<std::size_t> batches;
+    std::vector<std::string> formatted, plain;
+    auto logger = make_multi_logger(
+        make_filtered_logger(
+            [](Metadata const& meta) { return meta.severity <= Severity::Warning; },
+            make_formatted_logger(
+                [](std::ostream& ost, Record const& rec, WriterFunc writer) { ost << severity_name(rec.severity) << ' '; writer(ost); },
+                BatchCollector { &batches, &formatted }
+            )
+        ),
+        Collector { &plain }
+    );
+
+    const Severity severities[] = {
+        Severity::Error, Severity::Warning, Severity::Info, Severity::Error, Severity::Trace, Severity::Debug, Severity::Error
+    };
+    const char* texts[] = { "a", "b", "c", "d", "e", "f", "g" };
+    std::vector<BatchEntry> entries;
+    for(std::size_t i = 0; i < 7; ++i)
+    {
+        BatchEntry entry {};
+        entry.record.severity = severities[i];
+        entry.message = texts[i];
+        entry.size    = 1;
+        entries.push_back(entry);
+    }
+    write_batch(logger, entries.data(), entries.size());
+
+    using Catch::Matchers::Equals;
+    CHECK(batches == (std::vector<std::size_t> { 2, 1, 1 }));
+    REQUIRE(formatted.size() == 4);
+    CHECK_THAT(formatted[0], Equals("ERROR a"));
+    CHECK_THAT(formatted[1], Equals("WARN b"));
+    CHECK_THAT(formatted[2], Equals("ERROR d"));
+    CHECK_THAT(formatted[3], Equals("ERROR g"));
+    CHECK(plain == (std::vector<std::string> { "a", "b", "c", "d", "f", "g" }));
+}
+
+TEST_CASE("Channel router sends records to partition of their channel")
+{
+    static const char net[] = "net";
+    static const char db[]  = "db";
+    // Same text as partition channel, but different pointer
+    std::string db_copy = "db";
+
+    router::Table table({ "net", "db" }, 16);
+    CHECK(table.size() == 2);
+    CHECK(table.find(net) == 0);
+    CHECK(table.find(db) == 1);
+    CHECK(table.find(db_copy.c_str()) == 1);
+    CHECK(table.find("other") == 2);
+    CHECK(table.find(nullptr) == 2);
+    CHECK(table.channel(2).empty());
+    // Table stops caching when half full, yet keeps resolving
+    std::vector<std::string> extra;
+    for(int i = 0; i < 20; ++i)
+        extra.push_back(i % 2 ? "net" : "unknown");
+    for(int i = 0; i < 20; ++i)
+        CHECK(table.find(extra[i].c_str()) == (i % 2 ? 0u : 2u));
+
+    struct Collector
+    {
+        std::shared_ptr<std::vector<std::string>> messages;
+
+        bool is_enabled(Metadata const&) { return true; }
+        void write(Record const& record, WriterFunc writer)
+        {
+            std::ostringstream ost;
+            writer(ost);
+            messages->push_back(std::string(record.channel ? record.channel : "-") + ' ' + ost.str());
+        }
+    };
+
+    std::vector<std::shared_ptr<std::vector<std::string>>> sinks;
+    std::vector<router::Stats> stats;
+    {
+        auto logger = make_channel_router({ "net", "db" }, [&](std::string const&) {
+            sinks.push_back(std::make_shared<std::vector<std::string>>());
+            return Collector { sinks.back() };
+        });
+        REQUIRE(sinks.size() == 3);
+        CHECK(logger.size() == 2);
+        CHECK(logger.channel(1) == "db");
+
+        const char* channels[] = { net, db, db_copy.c_str(), "other", nullptr };
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 5; ++t)
+            threads.emplace_back([&logger, &channels, t] {
+                Record record {};
+                record.severity = Severity::Info;
+                record.channel  = channels[t];
+                for(int i = 0; i < 200; ++i)
+                    logger.write(record, [&](std::ostream& ost) { ost << i; });
+            });
+        for(auto& thread : threads)
+            thread.join();
+        while(logger.pending() != 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        stats = logger.stats();
+    }
+    CHECK(sinks[0]->size() == 200);
+    CHECK(sinks[1]->size() == 400);
+    CHECK(sinks[2]->size() == 400);
+    // Order of each writer is kept within partition
+    for(int i = 0; i < 200; ++i)
+        CHECK((*sinks[0])[i] == "net " + std::to_string(i));
+
+    REQUIRE(stats.size() == 3);
+    CHECK(stats[1].queued == 400);
+    CHECK(stats[1].dropped == 0);
+    CHECK(stats[2].queued == 400);
+    // Last batch may still be in sink when stats are taken
+    CHECK(stats[0].written <= 200);
+    CHECK(stats[0].bytes <= 200 * 3);
+    CHECK(stats[0].batches <= stats[0].written);
+}
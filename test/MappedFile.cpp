@@ -0,0 +1,156 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+#include <toolboxcpp/util/MappedFile.hpp>
+#include <toolboxcpp/util/Reaper.hpp>
+
+#include "TestUtil.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace toolboxcpp::util;
+
+namespace
+{
+    std::atomic<int> g_deleted { 0 };
+    std::atomic<int> g_batches { 0 };
+
+    struct BatchDeleter
+    {
+        static int zero() noexcept { return -1; }
+
+        void operator()(int* begin, int* end) const
+        {
+            ++g_batches;
+            g_deleted += static_cast<int>(end - begin);
+        }
+    };
+}
+
+TEST_CASE("Deferred deleter releases handles on reaper thread")
+{
+    g_deleted = 0;
+    g_batches = 0;
+    using Handle = Resource<int, Deferred<BatchDeleter>>;
+
+    CHECK(Handle().get() == -1);
+    {
+        std::vector<Handle> handles;
+        for(int i = 0; i < 100; ++i)
+            handles.emplace_back(i);
+    }
+    reaper::drain();
+    CHECK(g_deleted == 100);
+    CHECK(g_batches >= 1);
+    CHECK(g_batches <= 100);
+}
+
+TEST_CASE("Reaper closes descriptors in batches")
+{
+    using File = Resource<int, Deferred<reaper::CloseFds>>;
+
+    std::set<int> fds;
+    {
+        std::vector<File> files;
+        for(int i = 0; i < 16; ++i)
+        {
+            files.emplace_back(::open("/dev/null", O_RDONLY));
+            REQUIRE_FALSE(files.back().empty());
+            fds.insert(files.back().get());
+        }
+    }
+    reaper::drain();
+    for(int fd: fds)
+        CHECK(::fcntl(fd, F_GETFD) == -1);
+}
+
+TEST_CASE("Mapped file writes and streams windows")
+{
+    test::TempFile temp("mapped");
+    std::string const& path = temp.path;
+    std::size_t page = mapped::page_size();
+    std::size_t size = 5 * page + 123;
+    {
+        MappedFile file(path, mapped::Access::ReadWrite);
+        file.resize(size);
+        auto region = file.map();
+        REQUIRE(region.writable());
+        REQUIRE(region.size() == size);
+        for(std::size_t i = 0; i < size; ++i)
+            region.data()[i] = static_cast<char>(i * 7 % 251);
+        region.sync();
+    }
+
+    MappedFile file(path);
+    REQUIRE(file.size() == size);
+    auto check = [](MappedRegion const& region) {
+        for(std::size_t i = 0; i < region.size(); ++i)
+            if(region.data()[i] != static_cast<char>((region.offset() + i) * 7 % 251))
+                return false;
+        return true;
+    };
+    // Unaligned window, clipped to file end
+    mapped::Options options;
+    options.populate = true;
+    options.advice   = mapped::Advice::Sequential;
+    auto window = file.map(page + 17, size, options);
+    CHECK(window.offset() == page + 17);
+    CHECK(window.size() == size - page - 17);
+    CHECK_FALSE(window.writable());
+    CHECK(check(window));
+    window.prefetch(0, page);
+
+    options.huge_pages = true;
+    auto huge = file.map(options);
+    CHECK(reinterpret_cast<std::uintptr_t>(huge.data()) % mapped::HugePageSize == 0);
+    CHECK(check(huge));
+
+    CHECK(file.map(size, 10).empty());
+    CHECK_THROWS_AS(file.map(size + 1, 10), std::out_of_range);
+
+    std::size_t chunks = 0, total = 0;
+    for(auto& chunk : file.chunks(2 * page))
+    {
+        CHECK(chunk.offset() == total);
+        CHECK(check(chunk));
+        total += chunk.size();
+        ++chunks;
+    }
+    CHECK(chunks == 3);
+    CHECK(total == size);
+}
+
+TEST_CASE("Unmap releases adjacent mappings together")
+{
+    std::size_t page = mapped::page_size();
+    char* area = static_cast<char*>(::mmap(nullptr, 6 * page, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    REQUIRE(area != MAP_FAILED);
+    auto is_mapped = [&](int index) { return ::msync(area + index * page, page, MS_ASYNC) == 0; };
+    // Out of order, with gap at page 3, and partial page at the end of first run
+    std::vector<mapped::Span> spans = {
+        { area + 2 * page, page / 2 }, { area, page }, { area + 4 * page, 2 * page }, { area + page, page },
+    };
+    mapped::Unmap()(spans.data(), spans.data() + spans.size());
+    CHECK_FALSE(is_mapped(0));
+    CHECK_FALSE(is_mapped(2));
+    CHECK(is_mapped(3));
+    CHECK_FALSE(is_mapped(5));
+    ::munmap(area + 3 * page, page);
+    // Regions are unmapped by reaper thread
+    {
+        Resource<mapped::Span, Deferred<mapped::Unmap>> mapping(mapped::Span {
+            ::mmap(nullptr, page, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0), page
+        });
+        area = static_cast<char*>(mapping.get().address);
+    }
+    reaper::drain();
+    CHECK_FALSE(is_mapped(0));
+}
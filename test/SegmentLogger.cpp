@@ -0,0 +1,112 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+#include <toolboxcpp/log/SegmentLogger.hpp>
+
+#include "TestUtil.hpp"
+
+#include <cstdio>
+#include <string>
+
+#include <sys/stat.h>
+
+using namespace toolboxcpp::log;
+using test::expected_lines;
+using test::read_file;
+using test::write_lines;
+
+namespace
+{
+    // Base path of segments; segment files are removed on destruction
+    struct TempBase: test::TempFile
+    {
+        TempBase()
+            : TempFile("segment")
+        { }
+
+        ~TempBase()
+        {
+            for(std::size_t i = 0; i < 1000; ++i)
+                std::remove(segment::segment_path(path, i).c_str());
+        }
+
+        static bool exists(std::string const& file)
+        {
+            struct stat st;
+            return ::stat(file.c_str(), &st) == 0;
+        }
+
+        static off_t size(std::string const& file)
+        {
+            struct stat st;
+            return ::stat(file.c_str(), &st) == 0 ? st.st_size : -1;
+        }
+    };
+}
+
+TEST_CASE("Segment logger splits records between segments")
+{
+    TempBase base;
+    segment::Options options;
+    options.segment_size = 4096;
+    options.sync_chunk   = 1024;
+    SECTION("with spare segment") {}
+    SECTION("without spare segment") { options.preallocate_next = false; }
+
+    segment::Stats stats;
+    {
+        SegmentLogger logger(base.path, options);
+        write_lines(logger, 0, 2000);
+        stats = logger.stats();
+    }
+    CHECK(stats.errors == 0);
+    CHECK(stats.range_syncs > 0);
+    CHECK(stats.written_bytes == expected_lines(0, 2000).size());
+
+    std::string text;
+    std::size_t index = 0;
+    for(; TempBase::exists(segment::segment_path(base.path, index)); ++index)
+    {
+        auto file = segment::segment_path(base.path, index);
+        auto content = read_file(file);
+        // Tail is truncated and records aren't split
+        CHECK(TempBase::size(file) <= 4096);
+        CHECK(content.back() == '\n');
+        text += content;
+    }
+    CHECK(index == stats.segments);
+    CHECK(text == expected_lines(0, 2000));
+}
+
+TEST_CASE("Segment logger reserves segment and truncates it on close")
+{
+    TempBase base;
+    segment::Options options;
+    options.segment_size = 1 << 20;
+    std::string first;
+    {
+        SegmentLogger logger(base.path, options);
+        first = logger.current_path();
+        write_lines(logger, 0, 10);
+        logger.flush();
+        CHECK(read_file(first).substr(0, expected_lines(0, 10).size()) == expected_lines(0, 10));
+    }
+    CHECK(read_file(first) == expected_lines(0, 10));
+    // Spare segment is removed
+    CHECK_FALSE(TempBase::exists(segment::segment_path(base.path, 1)));
+}
+
+TEST_CASE("Segment logger doesn't overwrite existing segments")
+{
+    TempBase base;
+    {
+        std::ofstream existing(segment::segment_path(base.path, 0));
+        existing << "old\n";
+    }
+    {
+        SegmentLogger logger(base.path);
+        CHECK(logger.current_path() == segment::segment_path(base.path, 1));
+        write_lines(logger, 0, 1);
+    }
+    CHECK(read_file(segment::segment_path(base.path, 0)) == "old\n");
+    CHECK(read_file(segment::segment_path(base.path, 1)) == expected_lines(0, 1));
+}
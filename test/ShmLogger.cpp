@@ -0,0 +1,230 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+#include <toolboxcpp/log/ShmLogger.hpp>
+
+#include "TestUtil.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace toolboxcpp::log;
+
+namespace
+{
+    struct TempRing
+    {
+        TempRing()
+            : name("/" + test::temp_name("shm"))
+        { }
+
+        ~TempRing()
+        {
+            ::shm_unlink(name.c_str());
+        }
+
+        std::string name;
+    };
+
+    Record make_record(Severity severity, char const* channel)
+    {
+        Record record {};
+        record.severity  = severity;
+        record.channel   = channel;
+        record.timestamp = std::chrono::system_clock::now();
+        return record;
+    }
+
+    std::vector<shm::Entry> drain_all(ShmCollector& collector)
+    {
+        std::vector<shm::Entry> entries;
+        collector.drain([&](shm::Entry const& entry) { entries.push_back(entry); });
+        return entries;
+    }
+}
+
+TEST_CASE("Shared memory ring delivers records from several threads")
+{
+    TempRing ring;
+    shm::Options options;
+    options.slots = 4096;
+    ShmLogger logger(ring.name, options);
+    ShmCollector collector({ ring.name }, options);
+
+    const int Threads = 4, PerThread = 1000;
+    std::atomic<bool> done { false };
+    std::vector<shm::Entry> entries;
+    std::thread drainer([&] {
+        while(!done.load())
+            collector.drain([&](shm::Entry const& entry) { entries.push_back(entry); });
+        collector.drain([&](shm::Entry const& entry) { entries.push_back(entry); });
+    });
+
+    std::vector<std::thread> writers;
+    for(int t = 0; t < Threads; ++t)
+        writers.emplace_back([&, t] {
+            for(int i = 0; i < PerThread; ++i)
+                logger.write(make_record(Severity::Info, "net"), [&](std::ostream& ost) { ost << t << ' ' << i; });
+        });
+    for(auto& writer : writers)
+        writer.join();
+    done = true;
+    drainer.join();
+
+    std::vector<int> next(Threads, 0);
+    for(auto& entry : entries)
+    {
+        REQUIRE(entry.severity == Severity::Info);
+        REQUIRE(entry.channel == "net");
+        REQUIRE(entry.pid == ::getpid());
+        REQUIRE_FALSE(entry.truncated);
+        int t = entry.message[0] - '0';
+        REQUIRE(entry.message == std::to_string(t) + ' ' + std::to_string(next[t]));
+        ++next[t];
+    }
+    REQUIRE(entries.size() == std::size_t(Threads * PerThread));
+    REQUIRE(logger.stats().written == std::uint64_t(Threads * PerThread));
+    REQUIRE(collector.stats().collected == std::uint64_t(Threads * PerThread));
+}
+
+TEST_CASE("Shared memory ring drops records while full and truncates long ones")
+{
+    TempRing ring;
+    shm::Options options;
+    options.slots     = 4;
+    options.slot_size = 128;
+    ShmLogger logger(ring.name, options);
+    ShmCollector collector({ ring.name }, options);
+
+    Record record = make_record(Severity::Warning, "a-channel-name-longer-than-slot-allows");
+    for(int i = 0; i < 6; ++i)
+        logger.write(record, [&](std::ostream& ost) { ost << "record " << i; });
+    logger.write(record, [&](std::ostream& ost) { ost << std::string(1000, 'x'); });
+
+    auto stats = logger.stats();
+    REQUIRE(stats.written == 4);
+    REQUIRE(stats.dropped == 3);
+
+    auto entries = drain_all(collector);
+    REQUIRE(entries.size() == 4);
+    for(int i = 0; i < 4; ++i)
+        REQUIRE(entries[i].message == "record " + std::to_string(i));
+    REQUIRE(entries[0].channel == std::string("a-channel-name-longer-than-slot-allows").substr(0, 29));
+    REQUIRE(collector.stats().dropped == 3);
+
+    logger.write(record, [&](std::ostream& ost) { ost << std::string(1000, 'x'); });
+    entries = drain_all(collector);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].truncated);
+    REQUIRE(entries[0].message == std::string(entries[0].message.size(), 'x'));
+    REQUIRE(entries[0].message.size() < 128);
+    REQUIRE(logger.stats().truncated == 1);
+}
+
+TEST_CASE("Shared memory ring skips slot of crashed producer")
+{
+    TempRing ring;
+    shm::Options options;
+    options.slots = 16;
+    ShmLogger logger(ring.name, options);
+    ShmCollector collector({ ring.name }, options);
+
+    logger.write(make_record(Severity::Info, "app"), [](std::ostream& ost) { ost << "before"; });
+
+    pid_t child = ::fork();
+    if(child == 0)
+    {
+        // Reserve and claim slot, and die without committing it
+        auto mapping = shm::impl::open_ring(ring.name, options);
+        auto header = static_cast<shm::impl::Header*>(mapping.get());
+        std::uint64_t ticket = header->head.fetch_add(1);
+        auto slot = shm::impl::slot_at(header, ticket);
+        slot->claim.store(shm::impl::claim_of(ticket, shm::impl::Owned));
+        slot->pid.store(static_cast<std::int32_t>(::getpid()));
+        ::_exit(0);
+    }
+    REQUIRE(child > 0);
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+
+    logger.write(make_record(Severity::Info, "app"), [](std::ostream& ost) { ost << "after"; });
+
+    auto entries = drain_all(collector);
+    REQUIRE(entries.size() == 2);
+    REQUIRE(entries[0].message == "before");
+    REQUIRE(entries[1].message == "after");
+    REQUIRE(collector.stats().abandoned == 1);
+}
+
+TEST_CASE("Shared memory ring abandons slot of stalled producer without blocking others")
+{
+    using namespace shm::impl;
+
+    TempRing ring;
+    shm::Options options;
+    options.slots         = 16;
+    options.abandon_after = std::chrono::milliseconds(20);
+    ShmLogger logger(ring.name, options);
+    ShmCollector collector({ ring.name }, options);
+
+    // Producer which reserved and claimed slot, and is stuck while alive
+    auto mapping = open_ring(ring.name, options);
+    auto header = static_cast<Header*>(mapping.get());
+    std::uint64_t ticket = header->head.fetch_add(1);
+    Slot* slot = slot_at(header, ticket);
+    slot->claim.store(claim_of(ticket, Owned));
+    slot->pid.store(static_cast<std::int32_t>(::getpid()));
+
+    logger.write(make_record(Severity::Info, "app"), [](std::ostream& ost) { ost << "after"; });
+    REQUIRE(drain_all(collector).empty());
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    auto entries = drain_all(collector);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].message == "after");
+    REQUIRE(collector.stats().abandoned == 1);
+
+    // Slot isn't reused while stalled producer may still write it; its next-lap record is dropped
+    for(int i = 0; i < 16; ++i)
+        logger.write(make_record(Severity::Info, "app"), [&](std::ostream& ost) { ost << i; });
+    REQUIRE(drain_all(collector).size() == 15);
+    REQUIRE(logger.stats().dropped == 1);
+    REQUIRE(collector.stats().abandoned == 2);
+
+    // Late commit fails, and slot is released for later tickets
+    std::uint64_t expected = ticket;
+    REQUIRE_FALSE(slot->seq.compare_exchange_strong(expected, ticket + 1));
+    slot->pid.store(0);
+    slot->claim.store(claim_of(ticket, Released));
+    for(int i = 0; i < 16; ++i)
+        logger.write(make_record(Severity::Info, "app"), [&](std::ostream& ost) { ost << i; });
+    REQUIRE(drain_all(collector).size() == 16);
+    REQUIRE(logger.stats().dropped == 1);
+}
+
+TEST_CASE("Shared memory ring is written by forked child")
+{
+    TempRing ring;
+    ShmLogger logger(ring.name);
+    ShmCollector collector({ ring.name });
+
+    pid_t child = ::fork();
+    if(child == 0)
+    {
+        logger.write(make_record(Severity::Error, "child"), [](std::ostream& ost) { ost << "from child"; });
+        ::_exit(0);
+    }
+    REQUIRE(child > 0);
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+
+    auto entries = drain_all(collector);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].message == "from child");
+    REQUIRE(entries[0].severity == Severity::Error);
+    REQUIRE(entries[0].pid == child);
+}
@@ -0,0 +1,127 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+#include <toolboxcpp/log/SocketLogger.hpp>
+
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace toolboxcpp::log;
+
+namespace
+{
+    struct SocketPair
+    {
+        SocketPair(int type)
+        {
+            int fds[2];
+            REQUIRE(::socketpair(AF_UNIX, type, 0, fds) == 0);
+            local.reset(fds[0]);
+            remote.reset(fds[1]);
+        }
+
+        std::string receive()
+        {
+            char buffer[4096];
+            auto size = ::recv(remote, buffer, sizeof(buffer), MSG_DONTWAIT);
+            return size > 0 ? std::string(buffer, static_cast<std::size_t>(size)) : std::string();
+        }
+
+        socket::FileDescriptor local;
+        socket::FileDescriptor remote;
+    };
+
+    void write_message(SocketLogger& logger, const char* message)
+    {
+        auto writer = [&](std::ostream& ost) { ost << message; };
+        logger.write(Record(), writer);
+    }
+}
+
+TEST_CASE("Socket logger sends records over stream socket")
+{
+    SocketPair pair(SOCK_STREAM);
+    SocketLogger logger(std::move(pair.local));
+
+    write_message(logger, "first");
+    write_message(logger, "second");
+    REQUIRE(logger.flush());
+
+    std::string received;
+    while(received.size() < 13)
+    {
+        auto chunk = pair.receive();
+        REQUIRE_FALSE(chunk.empty());
+        received += chunk;
+    }
+    CHECK(received == "first\nsecond\n");
+
+    auto stats = logger.stats();
+    CHECK(stats.sent_records    == 2);
+    CHECK(stats.dropped_records == 0);
+    CHECK(stats.pending_bytes   == 0);
+    CHECK(stats.connected);
+}
+
+TEST_CASE("Socket logger batches records into datagrams")
+{
+    SocketPair pair(SOCK_DGRAM);
+    SocketLogger logger(std::move(pair.local));
+
+    for(int i = 0; i < 10; ++i)
+        write_message(logger, "record");
+    REQUIRE(logger.flush());
+
+    std::string received;
+    for(auto chunk = pair.receive(); !chunk.empty(); chunk = pair.receive())
+        received += chunk;
+    CHECK(received.size() == 10 * 7);
+    CHECK(logger.stats().sent_records == 10);
+}
+
+TEST_CASE("Socket logger spills and drops while peer is down")
+{
+    socket::Options options;
+    options.buffer_limit        = 16;
+    options.reconnect_interval  = std::chrono::milliseconds(10);
+    SocketLogger logger([] { return socket::FileDescriptor(); }, options);
+
+    write_message(logger, "0123456");   // 8 bytes with newline, fits
+    write_message(logger, "0123456");   // 16 bytes total, still fits
+    write_message(logger, "0123456");   // overflows buffer
+
+    CHECK_FALSE(logger.flush(std::chrono::milliseconds(50)));
+    auto stats = logger.stats();
+    CHECK(stats.pending_bytes   == 16);
+    CHECK(stats.dropped_records == 1);
+    CHECK(stats.dropped_bytes   == 8);
+    CHECK(stats.sent_records    == 0);
+    CHECK_FALSE(stats.connected);
+}
+
+TEST_CASE("Socket logger reconnects after peer goes away")
+{
+    SocketPair first(SOCK_STREAM);
+    SocketPair second(SOCK_STREAM);
+
+    int attempt = 0;
+    socket::FileDescriptor* ends[] = { &first.local, &second.local };
+    socket::Options options;
+    options.reconnect_interval = std::chrono::milliseconds(10);
+    SocketLogger logger([&] { return attempt < 2 ? std::move(*ends[attempt++]) : socket::FileDescriptor(); }, options);
+
+    write_message(logger, "one");
+    REQUIRE(logger.flush());
+    CHECK(first.receive() == "one\n");
+
+    first.remote.reset(socket::FdCloser::zero());
+    // Peer loss is noticed on the next send, and reconnection happens after reconnect interval
+    write_message(logger, "two");
+    for(int i = 0; i < 100 && logger.stats().reconnects < 2; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(logger.stats().reconnects == 2);
+    REQUIRE(logger.flush());
+    CHECK(second.receive().find("two\n") != std::string::npos);
+}
@@ -0,0 +1,68 @@
+#pragma once
+/*
+    Helpers shared by unit tests of file and shared memory sinks
+*/
+#include <toolboxcpp/log/Logger.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+namespace test
+{
+    /// Name unique within test run, like `toolboxcpp_<kind>_<pid>_<n>`
+    inline std::string temp_name(std::string const& kind)
+    {
+        static int counter = 0;
+        return "toolboxcpp_" + kind + "_" + std::to_string(::getpid()) + "_" + std::to_string(counter++);
+    }
+
+    inline std::string read_file(std::string const& path)
+    {
+        std::ifstream file(path);
+        std::ostringstream ost;
+        ost << file.rdbuf();
+        return ost.str();
+    }
+    /// Path of temporary file, which is removed on destruction
+    struct TempFile
+    {
+        explicit TempFile(std::string const& kind)
+            : path("/tmp/" + temp_name(kind))
+        { }
+
+        ~TempFile()
+        {
+            std::remove(path.c_str());
+        }
+
+        TempFile(TempFile const&)            = delete;
+        TempFile& operator=(TempFile const&) = delete;
+
+        std::string read() const
+        {
+            return read_file(path);
+        }
+
+        std::string path;
+    };
+    /// Writes records with messages `line <from>` .. `line <to - 1>`
+    template<typename L>
+    void write_lines(L& logger, int from, int to)
+    {
+        toolboxcpp::log::Record record {};
+        for(int i = from; i < to; ++i)
+            logger.write(record, [&](std::ostream& ost) { ost << "line " << i; });
+    }
+    /// Text of records written by `write_lines`, one per line
+    inline std::string expected_lines(int from, int to)
+    {
+        std::string text;
+        for(int i = from; i < to; ++i)
+            text += "line " + std::to_string(i) + "\n";
+        return text;
+    }
+} // namespace test
@@ -0,0 +1,136 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+#include <toolboxcpp/log/UringLogger.hpp>
+
+#include "TestUtil.hpp"
+
+#include <sstream>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace toolboxcpp::log;
+using test::expected_lines;
+using test::write_lines;
+
+namespace
+{
+    // Probes whether kernel lets this process set io_uring up; it may be missing, or disabled by sysctl or seccomp
+    bool uring_supported()
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(::syscall(__NR_io_uring_setup, 1, &params));
+        if(fd < 0)
+            return false;
+        ::close(fd);
+        return true;
+    }
+
+    void check_sink(uring::Options options, bool uring)
+    {
+        test::TempFile file("uring");
+        options.buffer_size = 4096;
+        options.buffers     = 2;
+        options.truncate    = true;
+        {
+            UringLogger logger(file.path, options);
+            REQUIRE(logger.uses_uring() == uring);
+            write_lines(logger, 0, 5000);
+            logger.flush();
+            CHECK(file.read() == expected_lines(0, 5000));
+
+            auto stats = logger.stats();
+            CHECK(stats.written_bytes == expected_lines(0, 5000).size());
+            CHECK(stats.writes >= 2);
+            CHECK(stats.errors == 0);
+            // Tail goes out on destruction without explicit flush
+            write_lines(logger, 5000, 5010);
+        }
+        CHECK(file.read() == expected_lines(0, 5010));
+        // Reopened sink appends
+        {
+            options.truncate = false;
+            UringLogger logger(file.path, options);
+            write_lines(logger, 5010, 5020);
+        }
+        CHECK(file.read() == expected_lines(0, 5020));
+    }
+}
+
+TEST_CASE("Uring logger writes records in order")
+{
+    SECTION("io_uring")
+    {
+        if(!uring_supported())
+        {
+            WARN("io_uring isn't available, skipping");
+            return;
+        }
+        check_sink(uring::Options(), true);
+    }
+    SECTION("posix fallback")
+    {
+        uring::Options options;
+        options.force_posix = true;
+        check_sink(options, false);
+    }
+}
+
+TEST_CASE("Uring logger reports fallback")
+{
+    test::TempFile file("uring");
+    uring::Options options;
+    options.force_posix = true;
+    CHECK_FALSE(UringLogger(file.path, options).uses_uring());
+}
+
+TEST_CASE("Uring logger submits partial buffer after flush interval")
+{
+    test::TempFile file("uring");
+    uring::Options options;
+    options.flush_interval = std::chrono::milliseconds(10);
+    options.fsync_interval = std::chrono::milliseconds(0);
+    UringLogger logger(file.path, options);
+    write_lines(logger, 0, 3);
+    for(int i = 0; i < 200 && file.read().empty(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    CHECK(file.read() == expected_lines(0, 3));
+    CHECK(logger.stats().fsyncs == 0);
+}
+
+TEST_CASE("Uring logger keeps records whole under concurrent writers")
+{
+    test::TempFile file("uring");
+    uring::Options options;
+    options.buffer_size = 4096;
+    options.buffers     = 3;
+    options.truncate    = true;
+    {
+        UringLogger logger(file.path, options);
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t)
+            threads.emplace_back([&logger, t] { write_lines(logger, t * 10000, t * 10000 + 2000); });
+        for(auto& thread : threads)
+            thread.join();
+    }
+    std::istringstream text(file.read());
+    std::vector<int> last(4, -1);
+    std::string word;
+    int number = 0, count = 0;
+    while(text >> word >> number)
+    {
+        REQUIRE(word == "line");
+        int thread = number / 10000;
+        // Each writer's lines keep their order
+        CHECK(number > last[thread]);
+        last[thread] = number;
+        ++count;
+    }
+    CHECK(count == 8000);
+}
@@ -0,0 +1,422 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+#include <toolboxcpp/util/Executor.hpp>
+#include <toolboxcpp/util/FoldTuple.hpp>
+#include <toolboxcpp/util/Histogram.hpp>
+#include <toolboxcpp/util/Lz.hpp>
+#include <toolboxcpp/util/Resource.hpp>
+#include <toolboxcpp/util/ResourcePool.hpp>
+#include <toolboxcpp/util/Slab.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace toolboxcpp::util;
+
+namespace
+{
+    std::atomic<int> g_deleted { 0 };
+
+    struct CountingDeleter
+    {
+        void operator()(int) const { ++g_deleted; }
+    };
+}
+
+namespace
+{
+    struct Sum
+    {
+        template<typename T>
+        long operator()(long acc, T value) const { return acc + value; }
+    };
+    // Accumulator changes its type at every step
+    struct Nest
+    {
+        template<typename Acc, typename T>
+        std::pair<Acc, T> operator()(Acc acc, T value) const { return std::make_pair(acc, value); }
+    };
+
+    struct Print
+    {
+        template<typename T>
+        std::ostream& operator()(std::ostream& ost, T const& value) const { return ost << value << ';'; }
+    };
+}
+
+TEST_CASE("Fold over tuple")
+{
+    auto tuple = std::make_tuple(1, 2u, 3L, short(4));
+    static_assert(impl::FoldTraits<decltype(tuple)&, int, Sum&>::flat, "Same-type fold should be flat");
+    CHECK(fold_tuple(tuple, 0, Sum()) == 10);
+
+    std::ostringstream ost;
+    std::ostream& result = fold_tuple(std::make_tuple(1, "two", 3.5), ost, Print());
+    CHECK(&result == &ost);
+    CHECK(ost.str() == "1;two;3.5;");
+
+    using Nested = std::pair<std::pair<int, char>, std::string>;
+    static_assert(!impl::FoldTraits<std::tuple<char, std::string>, int, Nest>::flat, "Type-changing fold can't be flat");
+    Nested nested = fold_tuple(std::make_tuple('a', std::string("b")), 1, Nest());
+    CHECK(nested.first.first  == 1);
+    CHECK(nested.first.second == 'a');
+    CHECK(nested.second       == "b");
+
+    CHECK(fold_tuple(std::tuple<>(), 7, Sum()) == 7);
+}
+
+TEST_CASE("Iterate over tuple")
+{
+    std::vector<int> seen;
+    for_each_tuple(std::make_tuple(1, 2L, 3u), [&](long value) { seen.push_back(static_cast<int>(value)); });
+    CHECK(seen == std::vector<int>({ 1, 2, 3 }));
+
+    seen.clear();
+    auto check = [&](int value) { seen.push_back(value); return value < 3; };
+    CHECK_FALSE(all_of_tuple(std::make_tuple(1, 2, 3, 4), check));
+    // Checking stops at the first failure
+    CHECK(seen == std::vector<int>({ 1, 2, 3 }));
+
+    seen.clear();
+    CHECK(any_of_tuple(std::make_tuple(1, 2, 3, 4), [&](int value) { seen.push_back(value); return value == 2; }));
+    CHECK(seen == std::vector<int>({ 1, 2 }));
+
+    CHECK(all_of_tuple(std::tuple<>(), check));
+    CHECK_FALSE(any_of_tuple(std::tuple<>(), check));
+}
+
+TEST_CASE("Resource pool reuses returned handles")
+{
+    g_deleted = 0;
+    int next = 1;
+    auto make = [&] { return next++; };
+    {
+        ResourcePool<int, CountingDeleter> pool(2);
+
+        int first = 0;
+        {
+            auto lease = pool.acquire(make);
+            first = lease.get();
+            CHECK(first == 1);
+        }
+        CHECK(pool.size() == 1);
+        CHECK(g_deleted == 0);
+        {
+            auto again = pool.acquire(make);
+            CHECK(again.get() == first);
+            auto other = pool.acquire(make);
+            CHECK(other.get() == 2);
+            auto third = pool.acquire(make);
+            CHECK(third.get() == 3);
+        }
+        // Only two of three handles fit into pool
+        CHECK(pool.size() == 2);
+        CHECK(g_deleted == 1);
+
+        auto stats = pool.stats();
+        CHECK(stats.hits      == 1);
+        CHECK(stats.misses    == 3);
+        CHECK(stats.evictions == 1);
+        CHECK(stats.rejects   == 0);
+    }
+    // Pool deletes cached handles on destruction
+    CHECK(g_deleted == 3);
+}
+
+TEST_CASE("Resource pool reset hook rejects handles")
+{
+    g_deleted = 0;
+    auto odd_only = [](int& handle) { return handle % 2 == 1; };
+    ResourcePool<int, CountingDeleter, decltype(odd_only)> pool(4, CountingDeleter(), odd_only);
+
+    pool.release(2);
+    pool.release(3);
+    CHECK(pool.size() == 1);
+    CHECK(pool.stats().rejects == 1);
+    CHECK(g_deleted == 1);
+
+    CHECK(pool.try_acquire().detach() == 3);
+    CHECK(pool.try_acquire().empty());
+}
+
+TEST_CASE("Resource pool under concurrent use")
+{
+    g_deleted = 0;
+    std::atomic<int> next { 1 };
+    ResourcePool<int, CountingDeleter> pool(8);
+    {
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t)
+            threads.emplace_back([&] {
+                for(int i = 0; i < 10000; ++i)
+                    auto lease = pool.acquire([&] { return next++; });
+            });
+        for(auto& thread: threads)
+            thread.join();
+    }
+    auto stats = pool.stats();
+    CHECK(stats.hits + stats.misses == 40000);
+    // Every created handle is either cached or deleted
+    CHECK(static_cast<int>(pool.size()) + g_deleted == next - 1);
+}
+
+TEST_CASE("Resource pool size stays within capacity under contention")
+{
+    g_deleted = 0;
+    std::atomic<int> next { 1 };
+    std::atomic<bool> done { false };
+    std::atomic<int> overflows { 0 };
+    std::size_t max_size = 0;
+    ResourcePool<int, CountingDeleter> pool(1);
+    {
+        std::thread monitor([&] {
+            while(!done.load())
+                max_size = std::max(max_size, pool.size());
+        });
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 8; ++t)
+            threads.emplace_back([&, t] {
+                std::vector<ResourcePool<int, CountingDeleter>::Lease> held;
+                for(int i = 0; i < 20000; ++i)
+                {
+                    // Threads hold varying number of leases, so pool keeps crossing its capacity
+                    if(held.size() < static_cast<std::size_t>(1 + (i + t) % 3))
+                        held.push_back(pool.acquire([&] { return next++; }));
+                    else
+                        held.clear();
+                    if(pool.size() > pool.capacity())
+                        ++overflows;
+                }
+            });
+        for(auto& thread: threads)
+            thread.join();
+        done = true;
+        monitor.join();
+    }
+    CHECK(max_size <= pool.capacity());
+    CHECK(overflows == 0);
+    // Counter matches handles actually cached
+    std::size_t cached = 0;
+    std::vector<ResourcePool<int, CountingDeleter>::Lease> taken;
+    while(true)
+    {
+        auto lease = pool.try_acquire();
+        if(lease.empty())
+            break;
+        taken.push_back(std::move(lease));
+        ++cached;
+    }
+    CHECK(pool.size() == 0);
+    CHECK(cached <= pool.capacity());
+    CHECK(static_cast<int>(cached) + g_deleted == next - 1);
+}
+
+namespace
+{
+    // Waits till condition holds, for at most a few seconds
+    template<typename Pred>
+    bool wait_for(Pred pred)
+    {
+        for(int i = 0; i < 5000 && !pred(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return pred();
+    }
+}
+
+TEST_CASE("Task stores functors inline")
+{
+    int calls = 0;
+    auto increment = [&] { ++calls; };
+    FuncRef<void()> ref(increment);
+
+    Task task(ref);
+    Task moved(std::move(task));
+    CHECK_FALSE(task);
+    REQUIRE(moved);
+    moved();
+    CHECK(calls == 1);
+
+    moved = Task([&calls] { calls += 10; });
+    moved();
+    CHECK(calls == 11);
+}
+
+TEST_CASE("Executor runs submitted and nested tasks")
+{
+    std::atomic<int> done { 0 };
+    {
+        executor::Options options;
+        options.threads  = 3;
+        options.affinity = { 0 };
+        Executor executor(options);
+        CHECK(executor.threads() == 3);
+
+        Executor* exec = &executor;
+        std::atomic<int>* counter = &done;
+        for(int i = 0; i < 100; ++i)
+            executor.submit([exec, counter] {
+                // Tasks submitted from worker go to its own deque and may be stolen by others
+                for(int j = 0; j < 10; ++j)
+                    exec->submit([counter] { ++*counter; });
+                ++*counter;
+            });
+        CHECK(wait_for([&] { return done == 1100; }));
+        // Destruction runs everything queued so far
+        for(int i = 0; i < 100; ++i)
+            executor.submit([counter] { ++*counter; });
+    }
+    CHECK(done == 1200);
+}
+
+TEST_CASE("Executor timers")
+{
+    Executor executor;
+    std::atomic<int> once { 0 };
+    std::atomic<int> ticks { 0 };
+    std::atomic<int>* once_ptr  = &once;
+    std::atomic<int>* ticks_ptr = &ticks;
+
+    executor.schedule_after(std::chrono::milliseconds(5), [once_ptr] { ++*once_ptr; });
+    auto timer = executor.schedule_every(std::chrono::milliseconds(1), [ticks_ptr] { ++*ticks_ptr; });
+
+    CHECK(wait_for([&] { return once == 1 && ticks >= 5; }));
+    executor.cancel(timer);
+    int stopped = ticks;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(ticks == stopped);
+    CHECK(once == 1);
+    // Cancelling finished timer is harmless
+    executor.cancel(timer);
+}
+
+TEST_CASE("Slab blocks are reused and bounded")
+{
+    // Separate thread, so exhausting its budget doesn't affect other tests
+    std::thread([] {
+        std::vector<slab::Block*> blocks;
+        while(slab::Block* block = slab::allocate())
+            blocks.push_back(block);
+        CHECK(blocks.size() == slab::MaxChunks * slab::ChunkBlocks);
+        CHECK(slab::reserved() == slab::MaxChunks * slab::ChunkBlocks * slab::BlockSize);
+
+        // Half of blocks are freed by another thread and come back through remote-free stack
+        std::thread([&] {
+            for(std::size_t i = 0; i < blocks.size(); i += 2)
+                slab::free(blocks[i]);
+        }).join();
+        for(std::size_t i = 1; i < blocks.size(); i += 2)
+            slab::free(blocks[i]);
+
+        std::set<slab::Block*> original(blocks.begin(), blocks.end());
+        std::size_t reused = 0;
+        while(slab::Block* block = slab::allocate())
+        {
+            reused += original.count(block);
+            blocks.push_back(block);
+        }
+        CHECK(reused == original.size());
+        CHECK(slab::reserved() == slab::MaxChunks * slab::ChunkBlocks * slab::BlockSize);
+        for(std::size_t i = original.size(); i < blocks.size(); ++i)
+            slab::free(blocks[i]);
+    }).join();
+}
+
+TEST_CASE("Slab stream buffer chains blocks")
+{
+    std::string text;
+    for(int i = 0; text.size() < 3 * slab::BlockCapacity; ++i)
+        text += std::to_string(i) + ' ';
+
+    SlabStreamBuf buffer;
+    std::ostream ost(&buffer);
+    ost << text << '!';
+    CHECK(buffer.size() == text.size() + 1);
+
+    std::size_t blocks = 0;
+    for(auto block = buffer.blocks(); block; block = block->next)
+        ++blocks;
+    CHECK(blocks == 4);
+
+    std::ostringstream copy;
+    buffer.write_to(copy);
+    CHECK(copy.str() == text + '!');
+}
+
+
+TEST_CASE("LZ codec round-trips data")
+{
+    std::string repetitive;
+    for(int i = 0; i < 2000; ++i)
+        repetitive += "record " + std::to_string(i % 37) + " of channel net\n";
+    std::string noise;
+    std::uint32_t seed = 12345;
+    for(int i = 0; i < 5000; ++i)
+        noise.push_back(static_cast<char>((seed = seed * 1103515245 + 12345) >> 24));
+
+    for(auto& input : { std::string(), std::string("abc"), std::string(1000, 'a'), repetitive, noise })
+    {
+        std::string packed;
+        lz::compress(input.data(), input.size(), packed);
+        CHECK(packed.size() <= lz::max_compressed_size(input.size()));
+        std::string unpacked(input.size(), '\0');
+        REQUIRE(lz::decompress(packed.data(), packed.size(), &unpacked[0], unpacked.size()));
+        CHECK(unpacked == input);
+    }
+
+    std::string packed;
+    lz::compress(repetitive.data(), repetitive.size(), packed);
+    CHECK(packed.size() < repetitive.size() / 4);
+}
+
+TEST_CASE("LZ codec rejects damaged blocks")
+{
+    std::string input(500, 'x');
+    input += "tail";
+    std::string packed;
+    lz::compress(input.data(), input.size(), packed);
+    std::string out(input.size(), '\0');
+    // Wrong expected size, truncated block, offset reaching before output start
+    CHECK_FALSE(lz::decompress(packed.data(), packed.size(), &out[0], out.size() - 1));
+    CHECK_FALSE(lz::decompress(packed.data(), packed.size() - 3, &out[0], out.size()));
+    std::string bad("\x04\xFF\xFF", 3);
+    CHECK_FALSE(lz::decompress(bad.data(), bad.size(), &out[0], out.size()));
+}
+
+TEST_CASE("Histogram buckets and percentiles")
+{
+    for(std::uint64_t value : { 0ull, 1ull, 31ull, 32ull, 33ull, 1000ull, 123456789ull, ~0ull })
+    {
+        auto bucket = Histogram::bucket_of(value);
+        REQUIRE(bucket < Histogram::Buckets);
+        CHECK(Histogram::bucket_low(bucket) <= value);
+        CHECK(Histogram::bucket_high(bucket) >= value);
+        // Relative error stays within 1/16
+        CHECK(Histogram::bucket_high(bucket) - Histogram::bucket_low(bucket) <= value / 16);
+    }
+    CHECK(Histogram::bucket_of(~0ull) == Histogram::Buckets - 1);
+
+    Histogram histogram;
+    CHECK(histogram.percentile(0.5) == 0);
+    for(std::uint64_t i = 1; i <= 1000; ++i)
+        histogram.add(i);
+    CHECK(histogram.count() == 1000);
+    CHECK(histogram.sum() == 500500);
+    CHECK(histogram.min() == 1);
+    CHECK(histogram.max() >= 1000);
+    CHECK(histogram.percentile(0.5)  == Approx(500).epsilon(1.0 / 16));
+    CHECK(histogram.percentile(0.99) == Approx(990).epsilon(1.0 / 16));
+
+    Histogram other;
+    other.add(5000, 10);
+    histogram.merge(other);
+    CHECK(histogram.count() == 1010);
+    CHECK(histogram.percentile(1.0) == Approx(5000).epsilon(1.0 / 16));
+}
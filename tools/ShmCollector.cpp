@@ -0,0 +1,81 @@
+/** Collector process for shared-memory log rings
+ *
+ *  Drains every ring listed on command line into single output file, one line per record:
+ *  `<nanoseconds since epoch> <SEVERITY> [<pid>] <channel>: <message>`.
+ *  Runs until interrupted with SIGINT or SIGTERM, then drains once more and exits.
+ */
+#include <toolboxcpp/log/ShmLogger.hpp>
+
+#include <chrono>
+#include <csignal>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace toolboxcpp;
+
+    volatile std::sig_atomic_t g_stop = 0;
+
+    void on_signal(int)
+    {
+        g_stop = 1;
+    }
+
+    void write_entry(std::ostream& ost, log::shm::Entry const& entry)
+    {
+        ost << std::chrono::duration_cast<std::chrono::nanoseconds>(entry.timestamp.time_since_epoch()).count()
+            << ' ' << log::severity_name(entry.severity)
+            << " [" << entry.pid << "] "
+            << (entry.channel.empty() ? "-" : entry.channel) << ": "
+            << entry.message
+            << (entry.truncated ? "..." : "") << '\n';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <output file> <ring name>...\n";
+        return 2;
+    }
+
+    try
+    {
+        std::ofstream output(argv[1], std::ios::out | std::ios::app);
+        if(!output)
+        {
+            std::cerr << "Can't open " << argv[1] << '\n';
+            return 1;
+        }
+        log::ShmCollector collector(std::vector<std::string>(argv + 2, argv + argc));
+
+        std::signal(SIGINT,  &on_signal);
+        std::signal(SIGTERM, &on_signal);
+
+        auto consume = [&](log::shm::Entry const& entry) { write_entry(output, entry); };
+        while(!g_stop)
+        {
+            if(collector.drain(consume))
+                output.flush();
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        collector.drain(consume);
+        output.flush();
+
+        auto stats = collector.stats();
+        std::cerr << "Collected " << stats.collected << ", abandoned " << stats.abandoned
+                  << ", dropped by producers " << stats.dropped << '\n';
+    }
+    catch(std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}